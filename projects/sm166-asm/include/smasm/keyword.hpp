@@ -179,7 +179,10 @@ namespace smasm
     int param_one = 0;
     int param_two = 0;
 
-    static const keyword& lookup (const std::string& name);
+    // No keyword's name is longer than this, so longer names need not be looked up.
+    static constexpr std::size_t max_name_length = 16;
+
+    static const keyword& lookup (std::string_view name);
     const char* get_string_type () const;
   };
 
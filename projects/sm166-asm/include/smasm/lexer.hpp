@@ -39,23 +39,34 @@ namespace smasm
     }
 
   private:
-    int collect_identifier (std::int32_t& character);
-    int collect_string (std::int32_t& character);
-    int collect_integer (std::int32_t& character);
-    int collect_hexadecimal (std::int32_t& character);
-    int collect_binary (std::int32_t& character);
-    int collect_octal (std::int32_t& character);
-    int collect_symbol (std::int32_t& character);
+    int collect_identifier (const char* start);
+    int collect_string (const char* start);
+    int collect_integer (const char* start);
+    int collect_hexadecimal (const char* start);
+    int collect_binary (const char* start);
+    int collect_octal (const char* start);
+    int collect_symbol (const char* start);
     int collect_token ();
+    bool collect_character (char expected);
+    void emplace_token (token_type type, std::string_view contents);
 
   private:
-    std::fstream m_file;
     std::vector<token> m_tokens;
+    std::vector<token> m_file_tokens;
     std::vector<fs::path> m_paths;
     fs::path m_current_path = "";
     fs::path m_parent_path = "";
+
+    // The paths of all files lexed so far. Tokens refer to these, so they are never cleared.
+    std::unordered_set<std::string> m_source_files;
+    std::string_view m_current_file = "";
     std::size_t m_current_line = 0;
-    std::size_t m_write_ptr = 0;
+
+    // The source file being lexed, read into memory whole, and the position of the next character
+    // to be lexed in it.
+    std::string m_source = "";
+    const char* m_cursor = nullptr;
+    const char* m_end = nullptr;
 
   };
 
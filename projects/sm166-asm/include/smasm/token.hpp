@@ -67,7 +67,7 @@ namespace smasm
 
   struct token
   {
-    std::string     source_file = "";
+    std::string_view source_file = "";
     std::size_t     source_line = 0;
     token_type      type = token_type::unknown;
     std::string     contents = "";
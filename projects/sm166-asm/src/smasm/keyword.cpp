@@ -5,7 +5,19 @@
 namespace smasm
 {
 
-  static const std::unordered_map<std::string, keyword> keyword_lookup = {
+  // Hashes keyword names as string views, so that they can be looked up without first being
+  // copied into strings.
+  struct keyword_hash
+  {
+    using is_transparent = void;
+    std::size_t operator() (std::string_view name) const
+    {
+      return std::hash<std::string_view>{}(name);
+    }
+  };
+
+  static const std::unordered_map<std::string, keyword, keyword_hash, std::equal_to<>>
+    keyword_lookup = {
     { "", { keyword_type::none } },
 
     // Language Syntax
@@ -165,10 +177,13 @@ namespace smasm
     { "rrca", { keyword_type::instruction, instruction_type::it_rrca } }
   };
 
-  const keyword& keyword::lookup (const std::string& name)
+  const keyword& keyword::lookup (std::string_view name)
   {
+    static const keyword& none = keyword_lookup.at("");
+    if (name.size() > keyword::max_name_length) { return none; }
+
     auto it = keyword_lookup.find(name);
-    return (it != keyword_lookup.end()) ? it->second : keyword_lookup.at("");
+    return (it != keyword_lookup.end()) ? it->second : none;
   }
 
   const char* keyword::get_string_type () const
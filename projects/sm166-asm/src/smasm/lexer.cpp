@@ -33,36 +33,66 @@ namespace smasm
       m_paths.push_back(absolute);
     }
     
-    m_file.open(absolute, std::ios::in);
-    if (m_file.is_open() == false) {
+    // Read the whole file into memory at once, then lex it from there.
+    std::ifstream file { absolute, std::ios::in | std::ios::binary };
+    if (file.is_open() == false) {
       std::cerr <<  "[lexer] "
                 <<  "Could not open source file '" << absolute << "' for reading." << std::endl;
       return false;
     }
 
+    std::error_code error;
+    std::uintmax_t size = fs::file_size(absolute, error);
+    if (error) {
+      std::cerr <<  "[lexer] "
+                <<  "Could not get the size of source file '" << absolute << "': "
+                <<  error.message() << std::endl;
+      return false;
+    }
+
+    m_source.resize(size);
+    if (file.read(m_source.data(), m_source.size()).good() == false) {
+      std::cerr <<  "[lexer] "
+                <<  "Could not read source file '" << absolute << "'." << std::endl;
+      return false;
+    }
+
+    file.close();
+
     m_current_path = absolute;
+    m_current_file = *m_source_files.insert(absolute.string()).first;
     m_current_line = 1;
-    m_write_ptr = 0;
+    m_cursor = m_source.data();
+    m_end = m_source.data() + m_source.size();
 
     if (m_parent_path.empty() == true)
     {
       m_parent_path = m_current_path.parent_path();
     }
 
-    while (true) {
-      auto result = collect_token();
+    // The file's tokens are collected on their own, then placed ahead of any tokens still left
+    // over from the file which included it.
+    m_file_tokens.clear();
+    int result = 1;
+    while (result == 1) {
+      result = collect_token();
       if (result == -1) {
         std::cerr <<  "[lexer] "
                   <<  "  In source file '" << absolute << "':" << m_current_line << "."
                   <<  std::endl;
-        m_file.close();
-        return false;
-      } else if (result == 0) {
-        m_file.close();
-        return true;
       }
     }
 
+    if (m_tokens.empty() == true) {
+      m_tokens.swap(m_file_tokens);
+    } else {
+      m_tokens.insert(m_tokens.begin(), std::make_move_iterator(m_file_tokens.begin()),
+        std::make_move_iterator(m_file_tokens.end()));
+    }
+
+    m_file_tokens.clear();
+    return result == 0;
+
   }
 
   bool lexer::has_more_tokens () const
@@ -114,106 +144,130 @@ namespace smasm
     m_paths.clear();
   }
 
-  #define smasm_emplace(type, contents) \
-    m_tokens.emplace(m_tokens.begin() + m_write_ptr, m_current_path, m_current_line, type, \
-      contents); m_write_ptr++;
+  static inline bool is_identifier_character (char character)
+  {
+    return std::isalnum((unsigned char) character) || character == '_' || character == '#';
+  }
 
-  int lexer::collect_identifier (std::int32_t& character)
+  bool lexer::collect_character (char expected)
   {
-    // Keep a string to hold the contents of the token.
-    // Also, keep a lowercase version of the token's contents in this case.
-    std::string contents = "", lowercase = "";
-
-    // Collect tokens until a non-alphanumeric, non-underscore character is encountered.
-    do {
-      contents  += static_cast<char>(character);
-      lowercase += static_cast<char>(std::tolower((unsigned char) character));
-      character = m_file.get();
-    } while (std::isalnum(character) || character == '_' || character == '#');
-
-    // Look up the token's lowercase contents to see if this is a reserved keyword and what kind of
-    // keyword that may be. Emplace the appropriate identifier token.
-    const auto& kw = keyword::lookup(lowercase);
-    switch (kw.type) {
-      case keyword_type::language:
-      case keyword_type::directive:
-      case keyword_type::section:
-      case keyword_type::condition:
-      case keyword_type::vector:
-      case keyword_type::cpu_register:
-      case keyword_type::instruction:
-        smasm_emplace(token_type::identifier, lowercase);
-        break;
-      default:
-        smasm_emplace(token_type::identifier, contents);
-        break;
+    if (m_cursor != m_end && *m_cursor == expected) {
+      m_cursor++;
+      return true;
     }
 
-    // Roll the file stream back one character before returning.
-    m_file.unget();
+    return false;
+  }
+
+  void lexer::emplace_token (token_type type, std::string_view contents)
+  {
+    m_file_tokens.emplace_back(m_current_file, m_current_line, type, std::string { contents });
+  }
+
+  int lexer::collect_identifier (const char* start)
+  {
+    // Collect characters until a non-alphanumeric, non-underscore character is encountered.
+    while (m_cursor != m_end && is_identifier_character(*m_cursor)) {
+      m_cursor++;
+    }
+
+    std::string_view contents { start, static_cast<std::size_t>(m_cursor - start) };
+
+    // Only identifiers short enough to be reserved keywords need to be looked up, in lowercase, to
+    // see if they are keywords, and what kind of keyword they may be. Keywords are emplaced in
+    // lowercase; everything else is emplaced as it was written.
+    if (contents.size() <= keyword::max_name_length) {
+      char lowercase[keyword::max_name_length];
+      for (std::size_t i = 0; i < contents.size(); ++i) {
+        lowercase[i] = static_cast<char>(std::tolower((unsigned char) contents[i]));
+      }
+
+      std::string_view folded { lowercase, contents.size() };
+      switch (keyword::lookup(folded).type) {
+        case keyword_type::language:
+        case keyword_type::directive:
+        case keyword_type::section:
+        case keyword_type::condition:
+        case keyword_type::vector:
+        case keyword_type::cpu_register:
+        case keyword_type::instruction:
+          emplace_token(token_type::identifier, folded);
+          return 1;
+        default:
+          break;
+      }
+    }
+
+    emplace_token(token_type::identifier, contents);
     return 1;
 
   }
 
-  int lexer::collect_string (std::int32_t& character)
+  int lexer::collect_string (const char* start)
   {
 
-    // Keep a string to hold the token's contents.
+    // Keep a string to hold the token's contents. Runs of characters between escape sequences are
+    // appended to it whole.
     std::string contents = "";
-    bool escaping = false;
-
-    // Advance the file stream past the opening quotes.
-    std::int32_t matching_quotes = character;
-    character = m_file.get();
+    const char matching_quotes = *start;
+    const char* run = m_cursor;
 
     // Collect characters until the closing matching quote is encountered.
-    while (character != matching_quotes || escaping == true) {
-      if (escaping == true) {
-        switch (character)
-        {
-          case 't':  contents += '\t'; break;
-          case 'r':  contents += '\r'; break;
-          case 'n':  contents += '\n'; break;
-          case '\\': contents += '\\'; break;
-          case '\'': contents += '\''; break;
-          case '\"': contents += '\"'; break;
-          default: break;
-        }
+    while (true) {
+      if (m_cursor == m_end) {
+        std::cerr << "[lexer] Unexpected end of file reached while collecting string."
+                  << std::endl;
+        return -1;
+      }
 
-        escaping = false;
-      } else {
-        if (character == '\\') {
-          escaping = true;
-        } else {
-          contents += static_cast<char>(character);
-        }
+      if (*m_cursor == matching_quotes) {
+        contents.append(run, m_cursor);
+        m_cursor++;
+        break;
+      }
+
+      if (*m_cursor != '\\') {
+        m_cursor++;
+        continue;
       }
-      character =   m_file.get();
 
-      if (character == std::char_traits<char>::eof()) {
+      contents.append(run, m_cursor);
+      if (++m_cursor == m_end) {
         std::cerr << "[lexer] Unexpected end of file reached while collecting string."
                   << std::endl;
         return -1;
       }
+
+      switch (*m_cursor)
+      {
+        case 't':  contents += '\t'; break;
+        case 'r':  contents += '\r'; break;
+        case 'n':  contents += '\n'; break;
+        case '\\': contents += '\\'; break;
+        case '\'': contents += '\''; break;
+        case '\"': contents += '\"'; break;
+        default: break;
+      }
+
+      run = ++m_cursor;
     }
 
     // Emplace the string.
-    smasm_emplace(token_type::string, contents);
+    emplace_token(token_type::string, contents);
     return 1;
 
   }
 
-  int lexer::collect_integer (std::int32_t& character)
+  int lexer::collect_integer (const char* start)
   {
 
-    // Keep a string to hold the token's contents. Also, keep a boolean flag to indicate whether or
-    // not this is an integer or a floating-point number being collected.
-    std::string contents = "";
-    bool        is_float = false;
-    bool        has_precision = false;
+    // Keep a boolean flag to indicate whether or not this is an integer or a floating-point number
+    // being collected.
+    bool is_float = false;
+    bool has_precision = false;
 
     // Collect characters until a non-numeric-character or a second period is encountered.
-    do {
+    while (m_cursor != m_end) {
 
       // If a period is encountered, then we know that we are collecting a number token, rather than
       // an integer token.
@@ -223,159 +277,125 @@ namespace smasm
       //
       // If a second one if either is encountered while collecting the same token, then we can assume at
       // that point that we have finished collecting this token.
-      if (character == '.') 
-      {
+      if (*m_cursor == '.') {
         if (is_float == true) { break; }
-        else 
-        { 
-          is_float = true; 
-          if (contents == "")
-          {
-            contents += "0";
-          }
-        }
-      }
-      else if (character == 'q')
-      {
+        is_float = true;
+      } else if (*m_cursor == 'q') {
         if (has_precision == true) { break; }
-        else
-        {
-          is_float = true;
-          has_precision = true;
-          if (contents == "")
-          {
-            contents += "0";
-          }
-        }
+        is_float = true;
+        has_precision = true;
+      } else if (std::isdigit((unsigned char) *m_cursor) == 0) {
+        break;
       }
 
-      contents  +=  static_cast<char>(character);
-      character =   m_file.get();
+      m_cursor++;
 
-    } while (std::isdigit(character) || character == '.' || character == 'q');
+    }
 
     // Emplace an integer or a floating-point numeric token.
-    smasm_emplace(is_float == true ? token_type::number : token_type::integer, contents);
-
-    m_file.unget();
+    emplace_token(is_float == true ? token_type::number : token_type::integer,
+      { start, static_cast<std::size_t>(m_cursor - start) });
     return 1;
 
   }
 
-  int lexer::collect_hexadecimal (std::int32_t& character)
+  int lexer::collect_hexadecimal (const char*)
   {
-    std::string contents = "";
-    character = m_file.get();
+    const char* digits = m_cursor;
+    while (m_cursor != m_end && std::isxdigit((unsigned char) *m_cursor)) {
+      m_cursor++;
+    }
 
-    while (std::isxdigit(character)) {
-      contents  += static_cast<char>(character);
-      character  = m_file.get();
+    if (m_cursor == digits) { emplace_token(token_type::dollar, "$"); }
+    else {
+      emplace_token(token_type::hexadecimal,
+        { digits, static_cast<std::size_t>(m_cursor - digits) });
     }
 
-    m_file.unget();
-    if (contents == "") { smasm_emplace(token_type::dollar, "$"); }
-    else { smasm_emplace(token_type::hexadecimal, contents); }
-    
     return 1;
   }
 
-  int lexer::collect_binary (std::int32_t& character)
+  int lexer::collect_binary (const char*)
   {
-    std::string contents = "";
-    character = m_file.get();
+    const char* digits = m_cursor;
+    while (m_cursor != m_end && (*m_cursor == '0' || *m_cursor == '1')) {
+      m_cursor++;
+    }
 
-    while (character == '0' || character == '1') {
-      contents  += static_cast<char>(character);
-      character  = m_file.get();
+    if (m_cursor == digits) { emplace_token(token_type::percent, "%"); }
+    else {
+      emplace_token(token_type::binary,
+        { digits, static_cast<std::size_t>(m_cursor - digits) });
     }
 
-    m_file.unget();
-    if (contents == "") { smasm_emplace(token_type::percent, "%"); }
-    else { smasm_emplace(token_type::binary, contents); }
-    
     return 1;
   }
 
-  int lexer::collect_octal (std::int32_t& character)
+  int lexer::collect_octal (const char*)
   {
 
-    std::string contents = "";
-    character = m_file.get();
-
-    while (character >= '0' && character <= '7') {
-      contents  += static_cast<char>(character);
-      character  = m_file.get();
+    const char* digits = m_cursor;
+    while (m_cursor != m_end && *m_cursor >= '0' && *m_cursor <= '7') {
+      m_cursor++;
     }
 
-    m_file.unget();
-    if (contents == "") { 
-      std::int32_t next_character = m_file.get();
-      if (next_character == '&') {
-        smasm_emplace(token_type::double_ampersand, "&&");
+    if (m_cursor == digits) {
+      if (collect_character('&') == true) {
+        emplace_token(token_type::double_ampersand, "&&");
       } else {
-        m_file.unget();
-        smasm_emplace(token_type::ampersand, "&"); 
+        emplace_token(token_type::ampersand, "&");
       }
     }
-    else { smasm_emplace(token_type::octal, contents); }
-    
+    else {
+      emplace_token(token_type::octal,
+        { digits, static_cast<std::size_t>(m_cursor - digits) });
+    }
+
     return 1;
 
   }
 
-  int lexer::collect_symbol (std::int32_t& character)
+  int lexer::collect_symbol (const char* start)
   {
     // Keep track of the type of the symbol token being collected.
     token_type type = token_type::unknown;
 
     // Based on the current character, determine which symbol token is being collected.
-    switch (character)
+    switch (*start)
     {
       case '`':  type =    token_type::backtick; break;
       case '?':  type =    token_type::question; break;
-      case '!': {
-        std::int32_t next_character = m_file.get();
-        if (next_character == '=') {
-          smasm_emplace(token_type::not_equals, "!=");
-          return 1;
+      case '!':
+        if (collect_character('=') == true) {
+          emplace_token(token_type::not_equals, "!=");
         } else {
-          m_file.unget();
-          smasm_emplace(token_type::exclaim, "!");
-          return 1;
+          emplace_token(token_type::exclaim, "!");
         }
-      } break;
+        return 1;
       case '.':  type =    token_type::period; break;
       case ',':  type =    token_type::comma; break;
       case ':':  type =    token_type::colon; break;
       case '@':  type =    token_type::at; break;
       case '#':  type =    token_type::pound; break;
       case '^':  type =    token_type::carat; break;
-      case '|': {
-        std::int32_t next_character = m_file.get();
-        if (next_character == '|') {
-          smasm_emplace(token_type::double_pipe, "||");
-          return 1;
+      case '|':
+        if (collect_character('|') == true) {
+          emplace_token(token_type::double_pipe, "||");
         } else {
-          m_file.unget();
-          smasm_emplace(token_type::pipe, "|"); 
-          return 1;
+          emplace_token(token_type::pipe, "|");
         }
-      } break;
+        return 1;
       case '~':  type =    token_type::tilde; break;
       case '*':  type =    token_type::asterisk; break;
       case '+':  type =    token_type::plus; break;
       case '-':  type =    token_type::minus; break;
-      case '=': {
-        std::int32_t next_character = m_file.get();
-        if (next_character == '=') {
-          smasm_emplace(token_type::double_equals, "==");
-          return 1;
+      case '=':
+        if (collect_character('=') == true) {
+          emplace_token(token_type::double_equals, "==");
         } else {
-          m_file.unget();
-          smasm_emplace(token_type::equals, "=");
-          return 1;
+          emplace_token(token_type::equals, "=");
         }
-      } break;
+        return 1;
       case '/':  type =    token_type::slash; break;
       case '\\': type =    token_type::backslash; break;
       case '(':  type =    token_type::open_paren; break;
@@ -384,104 +404,85 @@ namespace smasm
       case ']':  type =    token_type::close_bracket; break;
       case '{':  type =    token_type::open_brace; break;
       case '}':  type =    token_type::close_brace; break;
-      case '<': {
-        std::int32_t next_character = m_file.get();
-        if (next_character == '=') {
-          smasm_emplace(token_type::less_equals, "<=");
-          return 1;
-        } else if (next_character == '<') {
-          smasm_emplace(token_type::left_shift, "<<");
-          return 1;
+      case '<':
+        if (collect_character('=') == true) {
+          emplace_token(token_type::less_equals, "<=");
+        } else if (collect_character('<') == true) {
+          emplace_token(token_type::left_shift, "<<");
         } else {
-          m_file.unget();
-          smasm_emplace(token_type::open_arrow, "<");
-          return 1;
+          emplace_token(token_type::open_arrow, "<");
         }
-      } break;
-      case '>': {
-        std::int32_t next_character = m_file.get();
-        if (next_character == '=') {
-          smasm_emplace(token_type::greater_equals, ">=");
-          return 1;
-        } else if (next_character == '>') {
-          smasm_emplace(token_type::right_shift, ">>");
-          return 1;
+        return 1;
+      case '>':
+        if (collect_character('=') == true) {
+          emplace_token(token_type::greater_equals, ">=");
+        } else if (collect_character('>') == true) {
+          emplace_token(token_type::right_shift, ">>");
         } else {
-          m_file.unget();
-          smasm_emplace(token_type::close_arrow, ">");
-          return 1;
+          emplace_token(token_type::close_arrow, ">");
         }
-      } break;
+        return 1;
       default:
         std::cerr << "[lexer] "
-                  << "Unexpected character '" << static_cast<char>(character) << "'."
+                  << "Unexpected character '" << *start << "'."
                   << std::endl;
         return -1;
     }
 
     // Emplace the deduced token.
-    smasm_emplace(type, std::string { (char) character });
+    emplace_token(type, { start, 1 });
     return 1;
   }
 
   int lexer::collect_token ()
   {
 
-    // Retrieve the next character in the file stream. It needs to be an `std::int32_t` because the
-    // end-of-file marker (`EOF`) needs to fit in here, too.
-    std::int32_t character = m_file.get();
-
     // If a whitespace character (like a space ' ' or a newline '\n') is encountered, then skip over
     // it and get the next character. Repeat this until a non-whitespace character is encountered.
-    while (std::isspace(character)) 
+    while (m_cursor != m_end && std::isspace((unsigned char) *m_cursor))
     {
       // If that whitespace character is, in fact, the newline character, then also increment the
       // line counter.
-      if (character == '\n') { 
+      if (*m_cursor++ == '\n') {
         m_current_line++;
         return 1;
       }
-
-      character = m_file.get();
     }
 
     // If the character encountered is a semicolon ';', then this is the start of a comment.
-    // Ignore all characters from that point until the end o fthe current line.
-    if (character == ';') {
-      while (character != '\n' && character != std::char_traits<char>::eof()) {
-        character = m_file.get();
-      }
-
-      if (character == '\n') {
+    // Ignore all characters from that point until the end of the current line.
+    if (m_cursor != m_end && *m_cursor == ';') {
+      const void* newline = std::memchr(m_cursor, '\n', m_end - m_cursor);
+      if (newline == nullptr) {
+        m_cursor = m_end;
+      } else {
+        m_cursor = static_cast<const char*>(newline) + 1;
         m_current_line++;
         return 1;
-      } else if (character == std::char_traits<char>::eof()) {
-        smasm_emplace(token_type::end_of_file, "");
-        return 0;
       }
     }
 
-    // Next, check for the end-of-file marker (`EOF`). In C++, there is a character traits
-    // specialization for this marker.
-    if (character == std::char_traits<char>::eof()) {
-      smasm_emplace(token_type::end_of_file, "");
+    // Next, check for the end of the file.
+    if (m_cursor == m_end) {
+      emplace_token(token_type::end_of_file, "");
       return 0;
     }
 
-    if (std::isalpha(character) || character == '_') {
-      return collect_identifier(character);
-    } else if (character == '"') {
-      return collect_string(character);
-    } else if (std::isdigit(character)) {
-      return collect_integer(character);
-    } else if (character == '$') {
-      return collect_hexadecimal(character);
-    } else if (character == '%') {
-      return collect_binary(character);
-    } else if (character == '&') {
-      return collect_octal(character);
+    const char* start = m_cursor++;
+    if (std::isalpha((unsigned char) *start) || *start == '_') {
+      return collect_identifier(start);
+    } else if (*start == '"') {
+      return collect_string(start);
+    } else if (std::isdigit((unsigned char) *start)) {
+      return collect_integer(start);
+    } else if (*start == '$') {
+      return collect_hexadecimal(start);
+    } else if (*start == '%') {
+      return collect_binary(start);
+    } else if (*start == '&') {
+      return collect_octal(start);
     } else  {
-      return collect_symbol(character);
+      return collect_symbol(start);
     }
 
   }
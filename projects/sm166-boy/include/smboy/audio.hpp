@@ -3,6 +3,7 @@
 #pragma once
 
 #include <smboy/common.hpp>
+#include <smboy/blip_buffer.hpp>
 
 namespace smboy
 {
@@ -183,7 +184,6 @@ namespace smboy
 
     bool                dac_enable = false;
     std::uint8_t        dac_input = 0;
-    float               dac_output = 0.0f;
     std::uint8_t        length_timer = 0;
     std::uint8_t        current_volume = 0;
     std::uint16_t       current_period = 0;
@@ -191,6 +191,7 @@ namespace smboy
     std::uint8_t        frequency_sweep_ticks = 0;
     std::uint8_t        envelope_sweep_ticks = 0;
     std::uint8_t        wave_pointer = 0;
+    std::uint64_t       next_step_cycle = 0;
 
     inline std::uint16_t get_initial_period () const
     {
@@ -209,11 +210,11 @@ namespace smboy
 
     bool                dac_enable = false;
     std::uint8_t        dac_input = 0;
-    float               dac_output = 0.0f;
     std::uint8_t        length_timer = 0;
     std::uint8_t        sample_index = 0;
     std::uint16_t       current_period = 0;
     std::uint16_t       period_divider = 0;
+    std::uint64_t       next_step_cycle = 0;
 
     inline std::uint16_t get_initial_period () const
     {
@@ -249,34 +250,95 @@ namespace smboy
 
     bool                dac_enable = false;
     std::uint8_t        dac_input = 0;
-    float               dac_output = 0.0f;
     std::uint16_t       lfsr_state = 0;
     std::uint8_t        length_timer = 0;
     std::uint8_t        current_volume = 0;
     std::uint8_t        envelope_sweep_ticks = 0;
     std::uint64_t       clock_frequency = 0;
+    std::uint64_t       next_step_cycle = 0;
   };
 
   /** Audio Sample Structure **********************************************************************/
   
+  /**
+   * @brief The @a `audio_sample` struct is one point-sampled stereo sample of the audio output.
+   *
+   *        The inputs are the average of the DAC inputs of the channels panned to each side. The
+   *        outputs are the mixed DAC outputs of those channels, scaled by the master volume, as
+   *        signed 16-bit samples.
+   */
   struct audio_sample
   {
     std::uint8_t  left_input = 0;
     std::uint8_t  right_input = 0;
-    float         left_output = 0.0f;
-    float         right_output = 0.0f;
+    std::int16_t  left_output = 0;
+    std::int16_t  right_output = 0;
   };
 
   /** Audio Context Class *************************************************************************/
   
+  /**
+   * @brief The @a `audio` class emulates the SM166-Boy's audio processing unit.
+   *
+   *        The audio context is not ticked on every clock. Instead, each channel works out the
+   *        cycle on which its waveform next steps, from its period, and the audio context runs
+   *        directly from one of these steps to the next, mixing samples on the way. It only needs
+   *        to be brought up to date when its registers are written to, when the frame sequencer
+   *        steps, or when its output is needed; each of these runs all of the cycles since the last
+   *        one in a single call. The output is the same as if the channels were ticked every clock.
+   *
+   *        The audio context produces output in one of two ways. The mix function is handed a
+   *        point-sampled @a `audio_sample` at each tick of the mix clock. The output function is
+   *        instead handed a batch of band-limited, 16-bit stereo samples at the end of each video
+   *        frame: whenever the mixed output's amplitude changes, the change is added to a pair of
+   *        @a `blip_buffer`s, timestamped with its cycle, and the output samples are recovered from
+   *        them in one pass per frame. The latter aliases far less, and costs far less per sample.
+   *        Both are mixed in integer arithmetic by the same mixer, which applies the panning of
+   *        NR51 and the master volume of NR50.
+   */
   class audio
   {
   
   public:  /** Public Methods *********************************************************************/
     
     void initialize (emulator* _emulator);
-    void tick (const std::uint64_t& cycle_count, bool needs_update);
     audio_sample get_sample () const;
+
+    /**
+     * @brief Runs the audio context up to, and including, the given cycle. Call this before
+     *        writing to any of the audio registers or wave RAM.
+     *
+     * @param cycle_count The processor's tick cycle count.
+     */
+    void update (std::uint64_t cycle_count);
+
+    /**
+     * @brief Runs the audio context up to the given cycle, then steps its frame sequencer on that
+     *        cycle. Call this whenever the timer's DIV-APU event fires.
+     *
+     * @param cycle_count The processor's tick cycle count.
+     */
+    void tick_frame_sequencer (std::uint64_t cycle_count);
+
+    /**
+     * @brief Runs the audio context up to, but not including, the given cycle, then hands the
+     *        band-limited output samples completed since the last call to the output function.
+     *        Call this at the end of each video frame. Does nothing if band-limited output is off.
+     *
+     *        The given cycle itself is left to run later, so that a frame sequencer step which
+     *        falls on it, once the timer runs, is not lost.
+     *
+     * @param cycle_count The processor's tick cycle count.
+     */
+    void end_frame (std::uint64_t cycle_count);
+
+    /**
+     * @brief Copies the audio context's state, including the band-limited output not yet handed
+     *        over, into a snapshot, or restores it from one. The mix and output functions, the mix
+     *        clock and the output rate are settings, and are not part of the snapshot.
+     */
+    void save_state (audio& snapshot) const;
+    void load_state (const audio& snapshot);
     
   public:  /** Register Reads *********************************************************************/
     inline std::uint8_t read_reg_nr10 () const { return m_pc1.psc.state; }
@@ -313,7 +375,6 @@ namespace smboy
     inline void write_reg_nr41 (std::uint8_t value) { m_nc.ltc.state = value; }
     inline void write_reg_nr50 (std::uint8_t value) { m_volume.state = value; }
     inline void write_reg_nr51 (std::uint8_t value) { m_panning.state = value; }
-    inline void write_reg_nr52 (std::uint8_t value) { m_control.state |= (value & 0b11110000); }
     
   public:  /** Register Writes With Side Effects **************************************************/
     void write_reg_nr12 (std::uint8_t value);
@@ -325,6 +386,7 @@ namespace smboy
     void write_reg_nr42 (std::uint8_t value);
     void write_reg_nr43 (std::uint8_t value);
     void write_reg_nr44 (std::uint8_t value);
+    void write_reg_nr52 (std::uint8_t value);
 
   public:  /** General Getters ********************************************************************/
   
@@ -343,21 +405,72 @@ namespace smboy
     {
       if (frequency == 0) { frequency = 44100; }
       m_mix_clock = 4194304 / frequency;
+      m_schedule_valid = false;
     }
 
     inline void set_mix_function
       (const std::function<void(const audio_sample&)>& on_mix)
     {
       m_on_mix = on_mix;
+      m_schedule_valid = false;
     }
 
+    /**
+     * @brief Turns band-limited output on at the given sample rate, or off.
+     *
+     * @param sample_rate The output sample rate, in Hz, eg. `44100` or `48000`. Zero turns
+     *                    band-limited output off.
+     *
+     * @return  @a `true` if the sample rate is valid; @a `false` otherwise.
+     */
+    bool set_output_rate (std::uint32_t sample_rate);
+
+    /**
+     * @brief Sets the function which is handed the band-limited output samples at the end of each
+     *        video frame. The samples are interleaved left and right, and remain valid only for the
+     *        duration of the call.
+     */
+    inline void set_output_function
+      (const std::function<void(const std::int16_t* samples, std::size_t frame_count)>& on_output)
+    {
+      m_on_output = on_output;
+    }
+
+    /**
+     * @brief Sets whether the audio context's output is muted. While muted, the audio context runs
+     *        as usual, but hands nothing to the mix and output functions.
+     */
+    inline void set_output_muted (bool muted) { m_output_muted = muted; }
+
   private: /** Ticking Methods ********************************************************************/
     void tick_length_timers ();
     void tick_frequency_sweep ();
     void tick_envelope_sweep ();
-    void tick_wave_period_divider ();
-    void tick_pulse_period_dividers ();
-    void tick_noise_divider ();
+    void step_wave_channel ();
+    void step_pulse_channel (pulse_channel& channel);
+    void step_noise_channel ();
+
+  private: /** Event Scheduling Methods ***********************************************************/
+    void run_until (std::uint64_t end_cycle);
+    void run_channel_steps (std::uint64_t cycle);
+    void schedule_events ();
+    void store_period_dividers ();
+
+  private: /** Mixing Methods *********************************************************************/
+
+    struct channel_mix
+    {
+      std::int32_t  left_input;
+      std::int32_t  right_input;
+      std::int32_t  left_output;
+      std::int32_t  right_output;
+    };
+
+    channel_mix mix_channels () const;
+
+  private: /** Band-Limited Output Methods ********************************************************/
+    void add_output_deltas (std::uint64_t cycle);
+    void flush_output (std::uint64_t cycle);
 
   private: /** Hardware Registers *****************************************************************/
     pulse_channel m_pc1;
@@ -372,6 +485,38 @@ namespace smboy
     std::uint16_t m_divider = 0;
     std::uint64_t m_mix_clock = 0;
     std::function<void(const audio_sample&)> m_on_mix = nullptr;
+    bool          m_output_muted = false;
+
+  private: /** Event Schedule *********************************************************************/
+
+    // The first cycle which the audio context has not yet run.
+    std::uint64_t m_cycle = 1;
+
+    // The cycle on which the next sample is mixed.
+    std::uint64_t m_next_mix_cycle = 0;
+
+    // Indicates whether the channels' step cycles and the next mix cycle are up to date. Anything
+    // which changes a channel's period or enable state, or the mix clock, clears this, and the
+    // schedule is worked out again from the channels' period dividers on the next run.
+    bool          m_schedule_valid = false;
+
+  private: /** Band-Limited Output *************************************************************/
+    bool                      m_output_enabled = false;
+    blip_buffer               m_left_output;
+    blip_buffer               m_right_output;
+
+    // The first cycle of the current output frame, and the longest an output frame may run before
+    // it is flushed, even if no video frame has ended. This keeps the buffers from overflowing
+    // while the display is off.
+    std::uint64_t             m_output_frame_cycle = 1;
+    std::uint64_t             m_max_output_clocks = 0;
+
+    // The output's amplitude, as of the last change added to the buffers.
+    std::int32_t              m_left_level = 0;
+    std::int32_t              m_right_level = 0;
+
+    std::vector<std::int16_t> m_output_samples;
+    std::function<void(const std::int16_t*, std::size_t)> m_on_output = nullptr;
 
   private: /** Emulator Handle ********************************************************************/
     emulator* m_emulator = nullptr;
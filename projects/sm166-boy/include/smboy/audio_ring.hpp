@@ -0,0 +1,94 @@
+/** @file smboy/audio_ring.hpp */
+
+#pragma once
+
+#include <smboy/common.hpp>
+
+namespace smboy
+{
+
+  /**
+   * @brief The @a `audio_ring` class is a lock-free, single-producer, single-consumer ring buffer
+   *        of interleaved, 16-bit stereo audio frames, used to hand the audio context's output from
+   *        the emulation thread to the audio device's callback.
+   *
+   *        Neither side ever waits for the other. If the ring is full, the producer drops the
+   *        frames which don't fit; if it runs dry, the consumer gets fewer frames than it asked
+   *        for. Both cases are counted, so that the frontend can tell whether its pacing keeps the
+   *        ring at a healthy fill level.
+   *
+   * @note  Only one thread may call the producer methods, and only one thread may call the
+   *        consumer methods. The other methods may be called from any thread.
+   */
+  class audio_ring
+  {
+
+  public:
+
+    /**
+     * @param frame_capacity  The number of stereo frames the ring can hold. This is rounded up to
+     *                        a power of two.
+     */
+    explicit audio_ring (std::size_t frame_capacity);
+
+  public: /** Producer Methods ********************************************************************/
+
+    /**
+     * @brief Pushes stereo frames onto the ring. Frames which don't fit are dropped, and counted as
+     *        an overrun.
+     *
+     * @param samples     The frames' interleaved left and right samples.
+     * @param frame_count The number of frames to push.
+     *
+     * @return  The number of frames pushed.
+     */
+    std::size_t push (const std::int16_t* samples, std::size_t frame_count);
+
+  public: /** Consumer Methods ********************************************************************/
+
+    /**
+     * @brief Pops stereo frames off the ring. Coming up short is counted as an underrun.
+     *
+     * @param output      The buffer to which the frames' interleaved samples are written.
+     * @param frame_count The number of frames wanted.
+     *
+     * @return  The number of frames popped.
+     */
+    std::size_t pop (std::int16_t* output, std::size_t frame_count);
+
+  public:
+
+    inline std::size_t get_capacity () const { return m_capacity; }
+
+    inline std::size_t get_frame_count () const
+    {
+      return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+    }
+
+    inline double get_fill_level () const
+    {
+      return static_cast<double>(get_frame_count()) / m_capacity;
+    }
+
+    inline std::uint64_t get_underrun_count () const
+      { return m_underruns.load(std::memory_order_relaxed); }
+    inline std::uint64_t get_overrun_count () const
+      { return m_overruns.load(std::memory_order_relaxed); }
+
+  private:
+
+    std::uint32_t                           m_capacity = 0;
+    std::vector<std::int16_t>               m_samples;
+
+    // The head is only written by the producer, and the tail only by the consumer. Both count
+    // frames up forever, and are masked to index into the sample array.
+    alignas(64) std::atomic<std::uint32_t>  m_head { 0 };
+    alignas(64) std::atomic<std::uint32_t>  m_tail { 0 };
+
+    // The number of pushes which dropped frames, and of pops which came up short.
+    alignas(64) std::atomic<std::uint64_t>  m_overruns { 0 };
+    std::atomic<std::uint64_t>              m_underruns { 0 };
+
+  };
+
+}
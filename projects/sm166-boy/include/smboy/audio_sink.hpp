@@ -0,0 +1,99 @@
+/** @file smboy/audio_sink.hpp */
+
+#pragma once
+
+#include <smboy/audio_ring.hpp>
+
+namespace smboy
+{
+
+  /**
+   * @brief The @a `audio_capture_format` enum enumerates the formats in which the @a `audio_sink`
+   *        can write captured audio to disk.
+   */
+  enum audio_capture_format
+  {
+    acf_raw,    // Write raw, interleaved, signed 16-bit little-endian stereo PCM.
+    acf_wav     // Write the same PCM data into a WAV file.
+  };
+
+  /**
+   * @brief The @a `audio_sink` class streams the audio context's band-limited output to disk on a
+   *        background writer thread, so that headless runs can produce audio output, and so that
+   *        the audio output of different builds can be compared.
+   *
+   *        Each video frame's batch of stereo frames is pushed into a ring buffer holding several
+   *        seconds of audio, from which the writer thread writes it out in large chunks. If the
+   *        writer falls so far behind that the ring is full, then frames are dropped and counted,
+   *        rather than holding up the emulation thread.
+   */
+  class audio_sink
+  {
+
+  public:
+
+    audio_sink ();
+    ~audio_sink ();
+
+  public:
+
+    /**
+     * @brief Opens the sink's output file, then starts the writer thread.
+     *
+     * @param path        The file to write.
+     * @param format      The format in which to write the captured audio.
+     * @param sample_rate The sample rate of the captured audio, in Hz.
+     *
+     * @return  @a `true` if the sink was opened successfully; @a `false` otherwise.
+     */
+    bool open (const fs::path& path, audio_capture_format format, std::uint32_t sample_rate);
+
+    /**
+     * @brief Waits for the writer thread to write out all queued audio, finishes the output file,
+     *        then closes it.
+     */
+    void close ();
+
+    /**
+     * @brief Queues a batch of stereo frames to be written. Call this from the emulation thread,
+     *        typically from the audio context's output function; it never blocks.
+     *
+     * @param samples     The frames' interleaved left and right samples.
+     * @param frame_count The number of frames to write.
+     */
+    void submit (const std::int16_t* samples, std::size_t frame_count);
+
+  public:
+
+    inline bool is_open () const { return m_writer.joinable(); }
+    inline std::uint64_t get_written_count () const { return m_written.load(); }
+    inline std::uint64_t get_dropped_count () const { return m_dropped.load(); }
+
+  private:
+
+    void run_writer ();
+    void write_wav_header (std::uint64_t frame_count);
+
+  private:
+
+    // The ring holds about six seconds of audio at 44.1 kHz. The writer thread writes out up to
+    // this many frames at a time.
+    static constexpr std::size_t ring_frames = 262144;
+    static constexpr std::size_t chunk_frames = 16384;
+
+    audio_capture_format            m_format = audio_capture_format::acf_raw;
+    std::uint32_t                   m_sample_rate = 0;
+    std::ofstream                   m_file;
+
+    audio_ring                      m_ring;
+    std::thread                     m_writer;
+    std::atomic<bool>               m_stopping { false };
+    std::atomic<std::uint64_t>      m_written { 0 };
+    std::atomic<std::uint64_t>      m_dropped { 0 };
+
+    // The chunk being written. Only used by the writer thread.
+    std::vector<std::int16_t>       m_chunk;
+
+  };
+
+}
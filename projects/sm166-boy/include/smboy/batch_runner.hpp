@@ -0,0 +1,118 @@
+/** @file smboy/batch_runner.hpp */
+
+#pragma once
+
+#include <smboy/common.hpp>
+
+namespace smboy
+{
+
+  class emulator;
+
+  /**
+   * @brief The @a `batch_job` struct describes one job run by the @a `batch_runner`: a program to
+   *        run in an emulator instance of its own, and the limits at which to stop it.
+   *
+   *        A frame ends at vertical blank, or once a frame's worth of cycles has passed without one,
+   *        so that a program which keeps the LCD off still reaches its frame limit.
+   */
+  struct batch_job
+  {
+    fs::path      program_file;           // The program file to run.
+    std::uint64_t max_frames = 0;         // Stop after this many frames. Zero for no limit.
+    std::uint64_t max_cycles = 0;         // Stop after this many tick cycles. Zero for no limit.
+    std::int64_t  rtc_epoch = 0;          // The realtime clock's epoch, so that runs are repeatable.
+    fs::path      input_replay;           // If set, replay the input log written here.
+    fs::path      frame_hash_path;        // If set, write the CRC-32 of every frame here.
+
+    // Called once the program has been loaded, before the job starts running, and once per
+    // completed frame, from the job's worker thread. Use these to set the job up, or to feed it
+    // input. Either may be left empty.
+    std::function<void(emulator&)>                  on_start = nullptr;
+    std::function<void(emulator&, std::uint64_t)>   on_frame = nullptr;
+  };
+
+  /**
+   * @brief The @a `batch_status` enum enumerates the ways in which a @a `batch_job` can end.
+   */
+  enum batch_status
+  {
+    bs_pending,     // The job has not been run.
+    bs_limited,     // The job ran until one of its limits was reached.
+    bs_stopped,     // The program stopped the processor before any limit was reached.
+    bs_failed       // The program could not be loaded, or failed to run.
+  };
+
+  /**
+   * @brief The @a `batch_result` struct holds the outcome of one @a `batch_job`.
+   */
+  struct batch_result
+  {
+    batch_status  status = batch_status::bs_pending;
+    std::uint64_t frames = 0;             // Emulated frames completed.
+    std::uint64_t cycles = 0;             // Emulated tick cycles run.
+    std::uint64_t instructions = 0;       // Instructions executed, not counting halted steps.
+    double        seconds = 0.0;          // Host seconds taken.
+    std::uint64_t dropped_frames = 0;     // Frame hashes dropped by the job's frame sink.
+    std::uint32_t worker = 0;             // The index of the worker thread which ran the job.
+  };
+
+  /**
+   * @brief The @a `batch_runner` class runs many jobs, each in an emulator instance of its own,
+   *        across a pool of worker threads.
+   *
+   *        Jobs are dealt out evenly to each worker's own queue up front. Workers take jobs from
+   *        the front of their own queue, and, once it is empty, steal jobs from the back of the
+   *        other workers' queues, so that a worker left with long jobs doesn't hold up the batch
+   *        while the others sit idle.
+   */
+  class batch_runner
+  {
+
+  public:
+
+    /**
+     * @brief Runs a batch of jobs, blocking until all of them are done.
+     *
+     * @param jobs          The jobs to run.
+     * @param thread_count  The number of worker threads to run them on. Zero to use one per host
+     *                      core.
+     *
+     * @return  Each job's result, in the same order as the jobs.
+     */
+    std::vector<batch_result> run (const std::vector<batch_job>& jobs,
+      std::uint32_t thread_count = 0);
+
+    /**
+     * @brief Retrieves the name of a job status, as used in the batch runner's JSON output.
+     */
+    static const char* get_status_name (batch_status status);
+
+    /**
+     * @brief Writes a batch's jobs and results out as a JSON array, one object per job.
+     */
+    static void write_json (std::ostream& out, const std::vector<batch_job>& jobs,
+      const std::vector<batch_result>& results);
+
+  private:
+
+    // A worker's queue of job indices, guarded by a lock of its own, so that workers only contend
+    // with each other when stealing.
+    struct work_queue
+    {
+      std::mutex              mutex;
+      std::deque<std::size_t> jobs;
+    };
+
+    void run_worker (std::uint32_t worker);
+    bool take_job (std::uint32_t worker, std::size_t& job);
+    static batch_result run_job (const batch_job& job);
+
+  private:
+    const std::vector<batch_job>*             m_jobs = nullptr;
+    std::vector<batch_result>                 m_results;
+    std::vector<std::unique_ptr<work_queue>>  m_queues;
+
+  };
+
+}
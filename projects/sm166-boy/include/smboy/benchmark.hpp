@@ -0,0 +1,117 @@
+/** @file smboy/benchmark.hpp */
+
+#pragma once
+
+#include <smboy/common.hpp>
+
+namespace smboy
+{
+
+  class emulator;
+
+  /**
+   * @brief The @a `benchmark_options` struct describes how the @a `benchmark` runs the emulator.
+   */
+  struct benchmark_options
+  {
+    std::uint64_t frames = 600;           // The number of frames to measure in each run.
+    double        seconds = 0.0;          // If non-zero, measure this many host seconds instead.
+    std::uint64_t warmup_frames = 0;      // The number of frames to run, unmeasured, beforehand.
+    std::uint32_t repeat = 1;             // The number of measured runs.
+    std::int32_t  core = -1;              // If not negative, the host core to pin the thread to.
+  };
+
+  /**
+   * @brief The @a `benchmark_result` struct holds the measurements of a single benchmark run.
+   */
+  struct benchmark_result
+  {
+    std::uint64_t frames = 0;             // Emulated frames completed.
+    std::uint64_t instructions = 0;       // Instructions executed, not counting halted steps.
+    std::uint64_t cycles = 0;             // Emulated clock cycles run.
+    double        seconds = 0.0;          // Host seconds taken.
+    double        fps = 0.0;              // Emulated frames completed per host second.
+    double        instructions_per_second = 0.0;
+    double        emulated_mhz = 0.0;     // Emulated clock cycles per host second, in millions.
+    double        frame_ns_p50 = 0.0;     // The median host time taken per frame, in nanoseconds.
+    double        frame_ns_p99 = 0.0;     // The 99th percentile host time taken per frame.
+    std::uint64_t dropped_frames = 0;     // Frames the renderer's frame sink had to drop.
+  };
+
+  /**
+   * @brief The @a `benchmark` class runs the emulator as fast as the host allows, for a set number
+   *        of frames or host seconds, and measures how quickly it runs.
+   *
+   *        Like the @a `pacer`, the benchmark is owned by the frontend, and should be told about
+   *        every completed frame, typically from the renderer's vertical blank function. A frame's
+   *        worth of cycles without a vertical blank, as when the LCD is off, counts as a frame of
+   *        its own, so that the benchmark never waits on the program to draw. Repeated runs carry
+   *        on from where the previous run left off; the emulator is not reset between them.
+   */
+  class benchmark
+  {
+
+  public:
+
+    /**
+     * @brief Runs the benchmark on the calling thread, until all of its runs are done or the
+     *        emulator stops.
+     *
+     * @param emu     The emulator to run.
+     * @param options How to run the benchmark.
+     *
+     * @return  @a `true` if every run completed;
+     *          @a `false` if the emulator stopped or failed first.
+     */
+    bool run (emulator& emu, const benchmark_options& options);
+
+    /**
+     * @brief Called once per completed frame, from the emulation thread.
+     */
+    void on_frame ();
+
+    /**
+     * @brief Writes the benchmark's options and results out as a JSON object.
+     */
+    void write_json (std::ostream& out) const;
+
+  public:
+    inline const std::vector<benchmark_result>& get_results () const { return m_results; }
+
+  public:
+
+    /**
+     * @brief Pins the calling thread to one of the host's cores.
+     *
+     * @return  @a `true` if the thread was pinned; @a `false` if it could not be.
+     */
+    static bool pin_to_core (std::int32_t core);
+
+    /**
+     * @brief Retrieves the peak resident set size of the host process, in bytes, or zero if it is
+     *        not known on this host.
+     */
+    static std::uint64_t get_peak_rss ();
+
+  private:
+    bool run_frames (emulator& emu, std::uint64_t frames, double seconds, bool measured);
+
+  private:
+    using clock = std::chrono::steady_clock;
+
+    benchmark_options             m_options;
+    std::vector<benchmark_result> m_results;
+    std::string                   m_title;
+    bool                          m_pinned = false;
+    bool                          m_completed = false;
+
+    // The number of frames completed, the time at which the last one completed, and the host time
+    // taken by each frame of the current run.
+    std::uint64_t                 m_frame_count = 0;
+    clock::time_point             m_frame_time;
+    bool                          m_measuring = false;
+    std::vector<std::uint64_t>    m_frame_times;
+
+  };
+
+}
@@ -0,0 +1,117 @@
+/** @file smboy/blip_buffer.hpp */
+
+#pragma once
+
+#include <smboy/common.hpp>
+
+namespace smboy
+{
+
+  /**
+   * @brief The @a `blip_buffer` class synthesizes one band-limited audio signal at a fixed output
+   *        sample rate, from changes in amplitude which are timestamped in emulated clock cycles.
+   *
+   *        Instead of point-sampling the emulated signal at the output rate, which aliases badly,
+   *        each change in amplitude is added to the buffer as a band-limited step: a short,
+   *        windowed-sinc kernel, chosen by where between two output samples the change falls. The
+   *        output samples are then recovered in batches by integrating the buffer, which is a tight
+   *        integer loop. A gentle high-pass filter is applied at the same time, to remove any DC
+   *        offset from the signal.
+   *
+   *        Amplitude changes are added within a frame of clock cycles. Ending the frame makes the
+   *        samples which it completes available for reading.
+   */
+  class blip_buffer
+  {
+
+  public:
+
+    /**
+     * @brief The number of output samples over which each band-limited step is spread.
+     */
+    static constexpr std::size_t kernel_width = 16;
+
+  public:
+
+    /**
+     * @brief Sets the buffer's clock and output sample rates, and clears it.
+     *
+     * @param clock_rate    The rate of the clock in which amplitude changes are timestamped, in Hz.
+     * @param sample_rate   The output sample rate, in Hz.
+     * @param capacity      The number of output samples which the buffer can hold before they must
+     *                      be read.
+     *
+     * @return  @a `true` if the rates and capacity are valid; @a `false` otherwise.
+     */
+    bool set_rates (std::uint32_t clock_rate, std::uint32_t sample_rate, std::size_t capacity);
+
+    /**
+     * @brief Discards all buffered samples and amplitude changes, and resets the frame.
+     */
+    void clear ();
+
+    /**
+     * @brief Adds a change in amplitude to the current frame.
+     *
+     * @param clock_time  The time of the change, in clock cycles since the start of the frame.
+     * @param delta       The change in amplitude, in output sample units.
+     */
+    void add_delta (std::uint64_t clock_time, std::int32_t delta);
+
+    /**
+     * @brief Ends the current frame, making the output samples it completes available for reading.
+     *        The next frame starts where this one ends.
+     *
+     * @param clock_duration  The length of the frame, in clock cycles.
+     */
+    void end_frame (std::uint64_t clock_duration);
+
+    /**
+     * @brief Reads, and removes, output samples from the buffer.
+     *
+     * @param output  The buffer to which the samples are written.
+     * @param count   The maximum number of samples to read.
+     * @param stride  The distance between samples in the output buffer, eg. `2` to interleave the
+     *                left and right signals of a stereo output.
+     *
+     * @return  The number of samples read.
+     */
+    std::size_t read_samples (std::int16_t* output, std::size_t count, std::size_t stride = 1);
+
+  public:
+
+    inline std::size_t get_samples_available () const { return m_offset >> time_bits; }
+    inline std::size_t get_capacity () const { return m_capacity; }
+    inline std::uint32_t get_sample_rate () const { return m_sample_rate; }
+
+    /**
+     * @brief Retrieves the longest frame, in clock cycles, which can be ended without overflowing
+     *        the buffer, if it starts out empty.
+     */
+    inline std::uint64_t get_max_frame_clocks () const
+    {
+      return (m_factor == 0) ? 0 : ((std::uint64_t(m_capacity) << time_bits) / m_factor);
+    }
+
+  private:
+
+    // The fixed-point position of a clock cycle in output samples has this many fractional bits.
+    static constexpr std::uint32_t time_bits = 32;
+
+  private:
+
+    std::uint32_t               m_sample_rate = 0;
+    std::size_t                 m_capacity = 0;
+
+    // The length of one clock cycle in output samples, and the position of the start of the current
+    // frame relative to the first unread sample, both in fixed point.
+    std::uint64_t               m_factor = 0;
+    std::uint64_t               m_offset = 0;
+
+    // The amplitude changes waiting to be integrated into output samples, and the integrator.
+    std::vector<std::int32_t>   m_deltas;
+    std::int64_t                m_integrator = 0;
+
+  };
+
+}
@@ -3,15 +3,24 @@
 #pragma once
 
 #include <fstream>
+#include <sstream>
+#include <array>
+#include <cstdio>
 #include <string>
 #include <unordered_map>
 #include <queue>
 #include <filesystem>
 #include <memory>
+#include <atomic>
 #include <chrono>
 #include <thread>
+#include <mutex>
+#include <deque>
 #include <ctime>
 #include <cmath>
+#include <algorithm>
+#include <coroutine>
+#include <utility>
 #include <sm/common.hpp>
 
 namespace fs = std::filesystem;
@@ -35,17 +44,21 @@ namespace smboy
 
   #undef address_space
   
+  constexpr std::uint32_t clock_speed = 4194304;
   constexpr std::uint32_t screen_width = 160;
   constexpr std::uint32_t screen_height = 144;
   constexpr std::uint32_t screen_buffer_size = (screen_width * screen_height);
   constexpr std::uint32_t object_count = 40;
   constexpr std::uint32_t ticks_per_line = 456;
   constexpr std::uint32_t lines_per_frame = 154;
+  constexpr std::uint32_t ticks_per_frame = (ticks_per_line * lines_per_frame);
   constexpr std::uint32_t objects_per_line = 10;
   constexpr std::uint32_t bytes_per_palette = 8;
   constexpr std::uint32_t cram_size = 64;
+  constexpr std::uint32_t cram_color_count = (cram_size / 2);
   constexpr std::uint32_t wave_ram_size = 16;
   constexpr std::uint32_t wave_ram_nibble_size = 32;
+  constexpr std::uint32_t frame_skip_all = 0xFFFFFFFF;
   
   enum interrupt_type
   {
@@ -0,0 +1,130 @@
+/** @file smboy/compositor.hpp */
+
+#pragma once
+
+#include <smboy/common.hpp>
+
+namespace smboy
+{
+
+  /** Line Pixel Descriptors **********************************************************************/
+
+  /**
+   * @brief While a scanline is being drawn, the renderer's pixel fetcher does not resolve pixels to
+   *        colors right away. Instead, each pixel is described by a packed 32-bit descriptor which
+   *        holds the color indices of the background/window layer and of up to three objects
+   *        residing on that pixel, along with the priority bits needed to decide which of those
+   *        layers is visible.
+   *
+   *        The descriptor is laid out as follows:
+   *        - Byte 0 describes the background/window layer:
+   *          - Bits 0 - 1: The color index.
+   *          - Bits 2 - 4: The palette number.
+   *          - Bit 5:      The tile's `bgw_priority` attribute.
+   *          - Bit 6:      The `bgw_priority` bit of the `LCDC` register.
+   *        - Bytes 1 - 3 each describe one object slot, in order of priority:
+   *          - Bits 0 - 1: The color index. Zero indicates transparency, or no object.
+   *          - Bits 2 - 4: The palette number.
+   *          - Bit 5:      The object's `bgw_priority` attribute.
+   *
+   *        In both cases, the low five bits of a layer's byte form the index of its color in that
+   *        layer's half of the renderer's palette cache.
+   */
+  using line_pixel = std::uint32_t;
+
+  constexpr std::uint32_t lp_color_index_mask   = 0b00000011;
+  constexpr std::uint32_t lp_palette_color_mask = 0b00011111;
+  constexpr std::uint32_t lp_bgw_priority_bit   = 0b00100000;
+  constexpr std::uint32_t lp_lcdc_priority_bit  = 0b01000000;
+  constexpr std::uint32_t lp_object_slot_count  = 3;
+
+  /**
+   * @brief Packs the background/window layer's byte of a line pixel descriptor.
+   */
+  inline line_pixel make_bgw_line_pixel (std::uint8_t color_index, std::uint8_t palette_number,
+    std::uint8_t bgw_priority, std::uint8_t lcdc_priority)
+  {
+    return  (color_index & 0b11) |
+            ((palette_number & 0b111) << 2) |
+            ((bgw_priority != 0) ? lp_bgw_priority_bit : 0) |
+            ((lcdc_priority != 0) ? lp_lcdc_priority_bit : 0);
+  }
+
+  /**
+   * @brief Packs an object slot's byte of a line pixel descriptor, shifted into place.
+   */
+  inline line_pixel make_obj_line_pixel (std::uint8_t slot, std::uint8_t color_index,
+    std::uint8_t palette_number, std::uint8_t bgw_priority)
+  {
+    line_pixel value =  (color_index & 0b11) |
+                        ((palette_number & 0b111) << 2) |
+                        ((bgw_priority != 0) ? lp_bgw_priority_bit : 0);
+
+    return value << (8 * (slot + 1));
+  }
+
+  /** Line Compositor *****************************************************************************/
+
+  /**
+   * @brief A line compositor resolves a run of line pixel descriptors into indices into the
+   *        renderer's 64-entry palette cache. Entries 0 - 31 are background colors; entries
+   *        32 - 63 are object colors.
+   *
+   *        Resolving to palette indices, rather than to colors, leaves the choice of frame format
+   *        to the renderer: the indices can be stored as they are, or expanded into colors.
+   *
+   * @param pixels  The line pixel descriptors to resolve.
+   * @param output  The buffer to which the resolved palette indices are written.
+   * @param count   The number of pixels to resolve.
+   */
+  using line_compositor = void (*) (const line_pixel* pixels, std::uint8_t* output,
+    std::size_t count);
+
+  /**
+   * @brief The portable compositor. This is the reference implementation against which the vector
+   *        implementations are checked.
+   */
+  void composite_line_scalar (const line_pixel* pixels, std::uint8_t* output, std::size_t count);
+
+  /**
+   * @brief Selects the fastest line compositor supported by the host processor.
+   *
+   * @return  A pointer to the AVX2 or SSE2 compositor, if supported;
+   *          a pointer to @a `composite_line_scalar` otherwise.
+   */
+  line_compositor select_line_compositor ();
+
+  /**
+   * @brief Retrieves the name of the given line compositor, for diagnostics.
+   */
+  const char* get_line_compositor_name (line_compositor compositor);
+
+  /** Palette Expander ****************************************************************************/
+
+  /**
+   * @brief A palette expander looks a run of palette indices up in a palette, producing RGBA color
+   *        values.
+   *
+   * @param indices The palette indices to look up.
+   * @param palette The palette in which to look them up.
+   * @param output  The buffer to which the color values are written.
+   * @param count   The number of pixels to expand.
+   */
+  using palette_expander = void (*) (const std::uint8_t* indices, const std::uint32_t* palette,
+    std::uint32_t* output, std::size_t count);
+
+  /**
+   * @brief The portable palette expander.
+   */
+  void expand_palette_scalar (const std::uint8_t* indices, const std::uint32_t* palette,
+    std::uint32_t* output, std::size_t count);
+
+  /**
+   * @brief Selects the fastest palette expander supported by the host processor.
+   *
+   * @return  A pointer to the AVX2 expander, if supported;
+   *          a pointer to @a `expand_palette_scalar` otherwise.
+   */
+  palette_expander select_palette_expander ();
+
+}
@@ -10,6 +10,9 @@
 #include <smboy/realtime.hpp>
 #include <smboy/renderer.hpp>
 #include <smboy/joypad.hpp>
+#include <smboy/input_queue.hpp>
+#include <smboy/scheduler.hpp>
+#include <smboy/perf_counters.hpp>
 #include <smboy/audio.hpp>
 #include <sm/processor.hpp>
 
@@ -18,27 +21,32 @@ namespace smboy
 
   /**
    * @brief The @a `emulator` class is the main context of the `smboy` emulator.
+   *
+   *        Each instance holds all of the state of one emulated machine, so a process can run as
+   *        many instances as it likes, each on a thread of its own. The components keep a handle
+   *        back to the instance which owns them, so instances can be neither copied nor moved;
+   *        being large, they are best kept on the heap.
    */
   class emulator
   {
   
   public:
+
+    emulator () = default;
+    emulator (const emulator&) = delete;
+    emulator (emulator&&) = delete;
+    emulator& operator= (const emulator&) = delete;
+    emulator& operator= (emulator&&) = delete;
   
-    /**
-     * @brief Retrieves the singleton instnace of the `smboy` emulator context, creating it if
-     *        necessary.
-     *
-     * @return  A handle to the singleton instance.
-     */
-    static emulator& get_instance ();
+  public:
     
     /**
-     * @brief Initializes the singleton `smboy` emulator instance.
+     * @brief Initializes the `smboy` emulator instance.
      */
     void initialize ();
 
     /**
-     * @brief Stops the singleton `smboy` emulator instance.
+     * @brief Stops the `smboy` emulator instance.
      */
     void stop ();
     
@@ -50,6 +58,42 @@ namespace smboy
      *          @a `false` otherwise.
      */
     bool step ();
+
+    /**
+     * @brief Steps the `smboy` emulator until the renderer reaches vertical blank, or for one
+     *        frame's worth of tick cycles while the display is off.
+     *
+     * @return  @a `true` if no errors occur during the frame;
+     *          @a `false` otherwise.
+     */
+    bool run_frame ();
+
+  public:
+
+    /**
+     * @brief Saves the state of all of the emulator's components into its in-memory snapshot,
+     *        replacing the one saved before, if any.
+     *
+     *        Saving and loading are meant to be done many times per second, so the snapshot is kept
+     *        between calls, and only the pages of RAM written to since the last save or load are
+     *        copied. Snapshots are best taken at vertical blank; see @a `run_frame`.
+     */
+    void save_snapshot ();
+
+    /**
+     * @brief Restores the state of all of the emulator's components from its in-memory snapshot.
+     *
+     * @return  @a `true` if a snapshot was restored;
+     *          @a `false` if none has been saved yet.
+     */
+    bool load_snapshot ();
+
+    /**
+     * @brief Sets whether the emulator is running speculatively, ahead of the frame which is going
+     *        to be kept, and will be rolled back with @a `load_snapshot`. Speculative frames
+     *        produce no audio, call no vertical blank function, and take no queued input.
+     */
+    void set_speculative (bool speculative);
     
   private:
     
@@ -69,6 +113,8 @@ namespace smboy
      *          @a `false` otherwise.
      */
     inline bool is_running () const { return m_running; }
+
+    inline bool is_speculative () const { return m_speculative; }
     
     /**
      * @brief Retrieves the `smboy` emulator's external program data.
@@ -97,9 +143,27 @@ namespace smboy
     
     inline joypad& get_joypad () { return m_joypad; }
     inline const joypad& get_joypad () const { return m_joypad; }
+
+    inline input_queue& get_input () { return m_input; }
+    inline const input_queue& get_input () const { return m_input; }
     
     inline audio& get_audio () { return m_audio; }
     inline const audio& get_audio () const { return m_audio; }
+
+    inline scheduler& get_scheduler () { return m_scheduler; }
+    inline const scheduler& get_scheduler () const { return m_scheduler; }
+
+    /**
+     * @brief Retrieves the emulator's performance counters, for its components to count into.
+     *        To read them, take a snapshot with @a `read_counters` instead.
+     */
+    inline perf_counters& get_counters () { return m_counters; }
+
+    /**
+     * @brief Takes a snapshot of the emulator's performance counters. Call this from the emulation
+     *        thread, or while it is not running.
+     */
+    perf_counters read_counters () const;
     
     /**
      * @brief Retrieves the `smboy` emulator's memory management unit (MMU).
@@ -123,36 +187,64 @@ namespace smboy
      * @brief Indicates whether or not the emulator should continue running.
      */
     bool m_running = false;
-    
+
+    perf_counters m_counters;
+
+    // The components are laid out roughly by how often they're used: those touched on every tick
+    // cycle come first, so that they share cache lines, and the renderer's large buffers come last.
+  
     /**
-     * @brief Contains the `smboy` emulator's external program data.
+     * @brief The SM166 CPU powering the `smboy` emulator.
      */
-    program m_program;
+    sm::processor m_processor;
     
     /**
-     * @brief Contains the `smboy` emulator's internal RAM.
+     * @brief The `smboy` emulator's memory management unit (MMU).
      */
-    ram m_ram;
+    bus m_bus;
+
+    scheduler m_scheduler;
 
     timer m_timer;
     
     realtime m_realtime;
     
-    renderer m_renderer;
-    
     joypad m_joypad;
     
     audio m_audio;
+
+    input_queue m_input;
     
     /**
-     * @brief The `smboy` emulator's memory management unit (MMU).
+     * @brief Contains the `smboy` emulator's external program data.
      */
-    bus m_bus;
-  
+    program m_program;
+    
     /**
-     * @brief The SM166 CPU powering the `smboy` emulator.
+     * @brief Contains the `smboy` emulator's internal RAM.
      */
-    sm::processor m_processor;
+    ram m_ram;
+    
+    renderer m_renderer;
+
+  private:
+
+    // The in-memory snapshot holds a copy of each component's state. It is allocated on the first
+    // save, and kept from then on.
+    struct snapshot
+    {
+      sm::processor     processor;
+      smboy::timer      timer;
+      smboy::realtime   realtime;
+      smboy::joypad     joypad;
+      smboy::audio      audio;
+      smboy::program    program;
+      smboy::ram        ram;
+      smboy::renderer   renderer;
+    };
+
+    std::unique_ptr<snapshot> m_snapshot = nullptr;
+    bool m_speculative = false;
   
   };
 
@@ -0,0 +1,192 @@
+/** @file smboy/frame_buffer.hpp */
+
+#pragma once
+
+#include <smboy/common.hpp>
+
+namespace smboy
+{
+
+  /** Frame Data **********************************************************************************/
+
+  /**
+   * @brief The @a `frame_format` enum enumerates the pixel formats in which the renderer can draw
+   *        its frames. The compact formats take less memory bandwidth to hand off, capture and
+   *        hash; consumers convert them into RGBA only when they need to.
+   */
+  enum frame_format : std::uint8_t
+  {
+    ff_rgba8888,  // Four bytes per pixel: red, green, blue, then alpha.
+    ff_rgb565,    // Two bytes per pixel: five bits of red, six of green, five of blue.
+    ff_indexed8   // One byte per pixel: an index into the scanline's palette snapshot.
+  };
+
+  /**
+   * @brief The @a `frame_data` struct holds one frame drawn by the renderer, in any frame format.
+   *
+   *        Indexed frames also hold snapshots of the renderer's 64-color palette cache. One snapshot
+   *        is taken at the start of the frame, and another whenever the palette changes between
+   *        scanlines, so that palette changes made partway through a frame are kept.
+   *
+   * @note  The SM166-Boy's 15-bit colors convert losslessly into RGB565, so each of the frame
+   *        formats converts back into exactly the same RGBA pixels.
+   */
+  struct frame_data
+  {
+    // The frame's pixel format.
+    frame_format  format = frame_format::ff_rgba8888;
+
+    // The frame's pixels, row by row, in the frame's format. RGBA frames use all of this buffer;
+    // RGB565 frames, the first half; indexed frames, the first quarter.
+    alignas(32) std::uint8_t pixels[screen_buffer_size * 4];
+
+    // Indexed frames only: the number of palette snapshots taken, the snapshots themselves, and
+    // the snapshot used by each scanline.
+    std::uint8_t  palette_count = 0;
+    std::uint8_t  line_palettes[screen_height];
+    std::uint32_t palettes[screen_height + 1][cram_color_count * 2];
+  };
+
+  /**
+   * @brief Retrieves the number of bytes each pixel takes in the given frame format.
+   */
+  inline std::size_t get_frame_pixel_size (frame_format format)
+  {
+    switch (format)
+    {
+      case frame_format::ff_rgb565:   return 2;
+      case frame_format::ff_indexed8: return 1;
+      default:                        return 4;
+    }
+  }
+
+  /**
+   * @brief Packs an RGBA color into an RGB565 color.
+   */
+  inline std::uint16_t pack_rgb565 (std::uint32_t rgba)
+  {
+    return  (((rgba      ) & 0xF8) << 8) |
+            (((rgba >>  8) & 0xFC) << 3) |
+            (((rgba >> 16) & 0xF8) >> 3);
+  }
+
+  /**
+   * @brief Unpacks an RGB565 color into an opaque RGBA color.
+   */
+  inline std::uint32_t unpack_rgb565 (std::uint16_t rgb)
+  {
+    return  (((rgb >> 11) & 0x1F) << 3) |
+            (((rgb >>  5) & 0x3F) << 10) |
+            (((rgb      ) & 0x1F) << 19) |
+            0xFF000000;
+  }
+
+  /**
+   * @brief Copies only the parts of a frame which its format uses.
+   */
+  void copy_frame (const frame_data& source, frame_data& destination);
+
+  /**
+   * @brief Converts a frame, in any format, into RGBA pixels.
+   *
+   * @param frame   The frame to convert.
+   * @param output  The buffer to write the frame's `screen_buffer_size` RGBA pixels into.
+   */
+  void convert_frame_to_rgba (const frame_data& frame, std::uint32_t* output);
+
+  /** Frame Buffer Class **************************************************************************/
+
+  /**
+   * @brief The @a `frame_buffer` class is a lock-free, triple-buffered set of screen buffers, used
+   *        to hand completed frames from the emulation thread over to a display thread.
+   *
+   *        The producer (the renderer) always draws into the back buffer, and publishes it once
+   *        the frame is complete. The consumer (the frontend) acquires the most recently published
+   *        frame into the front buffer, which it may read until its next acquisition. Neither side
+   *        ever waits on the other, and the consumer never sees a frame that is still being drawn.
+   *
+   * @note  Only one thread may call the producer methods, and only one thread may call the
+   *        consumer methods.
+   */
+  class frame_buffer
+  {
+
+  public:
+
+    frame_buffer ();
+
+  public: /** Producer Methods ********************************************************************/
+
+    /**
+     * @brief Clears all three buffers and resets the frame sequence.
+     *
+     * @note  This should not be called while a consumer is reading the front buffer.
+     */
+    void clear ();
+
+    /**
+     * @brief Retrieves the frame which the producer should be drawing into.
+     *
+     * @return  A reference to the back buffer's frame.
+     */
+    inline frame_data& get_back_frame () { return m_frames[m_back]; }
+
+    /**
+     * @brief Publishes the back buffer as the newest completed frame, then swaps in a new back
+     *        buffer. Call @a `get_back_frame` again afterward.
+     *
+     * @return  The sequence number given to the published frame.
+     */
+    std::uint64_t publish ();
+
+  public: /** Consumer Methods ********************************************************************/
+
+    /**
+     * @brief Moves the newest published frame, if any, into the front buffer.
+     *
+     * @return  @a `true` if a frame newer than the current front buffer was acquired;
+     *          @a `false` otherwise.
+     */
+    bool acquire ();
+
+    /**
+     * @brief Retrieves the frame most recently acquired by the consumer.
+     *
+     * @return  A reference to the front buffer's frame.
+     */
+    inline const frame_data& get_front_frame () const { return m_frames[m_front]; }
+
+    /**
+     * @brief Retrieves the sequence number of the front buffer's frame. Sequence numbers start at
+     *        one; zero indicates that no frame has been acquired yet.
+     */
+    inline std::uint64_t get_front_sequence () const { return m_sequences[m_front]; }
+
+  public: /** Shared Methods **********************************************************************/
+
+    /**
+     * @brief Retrieves the sequence number of the most recently published frame.
+     */
+    inline std::uint64_t get_published_sequence () const
+    {
+      return m_published.load(std::memory_order_acquire);
+    }
+
+  private:
+
+    // The bits of the shared state word. The low two bits hold the index of the buffer which sits
+    // between the producer and the consumer; this bit is set if that buffer holds a frame which
+    // the consumer has not yet acquired.
+    static constexpr std::uint8_t fresh_bit = 0b100;
+    static constexpr std::uint8_t index_mask = 0b011;
+
+    frame_data                  m_frames[3];
+    std::uint64_t               m_sequences[3];
+    std::uint8_t                m_back = 0;
+    std::uint8_t                m_front = 2;
+    std::atomic<std::uint8_t>   m_middle { 1 };
+    std::atomic<std::uint64_t>  m_published { 0 };
+
+  };
+
+}
@@ -0,0 +1,127 @@
+/** @file smboy/frame_sink.hpp */
+
+#pragma once
+
+#include <smboy/frame_buffer.hpp>
+
+namespace smboy
+{
+
+  /**
+   * @brief The @a `frame_capture_format` enum enumerates the formats in which the @a `frame_sink`
+   *        can write captured frames to disk.
+   */
+  enum frame_capture_format
+  {
+    fcf_none,   // Write no images. Only the frame hashes, if requested, are written.
+    fcf_raw,    // Write all frames, back to back, into one file of raw RGBA pixels.
+    fcf_y4m,    // Write all frames into one YUV4MPEG2 video file, in 4:4:4 color.
+    fcf_png     // Write each frame into its own PNG file, in the given directory.
+  };
+
+  /**
+   * @brief The @a `frame_sink` class streams completed frames to disk on a background writer
+   *        thread, so that headless runs can produce visual output without the emulation thread
+   *        ever waiting on file I/O or image encoding.
+   *
+   *        Submitted frames are copied into a bounded queue of frame slots, in whichever frame format
+   *        the renderer drew them; the writer thread converts them into RGBA. If the writer falls so
+   *        far behind that the queue is full, then submitted frames are dropped and counted, rather
+   *        than holding up the emulation thread - unless the sink is lossless, in which case the
+   *        emulation thread waits for a free slot instead. Hashes meant for comparison against
+   *        golden runs should be written losslessly, so that a slow disk can't cut them short.
+   *
+   *        Alongside the images, or instead of them, the sink can write a CRC-32 of each captured
+   *        frame's RGBA pixels into a text file, one `<frame number> <crc32>` pair per line, for
+   *        comparison against golden runs.
+   */
+  class frame_sink
+  {
+
+  public:
+
+    frame_sink ();
+    ~frame_sink ();
+
+  public:
+
+    /**
+     * @brief Opens the sink's output files, then starts the writer thread.
+     *
+     * @param path      The file to write, or the directory to write PNG files into. Ignored if
+     *                  the format is @a `fcf_none`.
+     * @param format    The format in which to write captured frames.
+     * @param interval  Capture every Nth frame. One captures every frame.
+     * @param hash_path The text file to write frame hashes into. Leave empty to write no hashes.
+     * @param lossless  If set, wait for the writer to make room instead of dropping frames.
+     *
+     * @return  @a `true` if the sink was opened successfully; @a `false` otherwise.
+     */
+    bool open (const fs::path& path, frame_capture_format format, std::uint32_t interval = 1,
+      const fs::path& hash_path = {}, bool lossless = false);
+
+    /**
+     * @brief Waits for the writer thread to write out all queued frames, then closes the sink's
+     *        output files.
+     */
+    void close ();
+
+    /**
+     * @brief Queues a completed frame to be written, if it falls on the capture interval. Call this
+     *        from the emulation thread. It only blocks if the sink is lossless and the queue is full.
+     *
+     * @param frame_number  The frame's number, counting from one.
+     * @param frame         The frame, in any frame format.
+     */
+    void submit (std::uint64_t frame_number, const frame_data& frame);
+
+  public:
+
+    inline bool is_open () const { return m_writer.joinable(); }
+    inline bool is_lossless () const { return m_lossless; }
+    inline std::uint64_t get_written_count () const { return m_written.load(); }
+    inline std::uint64_t get_dropped_count () const { return m_dropped.load(); }
+
+  private:
+
+    struct frame_slot
+    {
+      std::uint64_t number;
+      frame_data    frame;
+    };
+
+    void run_writer ();
+    void write_frame (const frame_slot& slot);
+    void write_raw_frame ();
+    void write_y4m_frame ();
+    bool write_png_frame (std::uint64_t frame_number);
+
+  private:
+
+    // The number of frames which can be queued up for the writer thread at once.
+    static constexpr std::uint32_t slot_count = 16;
+
+    frame_capture_format            m_format = frame_capture_format::fcf_none;
+    std::uint32_t                   m_interval = 1;
+    bool                            m_lossless = false;
+    fs::path                        m_path;
+    std::ofstream                   m_file;
+    std::ofstream                   m_hash_file;
+
+    // The slot queue. The head is only written by the emulation thread, and the tail only by the
+    // writer thread. Both count up forever, and are wrapped to index into the slot array.
+    std::unique_ptr<frame_slot[]>   m_slots = nullptr;
+    std::atomic<std::uint32_t>      m_head { 0 };
+    std::atomic<std::uint32_t>      m_tail { 0 };
+
+    std::thread                     m_writer;
+    std::atomic<bool>               m_stopping { false };
+    std::atomic<std::uint64_t>      m_written { 0 };
+    std::atomic<std::uint64_t>      m_dropped { 0 };
+
+    // The frame being written, converted into RGBA pixels. Only used by the writer thread.
+    std::uint32_t                   m_pixels[screen_buffer_size];
+
+  };
+
+}
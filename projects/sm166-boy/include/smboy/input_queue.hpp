@@ -0,0 +1,136 @@
+/** @file smboy/input_queue.hpp */
+
+#pragma once
+
+#include <smboy/common.hpp>
+#include <smboy/scheduler.hpp>
+
+namespace smboy
+{
+
+  class emulator;
+
+  /**
+   * @brief The @a `input_type` enum enumerates the kinds of joypad input an @a `input_event` can
+   *        carry.
+   */
+  enum input_type : std::uint8_t
+  {
+    it_button,    // The index is a `joypad_button`.
+    it_dpad       // The index is a `joypad_dpad`.
+  };
+
+  /**
+   * @brief The @a `input_event` struct describes one joypad button or direction being pressed or
+   *        released.
+   */
+  struct input_event
+  {
+    std::uint64_t cycle = 0;        // The tick cycle on which the event takes effect.
+    std::int64_t  host_time = 0;    // When the event was pushed, in host nanoseconds.
+    input_type    type = input_type::it_button;
+    std::uint8_t  index = 0;
+    bool          pressed = false;
+  };
+
+  /**
+   * @brief The @a `input_queue` class hands joypad input from the frontend's UI thread to the
+   *        emulation thread, so that the joypad is only ever changed on the emulation thread, at a
+   *        well-defined cycle.
+   *
+   *        The UI thread pushes events, stamped with the host's monotonic clock, onto a lock-free,
+   *        single-producer, single-consumer ring. The emulation thread drains the ring once per
+   *        scanline. Each drained event is given the cycle on which it takes effect by mapping its
+   *        host time from the span of host time since the previous drain onto the next scanline's
+   *        worth of cycles. Input thus takes effect about a scanline after it is drained, in the
+   *        order and with roughly the spacing with which it arrived.
+   *
+   *        Events can also be scheduled directly, already stamped with their cycles, for example
+   *        to replay a log of an earlier run. Every event is written to the log, if one is open, as
+   *        it takes effect, so any run can be replayed exactly.
+   *
+   * @note  Only one thread may push events. All other methods must be called from the emulation
+   *        thread, or while it is not running.
+   */
+  class input_queue
+  {
+
+  public:
+
+    void initialize (emulator* _emulator);
+
+    /**
+     * @brief The input queue's coroutine. It wakes when the ring is due to be drained, or an event
+     *        is due to take effect, sleeping on the scheduler in between.
+     */
+    device_task run (scheduler& sched);
+
+  public: /** Producer Methods ********************************************************************/
+
+    /**
+     * @brief Pushes an input event onto the ring, stamped with the current host time. If the ring
+     *        is full, the event is dropped.
+     *
+     * @return  @a `true` if the event was pushed; @a `false` if it was dropped.
+     */
+    bool push (input_type type, std::uint8_t index, bool pressed);
+
+  public:
+
+    /**
+     * @brief Schedules an input event to take effect on its given cycle, or on the next tick cycle
+     *        if that cycle has already passed.
+     */
+    void schedule (const input_event& event);
+
+    /**
+     * @brief Opens a log file, into which every event is written as it takes effect.
+     *
+     * @return  @a `true` if the log file was opened; @a `false` otherwise.
+     */
+    bool open_log (const fs::path& path);
+
+    /**
+     * @brief Loads a log file written by @a `open_log`, and schedules all of its events.
+     *
+     * @return  @a `true` if the log file was loaded; @a `false` otherwise.
+     */
+    bool load_replay (const fs::path& path);
+
+  public:
+    inline std::uint64_t get_dropped_count () const
+      { return m_dropped.load(std::memory_order_relaxed); }
+
+  private:
+    void handle_events (std::uint64_t cycle_count);
+    void drain (std::uint64_t cycle_count);
+    void apply (const input_event& event);
+    void update_next_event_cycle ();
+
+  private:
+    using clock = std::chrono::steady_clock;
+
+    static constexpr std::uint32_t capacity = 256;
+
+    emulator*                       m_emulator = nullptr;
+
+    // The ring. The head is only written by the producer, and the tail only by the consumer.
+    std::array<input_event, capacity>       m_ring;
+    alignas(64) std::atomic<std::uint32_t>  m_head { 0 };
+    alignas(64) std::atomic<std::uint32_t>  m_tail { 0 };
+    std::atomic<std::uint64_t>              m_dropped { 0 };
+
+    // The events waiting to take effect, in cycle order.
+    std::deque<input_event>         m_pending;
+
+    // The host time of the previous drain, and the cycle of the next one.
+    std::int64_t                    m_drain_time = 0;
+    bool                            m_drained = false;
+    std::uint64_t                   m_next_drain_cycle = 0;
+    std::uint64_t                   m_next_event_cycle = 0;
+
+    std::ofstream                   m_log;
+
+  };
+
+}
@@ -52,6 +52,12 @@ namespace smboy
   
   public:
     void initialize (emulator* _emulator);
+
+    /**
+     * @brief Copies the joypad's state into a snapshot, or restores it from one.
+     */
+    void save_state (joypad& snapshot) const;
+    void load_state (const joypad& snapshot);
     
   public:
     void set_button (joypad_button button, bool pressed);
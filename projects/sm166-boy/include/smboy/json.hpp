@@ -0,0 +1,40 @@
+/** @file smboy/json.hpp */
+
+#pragma once
+
+#include <smboy/common.hpp>
+
+namespace smboy
+{
+
+  /**
+   * @brief Writes a string out as a quoted JSON string, escaping it as needed.
+   */
+  inline void write_json_string (std::ostream& out, const std::string& value)
+  {
+    out << '"';
+    for (char c : value)
+    {
+      if (c == '"' || c == '\\')  { out << '\\' << c; }
+      else if (static_cast<unsigned char>(c) < 0x20)
+      {
+        char escaped[8];
+        std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(c));
+        out << escaped;
+      }
+      else                        { out << c; }
+    }
+    out << '"';
+  }
+
+  /**
+   * @brief Writes a number out as a JSON number, to three decimal places.
+   */
+  inline void write_json_number (std::ostream& out, double value)
+  {
+    char number[32];
+    std::snprintf(number, sizeof(number), "%.3f", value);
+    out << number;
+  }
+
+}
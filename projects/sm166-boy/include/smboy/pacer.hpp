@@ -0,0 +1,134 @@
+/** @file smboy/pacer.hpp */
+
+#pragma once
+
+#include <smboy/common.hpp>
+
+namespace smboy
+{
+
+  /**
+   * @brief The @a `pacing_mode` enum enumerates the ways in which the @a `pacer` can hold back the
+   *        emulation thread.
+   */
+  enum pacing_mode
+  {
+    pm_unthrottled,   // Run as fast as the host allows.
+    pm_realtime,      // Run at a fixed multiple of the emulated machine's real frame rate.
+    pm_audio          // Run only as fast as the audio output consumes samples.
+  };
+
+  /**
+   * @brief The @a `pacer_stats` struct is a snapshot of the pacer's performance statistics, which
+   *        are recomputed about once per second.
+   */
+  struct pacer_stats
+  {
+    double        fps = 0.0;            // Emulated frames completed per host second.
+    double        emulated_mhz = 0.0;   // Emulated clock cycles per host second, in millions.
+    double        speed = 0.0;          // The emulation speed, relative to the real machine.
+    std::uint64_t frames = 0;           // The total number of frames paced so far.
+  };
+
+  /**
+   * @brief The @a `pacer` class keeps the emulation thread running at the desired speed. It is
+   *        owned by the frontend, and should be told about every completed frame, typically from
+   *        the renderer's vertical blank function.
+   *
+   *        In realtime mode, the pacer sleeps until each frame's deadline on a monotonic clock.
+   *        Deadlines are computed from the start of the run rather than from the previous frame,
+   *        so that sleep overshoot does not accumulate into drift.
+   */
+  class pacer
+  {
+
+  public:
+
+    /**
+     * @brief Resets the pacer's deadlines and statistics. Call this right before emulation starts.
+     *
+     * @param mode  The pacing mode to use.
+     * @param speed The speed multiplier to use in realtime mode (eg. `2.0` for double speed).
+     */
+    void initialize (pacing_mode mode, double speed = 1.0);
+
+    /**
+     * @brief Called once per completed frame, from the emulation thread. Blocks as needed to keep
+     *        the emulation at the desired speed, then updates the pacer's statistics.
+     *
+     * @param cycle_count The number of tick cycles the processor has run so far.
+     */
+    void on_frame (std::uint64_t cycle_count);
+
+  public:
+
+    /**
+     * @brief Changes the pacing mode and speed multiplier. Deadlines restart from the next frame.
+     *
+     * @note  This should be called from the emulation thread, or while it is not running.
+     */
+    void set_mode (pacing_mode mode, double speed = 1.0);
+
+    /**
+     * @brief Sets the function which the pacer uses in audio mode to check how full the audio
+     *        output's buffer is, as a fraction between `0.0` and `1.0`. The pacer waits for the
+     *        buffer to drain below its target fill level before letting the next frame run.
+     */
+    inline void set_audio_fill_function (const std::function<double()>& fn)
+    {
+      m_audio_fill = fn;
+    }
+
+    inline void set_audio_fill_target (double target) { m_audio_fill_target = target; }
+
+  public:
+
+    inline pacing_mode get_mode () const { return m_mode; }
+    inline double get_speed () const { return m_speed; }
+
+    /**
+     * @brief Indicates whether the most recent frame finished after its realtime deadline, meaning
+     *        that the emulator is running behind schedule.
+     */
+    inline bool is_behind () const { return m_behind; }
+
+    /**
+     * @brief Retrieves a snapshot of the pacer's statistics. This may be called from any thread.
+     */
+    pacer_stats get_stats () const;
+
+  private:
+
+    void wait_for_deadline ();
+    void wait_for_audio ();
+    void update_stats (std::uint64_t cycle_count);
+
+  private:
+
+    using clock = std::chrono::steady_clock;
+
+    // If the emulator falls more than this many frames behind its deadlines (eg. after a debugger
+    // pause or a slow host frame), stop trying to catch up and restart the deadlines from now.
+    static constexpr std::uint32_t max_frames_behind = 8;
+
+    pacing_mode                 m_mode = pacing_mode::pm_realtime;
+    double                      m_speed = 1.0;
+    clock::duration             m_frame_period { 0 };
+    clock::time_point           m_epoch;
+    std::uint64_t               m_epoch_frame = 0;
+    std::uint64_t               m_frame = 0;
+    bool                        m_behind = false;
+
+    std::function<double()>     m_audio_fill = nullptr;
+    double                      m_audio_fill_target = 0.5;
+
+    clock::time_point           m_stats_start;
+    std::uint64_t               m_stats_frame = 0;
+    std::uint64_t               m_stats_cycle = 0;
+    std::atomic<double>         m_fps { 0.0 };
+    std::atomic<double>         m_emulated_mhz { 0.0 };
+    std::atomic<std::uint64_t>  m_frames { 0 };
+
+  };
+
+}
@@ -0,0 +1,82 @@
+/** @file smboy/perf_counters.hpp */
+
+#pragma once
+
+#include <smboy/common.hpp>
+
+namespace smboy
+{
+
+  /**
+   * @brief The @a `bus_region` enum enumerates the regions of the address space whose accesses are
+   *        counted separately.
+   */
+  enum bus_region : std::uint8_t
+  {
+    br_rom,
+    br_wram,
+    br_sram,
+    br_vram,
+    br_oam,
+    br_stack,
+    br_hram,
+    br_io,
+    br_count
+  };
+
+  /**
+   * @brief The @a `perf_counters` struct holds the emulator's performance counters: counts of the
+   *        work the emulator has done since it was initialized.
+   *
+   *        The counters are plain integers, counted on the emulation thread as the work is done,
+   *        so they cost next to nothing to keep. They count work done, not emulated state, so
+   *        frames run speculatively and rolled back with a snapshot are counted all the same.
+   *        Take a snapshot with @a `emulator::read_counters`; subtract an earlier snapshot from a
+   *        later one to count the work done in between.
+   */
+  struct perf_counters
+  {
+    std::uint64_t instructions = 0;       // Instructions retired.
+    std::uint64_t cycles = 0;             // Tick cycles run, halted or not.
+    std::uint64_t halted_cycles = 0;      // Tick cycles run while the processor was halted.
+
+    // Bus accesses, made by the processor or by OAM DMA, to each region of the address space.
+    std::array<std::uint64_t, br_count> bus_reads {};
+    std::array<std::uint64_t, br_count> bus_writes {};
+
+    // Processor accesses to VRAM and OAM refused because the renderer was using them.
+    std::uint64_t blocked_vram = 0;
+    std::uint64_t blocked_oam = 0;
+
+    // Interrupts requested by the emulator's components, and serviced by the processor, by type.
+    std::array<std::uint64_t, 8> interrupts_requested {};
+    std::array<std::uint64_t, 8> interrupts_serviced {};
+
+    std::uint64_t dma_bytes = 0;          // Bytes copied into OAM by OAM DMA.
+    std::uint64_t frames = 0;             // Video frames completed.
+    std::uint64_t drawn_frames = 0;       // Video frames completed and drawn, not skipped.
+    std::uint64_t mixed_samples = 0;      // Samples handed to the audio context's mix function.
+    std::uint64_t output_samples = 0;     // Band-limited stereo samples handed to its output.
+  };
+
+  /**
+   * @brief Subtracts an earlier snapshot of the performance counters from a later one.
+   */
+  perf_counters operator- (const perf_counters& later, const perf_counters& earlier);
+
+  /**
+   * @brief Retrieves the name of a region of the address space, eg. `"wram"`.
+   */
+  const char* get_bus_region_name (bus_region region);
+
+  /**
+   * @brief Writes the performance counters out as a table, one counter per line, along with the
+   *        rate of each per second over the given length of time, if it's not zero.
+   *
+   * @param out       The stream to write the table to.
+   * @param counters  The counters to write out.
+   * @param seconds   The number of host seconds the counters were counted over, or zero.
+   */
+  void write_perf_counters (std::ostream& out, const perf_counters& counters, double seconds);
+
+}
@@ -18,12 +18,14 @@ namespace smboy
     /**
      * @brief Attempts to load a program file located at the given path.
      *
-     * @param path  The path to the program file to be loaded.
+     * @param path            The path to the program file to be loaded.
+     * @param use_sram_file   Whether to load SRAM from, and save it to, the program's SRAM file.
+     *                        Without it, SRAM starts out cleared and is never saved.
      *
      * @return  @a `true` if the program file is loaded and validated successfully;
      *          @a `false` otherwise.
      */
-    bool load_file (const fs::path& path);
+    bool load_file (const fs::path& path, bool use_sram_file = true);
     
     /**
      * @brief If a program file that calls for SRAM is loaded, then this method checks for an SRAM
@@ -76,6 +78,39 @@ namespace smboy
      *        this method does nothing.
      */
     void write_sram (std::uint32_t address, std::uint8_t value);
+
+    /**
+     * @brief Retrieves the realtime clock's time, as saved at the end of the program's SRAM file.
+     *
+     * @param time  Receives the saved time, in seconds since the Unix epoch.
+     *
+     * @return  @a `true` if the SRAM file held a saved time;
+     *          @a `false` otherwise, or if the program file did not call for SRAM.
+     */
+    bool get_saved_rtc_time (std::int64_t& time) const;
+
+    /**
+     * @brief Retrieves the host's time when the program's SRAM file was saved, along with the
+     *        realtime clock's time.
+     *
+     * @param time  Receives the host's time, in seconds since the Unix epoch.
+     *
+     * @return  @a `true` if the SRAM file held a saved host time;
+     *          @a `false` otherwise, including for files saved without one.
+     */
+    bool get_saved_host_time (std::int64_t& time) const;
+
+    /**
+     * @brief Sets the realtime clock's time, to be saved at the end of the program's SRAM file.
+     */
+    inline void set_rtc_time (std::int64_t time) { m_rtc_time = time; }
+
+    /**
+     * @brief Copies the program's SRAM, and the realtime clock's time to be saved with it, into a
+     *        snapshot, or restores them from one. The ROM never changes, so it is not copied.
+     */
+    void save_state (program& snapshot) const;
+    void load_state (const program& snapshot);
   
   private:
   
@@ -141,6 +176,20 @@ namespace smboy
      *        be allocated.
      */
     std::string m_sram_path = "";
+
+    /**
+     * @brief The realtime clock's time, in seconds since the Unix epoch, which is saved after the
+     *        SRAM data in the SRAM file, and whether one was loaded from that file.
+     */
+    std::int64_t m_rtc_time = 0;
+    bool m_has_saved_rtc_time = false;
+
+    /**
+     * @brief The host's time, in seconds since the Unix epoch, when the SRAM file was saved, and
+     *        whether the file held one.
+     */
+    std::int64_t m_saved_host_time = 0;
+    bool m_has_saved_host_time = false;
     
     /**
      * @brief Contains the title of the program. This is contained in the program header section.
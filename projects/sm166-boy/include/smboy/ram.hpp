@@ -86,6 +86,28 @@ namespace smboy
      * @note  If `address` is out of range, then this method does nothing.
      */
     void write_stack (std::uint32_t address, std::uint8_t value);
+
+  public:
+
+    /**
+     * @brief Copies the emulator's internal RAM into a snapshot, so that it can be restored later
+     *        with @a `load_state`.
+     *
+     *        Only the pages written to since the last save or load are copied, so the snapshot
+     *        must be the same one each time: the first save copies everything, and each save or
+     *        load after that only copies what has changed since.
+     *
+     * @param snapshot  The RAM to copy the buffers into.
+     */
+    void save_state (ram& snapshot);
+
+    /**
+     * @brief Restores the emulator's internal RAM from the snapshot it was last saved into with
+     *        @a `save_state`. Only the pages written to since then are copied back.
+     *
+     * @param snapshot  The RAM to copy the buffers from.
+     */
+    void load_state (const ram& snapshot);
   
   private:
   
@@ -103,6 +125,14 @@ namespace smboy
      * @brief The emulator's memory stack.
      */
     byte_buffer m_stack;
+
+    /**
+     * @brief One flag per page of each buffer, set when that page is written to, and cleared when
+     *        the buffer is saved into or loaded from a snapshot.
+     */
+    byte_buffer m_wram_dirty;
+    byte_buffer m_hram_dirty;
+    byte_buffer m_stack_dirty;
   
   };
 
@@ -3,21 +3,75 @@
 #pragma once
 
 #include <smboy/common.hpp>
+#include <smboy/scheduler.hpp>
 
 namespace smboy
 {
 
   class emulator;
 
+  /**
+   * @brief The @a `realtime` class emulates the SM166-Boy's realtime clock (RTC).
+   *
+   *        The clock does not read the host's clock as it runs. Instead, its time is worked out
+   *        from the processor's tick cycle count, plus an epoch: the clock's time, in seconds since
+   *        the Unix epoch, at cycle zero. The epoch is taken once - from an explicit setting, from
+   *        the time saved alongside the program's SRAM, or else from the host's clock - when the
+   *        emulator first ticks. Given the same epoch, runs are reproducible.
+   *
+   *        Like a real cartridge's clock, the clock keeps running while the emulator is closed: the
+   *        time saved with the SRAM is moved on by the host time which has passed since it was
+   *        saved.
+   *
+   *        Optionally, the clock can instead follow the host's monotonic clock, read only at the end
+   *        of each video frame, so that it keeps time with the real world even when the emulator
+   *        runs faster or slower than the real machine.
+   */
   class realtime
   {
-  
+
   public:
     void initialize (emulator* _emulator);
-    void tick ();
+
+    /**
+     * @brief The clock's coroutine. It wakes once per emulated second, sleeping on the scheduler in
+     *        between.
+     */
+    device_task run (scheduler& sched);
+
+    /**
+     * @brief Called at the end of each video frame. Updates the clock from the host's clock, if the
+     *        clock is synced to the host.
+     */
+    void on_frame ();
+
+    /**
+     * @brief Copies the clock's state into a snapshot, or restores it from one. Whether the clock
+     *        follows the host's clock is a setting, and is not part of the snapshot.
+     */
+    void save_state (realtime& snapshot) const;
+    void load_state (const realtime& snapshot);
+
+  public:
+
+    /**
+     * @brief Sets the clock's epoch explicitly, overriding the time saved with the program's SRAM
+     *        and the host's clock. Use this to make runs reproducible.
+     *
+     * @param seconds The clock's time at cycle zero, in seconds since the Unix epoch.
+     */
+    void set_epoch (std::int64_t seconds);
+
+    /**
+     * @brief Sets whether the clock follows the host's clock, rather than the emulated cycle count.
+     *        Either way, the clock carries on from its current time.
+     */
+    void set_host_sync (bool enabled);
 
   public:
     inline bool is_enabled () const { return sm_getbit(m_control, 0); }
+    inline bool is_host_synced () const { return m_host_sync; }
+    inline std::int64_t get_time () const { return m_time; }
 
   public:
     inline std::uint8_t read_reg_rts  () const { return m_seconds; }
@@ -30,14 +84,39 @@ namespace smboy
     inline void write_reg_rtc (std::uint8_t value) { m_control = value; }
 
   private:
+    void tick_second (std::uint64_t cycle_count);
+    void resolve_epoch ();
+    void set_time (std::int64_t time, bool initial = false);
+    void reschedule ();
+
+  private:
+    using host_clock = std::chrono::steady_clock;
+
     emulator*     m_emulator = nullptr;
-    std::uint16_t m_divider = 0x0000;
     std::uint8_t  m_seconds = 0x00;
     std::uint8_t  m_minutes = 0x00;
     std::uint8_t  m_hours = 0x00;
     std::uint16_t m_days = 0x00;
     std::uint8_t  m_control = 0x00;
 
+    // The clock's time at cycle zero, and its current time, in seconds since the Unix epoch. The
+    // epoch is worked out on the first tick, unless it was set explicitly.
+    std::int64_t  m_epoch = 0;
+    std::int64_t  m_time = 0;
+    bool          m_epoch_valid = false;
+    bool          m_epoch_explicit = false;
+    bool          m_started = false;
+
+    // The cycle on which the clock's next second starts.
+    std::uint64_t m_next_second_cycle = 0;
+
+    // While synced to the host's clock, the clock's time is its time when syncing started, plus the
+    // whole seconds which have passed on the host's clock since.
+    bool                    m_host_sync = false;
+    bool                    m_host_started = false;
+    host_clock::time_point  m_host_start;
+    std::int64_t            m_host_start_time = 0;
+
   };
 
 }
@@ -0,0 +1,126 @@
+/** @file smboy/render_queue.hpp */
+
+#pragma once
+
+#include <smboy/common.hpp>
+
+namespace smboy
+{
+
+  /** Render Thread Events ************************************************************************/
+
+  /**
+   * @brief The @a `render_event_type` enum enumerates the kinds of events which the renderer
+   *        forwards to its render thread, if it has one.
+   */
+  enum render_event_type : std::uint8_t
+  {
+    ret_advance,      // The render thread may catch up to the event's tick stamp.
+    ret_sync,         // The render thread should catch up to the event's tick stamp, then report.
+    ret_stop,         // The render thread should stop.
+    ret_begin_frame,  // A new frame has begun. The value is non-zero if that frame is skipped.
+    ret_vram,         // A byte was written to the current VRAM bank.
+    ret_oam,          // A byte was written to OAM, either by the CPU or by OAM DMA.
+    ret_lcdc,
+    ret_scy,
+    ret_scx,
+    ret_wy,
+    ret_wx,
+    ret_vbk,
+    ret_bcps,
+    ret_bcpd,
+    ret_obps,
+    ret_obpd,
+    ret_opri
+  };
+
+  /**
+   * @brief The @a `render_event` struct describes one event forwarded to the render thread. Each
+   *        event is stamped with the number of ticks the renderer had started when it occurred, so
+   *        that the render thread can replay it at exactly the same point in its own timeline.
+   */
+  struct render_event
+  {
+    std::uint64_t     stamp;
+    std::uint32_t     address;
+    render_event_type type;
+    std::uint8_t      value;
+  };
+
+  /** Render Queue Class **************************************************************************/
+
+  /**
+   * @brief The @a `render_queue` class is a lock-free, single-producer, single-consumer queue of
+   *        render events, used to forward events from the emulation thread's renderer to its
+   *        render thread.
+   *
+   *        To keep the producer fast, the consumer is only woken up by events which let it make
+   *        progress - advance, sync and stop events - or when the queue fills up. Ordinary events
+   *        are picked up along with the next such event.
+   *
+   * @note  Only one thread may call the producer methods, and only one thread may call the
+   *        consumer methods.
+   */
+  class render_queue
+  {
+
+  public:
+
+    render_queue ();
+
+  public: /** Producer Methods ********************************************************************/
+
+    /**
+     * @brief Pushes an event onto the queue. If the queue is full, this waits for the consumer to
+     *        make room.
+     */
+    void push (const render_event& event);
+
+    /**
+     * @brief Pushes a sync event with the given tick stamp onto the queue, then waits until the
+     *        consumer reports that it has replayed it, along with every event pushed before it.
+     *
+     *        Syncs are counted, rather than compared by tick stamp, so that a sync still waits for
+     *        the consumer if the producer's tick stamps have gone back, as when a snapshot is
+     *        loaded. Once this returns, the consumer is idle until the next event is pushed.
+     */
+    void sync (std::uint64_t stamp);
+
+  public: /** Consumer Methods ********************************************************************/
+
+    /**
+     * @brief Pops the next event from the queue, waiting for one to arrive if the queue is empty.
+     */
+    render_event pop ();
+
+    /**
+     * @brief Reports that everything up to, and including, the last sync event popped has been
+     *        replayed.
+     */
+    void report_sync ();
+
+  private:
+
+    // The number of events the queue can hold. This must be a power of two. A scanline rarely sees
+    // more than a few hundred events, so the producer should almost never have to wait.
+    static constexpr std::uint32_t capacity = 16384;
+
+    // On multi-core hosts, the consumer spins for this many checks before going to sleep, since the
+    // next scanline's events are usually only a few microseconds away. On single-core hosts,
+    // spinning would only hold up the producer.
+    static constexpr std::uint32_t max_spin_count = 4096;
+
+    render_event                            m_events[capacity];
+    std::uint32_t                           m_spin_count = 0;
+    std::uint64_t                           m_sync_count = 0;
+
+    // The head is only written by the producer, and the tail and the count of syncs replayed only
+    // by the consumer. All of them count up forever. The head and tail are masked to index into the
+    // event array.
+    alignas(64) std::atomic<std::uint32_t>  m_head { 0 };
+    alignas(64) std::atomic<std::uint32_t>  m_tail { 0 };
+    alignas(64) std::atomic<std::uint64_t>  m_synced { 0 };
+
+  };
+
+}
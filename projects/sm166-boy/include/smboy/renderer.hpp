@@ -3,6 +3,11 @@
 #pragma once
 
 #include <smboy/common.hpp>
+#include <smboy/compositor.hpp>
+#include <smboy/frame_buffer.hpp>
+#include <smboy/frame_sink.hpp>
+#include <smboy/render_queue.hpp>
+#include <smboy/scheduler.hpp>
 
 namespace smboy
 {
@@ -188,8 +193,8 @@ namespace smboy
    */
   struct pixel_fetcher
   {
-    // The pixel FIFO is a queue of color values to be pushed into the screen buffer.
-    std::uint32_t     fifo[32];
+    // The pixel FIFO is a queue of line pixel descriptors to be pushed into the line buffer.
+    line_pixel        fifo[32];
     std::uint8_t      size = 0, front = 0, rear = 0;
     
     pixel_fetch_mode  mode;     // The pixel fetcher's current mode of operation.
@@ -232,11 +237,50 @@ namespace smboy
   public:
   
     renderer ();
+    ~renderer ();
 
   public: /** Public Methods **********************************************************************/
 
     void initialize (emulator* _emulator);
-    void tick (const std::uint64_t& cycle_count);
+
+    /**
+     * @brief The renderer's coroutine. It runs the display's mode machine, sleeping on the
+     *        scheduler until the next dot on which the mode machine acts - the end of the line in
+     *        horizontal and vertical blank, and the first and last dots of object scan. The line
+     *        tick is brought up to date lazily in between.
+     */
+    device_task run (scheduler& sched);
+
+    /**
+     * @brief Called on each tick cycle. The pixel pipeline acts on every dot while drawing pixels,
+     *        so for the length of that mode, the coroutine sleeps, and the dots are stepped here
+     *        instead.
+     *
+     * @param cycle_count The processor's tick cycle count.
+     */
+    inline void tick (std::uint64_t cycle_count)
+    {
+      if (m_every_dot == true) { step_every_dot(cycle_count); }
+    }
+
+    /**
+     * @brief The OAM DMA transfer's coroutine. It copies a byte on each machine cycle while a
+     *        transfer is active, and otherwise sleeps until one is started.
+     */
+    device_task run_oam_dma (scheduler& sched);
+
+    /**
+     * @brief Copies the renderer's state - video memory, registers, pixel pipeline and frame counts
+     *        - into a snapshot, or restores it from one. The frame being drawn into the back buffer
+     *        is not part of the snapshot, so snapshots are best taken at vertical blank.
+     *
+     * @note  If the render thread is running, it is kept running. It first catches up to the
+     *        current dot, then its state is read into, or replaced by, the snapshot's. Loading a
+     *        snapshot reschedules the renderer's coroutines from the restored mode, line tick and
+     *        DMA transfer.
+     */
+    void save_state (renderer& snapshot);
+    void load_state (const renderer& snapshot);
 
   public: /* Memory Storage Accesses **************************************************************/
     
@@ -248,8 +292,16 @@ namespace smboy
 
   public: /* Screen Buffer Accesses ***************************************************************/
 
+    /**
+     * @brief Retrieves the pixels of the frame being drawn. These are RGBA pixels only if the frame
+     *        is being drawn in the @a `ff_rgba8888` format; see @a `get_screen_frame`.
+     */
     const std::uint32_t* get_screen_buffer () const;
     const std::uint8_t* get_screen_bytes () const;
+    inline const frame_data& get_screen_frame () const { return *m_screen; }
+
+    inline frame_buffer& get_frame_buffer () { return m_frames; }
+    inline const frame_buffer& get_frame_buffer () const { return m_frames; }
 
   public: /** Hardware Register Accesses **********************************************************/
   
@@ -267,33 +319,41 @@ namespace smboy
     inline std::uint8_t read_reg_obps   () const  { return m_obj_pal_spec; }
     inline std::uint8_t read_reg_opri   () const  { return m_priority_mode; }
     
-    inline void write_reg_lcdc  (std::uint8_t value)  { m_control.state = value; }
     inline void write_reg_stat  (std::uint8_t value)  { m_status.state |= (value & 0b11111000); }
-    inline void write_reg_scy   (std::uint8_t value)  { m_scroll_y = value; }
-    inline void write_reg_scx   (std::uint8_t value)  { m_scroll_x = value; }
     inline void write_reg_lyc   (std::uint8_t value)  { m_line_compare = value; }
     inline void write_reg_dma1  (std::uint32_t value) { m_dma_source |= ((value & 0xFF) << 24); }
     inline void write_reg_dma2  (std::uint32_t value) { m_dma_source |= ((value & 0xFF) << 16); }
     inline void write_reg_dma3  (std::uint32_t value) { m_dma_source |= ((value & 0xFF) <<  8); }
-    inline void write_reg_wy    (std::uint8_t value)  { m_window_y = value; }
-    inline void write_reg_wx    (std::uint8_t value)  { m_window_x = value; }
-    inline void write_reg_bcps  (std::uint8_t value)  { m_bg_pal_spec = value; }
-    inline void write_reg_obps  (std::uint8_t value)  { m_obj_pal_spec = value; }
-    inline void write_reg_opri  (std::uint8_t value)  { m_priority_mode = value; }
     
   public: /** Non-Inline Hardware Register Accesses ***********************************************/
     
     std::uint8_t read_reg_bcpd () const;
     std::uint8_t read_reg_obpd () const;
 
+    void write_reg_lcdc (std::uint8_t value);
+    void write_reg_scy (std::uint8_t value);
+    void write_reg_scx (std::uint8_t value);
     void write_reg_dma4 ();
+    void write_reg_wy (std::uint8_t value);
+    void write_reg_wx (std::uint8_t value);
     void write_reg_vbk (std::uint8_t value);
+    void write_reg_bcps (std::uint8_t value);
     void write_reg_bcpd (std::uint8_t value);
+    void write_reg_obps (std::uint8_t value);
     void write_reg_obpd (std::uint8_t value);
+    void write_reg_opri (std::uint8_t value);
 
   public: /* Other Getters ************************************************************************/
 
-    inline std::uint64_t get_fps () const { return m_fps; }
+    inline std::uint64_t get_frame_count () const { return m_frame_count; }
+    inline std::uint64_t get_drawn_frame_count () const { return m_drawn_frame_count; }
+    inline bool is_frame_skipped () const { return m_frame_skipped; }
+    inline bool is_next_frame_skipped () const { return m_skip_next_frame; }
+    inline std::uint32_t get_frame_skip () const { return m_frame_skip; }
+    inline line_compositor get_line_compositor () const { return m_compositor; }
+    inline frame_format get_frame_format () const { return m_requested_frame_format; }
+    inline bool is_render_thread_enabled () const { return m_replica != nullptr; }
+    inline frame_sink* get_frame_sink () const { return m_frame_sink; }
     
   public: /* Other Setters ************************************************************************/
   
@@ -302,8 +362,75 @@ namespace smboy
       m_on_vblank = fn;
     }
 
+    /**
+     * @brief Sets the frame sink which every drawn frame is submitted to at vertical blank, or
+     *        `nullptr` for none. Speculative frames are not submitted. The renderer does not take
+     *        ownership of the sink.
+     */
+    inline void set_frame_sink (frame_sink* sink) { m_frame_sink = sink; }
+
+    /**
+     * @brief Sets how many frames the renderer skips drawing after each frame it draws. Skipped
+     *        frames keep all of their timing, interrupts and memory access gating, but produce no
+     *        pixels and are not published to the frame buffer.
+     *
+     * @param skip  The number of frames to skip after each drawn frame. Zero draws every frame;
+     *              @a `frame_skip_all` draws none at all.
+     */
+    inline void set_frame_skip (std::uint32_t skip) { m_frame_skip = skip; }
+
+    /**
+     * @brief Requests that the next frame to begin be skipped, regardless of the fixed frame skip
+     *        setting. This is used to skip frames automatically when the emulator falls behind.
+     */
+    inline void set_skip_next_frame (bool skip) { m_skip_next_frame = skip; }
+
+    inline void set_line_compositor (line_compositor compositor)
+    {
+      m_compositor = (compositor != nullptr) ? compositor : composite_line_scalar;
+    }
+
+    /**
+     * @brief Sets the pixel format in which frames are drawn. RGB565 frames take half the memory
+     *        bandwidth of RGBA frames to publish and capture; indexed frames take a quarter, plus
+     *        a palette snapshot for each scanline on which the palette has changed. Consumers can
+     *        convert any of these back into RGBA with @a `convert_frame_to_rgba`.
+     *
+     * @note  The change takes effect at the start of the next frame.
+     */
+    inline void set_frame_format (frame_format format) { m_requested_frame_format = format; }
+
+    /**
+     * @brief Moves the drawing of pixels onto a render thread of its own, or back onto the calling
+     *        thread. The output is identical either way.
+     *
+     *        While the render thread is enabled, this renderer still keeps all of the display's
+     *        timing, interrupts, registers and memory access gating, so the CPU never has to wait
+     *        to observe any of them. Every write which affects the drawn pixels is stamped and
+     *        forwarded to the render thread, which replays it against its own copy of the renderer
+     *        and draws the scanlines, running up to a scanline behind. The two threads only meet at
+     *        vertical blank, where this renderer waits for the finished frame before calling the
+     *        vertical blank function and publishing it.
+     *
+     * @note  The change takes effect on the renderer's next dot. This should be called from the
+     *        emulation thread, or while it is not running.
+     */
+    void set_render_thread_enabled (bool enabled);
+
   private: /** Renderer State Machine *************************************************************/
 
+    void step (std::uint64_t cycle_count);
+    void step_every_dot (std::uint64_t cycle_count);
+    void catch_up (std::uint64_t cycle_count);
+    void tick_dot ();
+    std::uint64_t get_next_step_cycle () const;
+    bool acts_on_every_dot () const;
+    void reschedule ();
+    std::uint64_t get_cycle_count () const;
+
+    void begin_frame ();
+    void finish_frame ();
+
     void tick_horizontal_blank ();
     void tick_vertical_blank ();
     void tick_object_scan ();
@@ -312,22 +439,25 @@ namespace smboy
   private: /* DMA Transfer Methods ****************************************************************/
 
     void tick_oam_dma ();
+    std::uint64_t get_next_dma_cycle () const;
 
   private: /* Object Scan Methods *****************************************************************/
 
     void clear_line_objects ();
     void load_line_objects ();
 
-  private: /* Pixel Pipeline Methods **************************************************************/
+    void write_oam_byte (std::uint8_t address, std::uint8_t value);
+    void update_object_lines (std::uint8_t object_index);
+    void update_object_priority (std::uint8_t object_index);
+    void rebuild_object_lines ();
+    bool object_goes_before (std::uint8_t index_a, std::uint8_t index_b) const;
 
-    void push_color_value (std::uint32_t color_value);
-    void pop_color_value (std::uint32_t& color_value);
+  private: /* Pixel Pipeline Methods **************************************************************/
 
-    std::uint32_t get_bgw_color (std::uint8_t palette_index, std::uint8_t color_index);
-    std::uint32_t get_obj_color (std::uint8_t palette_index, std::uint8_t color_index);
+    void push_line_pixel (line_pixel pixel);
+    void pop_line_pixel (line_pixel& pixel);
 
-    std::uint32_t fetch_obj_pixel (std::uint8_t bit, std::uint8_t color_index, 
-      std::uint32_t color_value, std::uint8_t bgw_priority);
+    line_pixel fetch_obj_pixel ();
     bool try_add_pixel ();
     void shift_next_pixel ();
 
@@ -338,11 +468,31 @@ namespace smboy
 
     void process_pipeline ();
     void reset_pipeline ();
+    void composite_line ();
+    void start_frame_data ();
+
+  private: /* Palette Cache Methods ***************************************************************/
+
+    void update_bg_palette_color (std::uint8_t address);
+    void update_obj_palette_color (std::uint8_t address);
 
   private: /* Helper Methods **********************************************************************/
 
     bool is_window_visible () const;
     void increment_line_counter ();
+    void request_interrupt (interrupt_type type);
+
+  private: /* Render Thread Methods ***************************************************************/
+
+    void start_render_thread ();
+    void stop_render_thread ();
+    void sync_render_thread ();
+    void run_render_thread ();
+
+    void forward_event (render_event_type type, std::uint32_t address = 0, std::uint8_t value = 0);
+    void replay_event (const render_event& event);
+    void copy_state_from (const renderer& other);
+    void copy_pipeline_from (const renderer& other);
 
   private: /* Video Memory Storage ****************************************************************/
 
@@ -359,7 +509,40 @@ namespace smboy
     std::uint8_t                m_bg_cram[cram_size];
     std::uint8_t                m_obj_cram[cram_size];
     // std::vector<std::uint32_t>  m_screen;
-    std::uint32_t               m_screen[screen_buffer_size];
+    frame_data*                 m_screen;
+
+    // Completed frames are published here at vertical blank. `m_screen` always points to this
+    // frame buffer's back buffer.
+    frame_buffer                m_frames;
+
+  private: /* Palette Cache ***********************************************************************/
+
+    // This table holds the RGBA color values decoded from color RAM, one entry per two-byte color.
+    // The first 32 entries are decoded from the background CRAM; the last 32, from the object CRAM.
+    // It is only updated when color RAM is written to, so that retrieving a pixel's color is a
+    // single table lookup.
+    std::uint32_t               m_palette[cram_color_count * 2];
+
+    // The same colors, packed for RGB565 frames.
+    std::uint16_t               m_palette565[cram_color_count * 2];
+
+    // Set whenever the palette cache changes. Indexed frames take a new palette snapshot on the
+    // next scanline drawn after a change.
+    bool                        m_palette_dirty = true;
+
+  private: /* Line Compositing ********************************************************************/
+
+    // The line buffer holds the descriptors of the pixels pushed out of the FIFO on the current
+    // scanline. Once the scanline is complete, the compositor resolves them into palette indices,
+    // which are then stored into the screen buffer in the frame's format.
+    line_pixel                  m_line_pixels[screen_width];
+    std::uint8_t                m_line_indices[screen_width];
+    line_compositor             m_compositor = composite_line_scalar;
+    palette_expander            m_expander = expand_palette_scalar;
+
+    // The format of the frame being drawn, and the format requested for the frames to come.
+    frame_format                m_frame_format = frame_format::ff_rgba8888;
+    frame_format                m_requested_frame_format = frame_format::ff_rgba8888;
 
   private: /* Pixel Fetcher Context ***************************************************************/
 
@@ -387,20 +570,65 @@ namespace smboy
     std::uint16_t m_line_tick             = 0;
     std::uint8_t  m_window_line           = 0;
 
+    // The tick cycle up to which the line tick has been counted. The renderer only steps on the
+    // dots where the mode machine acts, and counts the dots in between when it next needs to.
+    // The replica counts its own dots up to the stamps of the events it replays.
+    std::uint64_t m_step_cycle            = 0;
+
+    // Set while the mode machine acts on every dot - that is, while drawing pixels with the display
+    // on - and so is stepped by @a `tick` rather than by its coroutine. Only set on the renderer
+    // which the CPU can see.
+    bool          m_every_dot             = false;
+
   private: /* Object Scan Values ******************************************************************/
 
     std::uint8_t  m_line_object_indices[object_count];
     std::uint8_t  m_line_object_count     = 0;
 
-  private: /* Framerate ***************************************************************************/
-
-    std::uint64_t m_current_frame = 0;
-    std::uint64_t m_fps = 0;
-    std::chrono::system_clock::time_point m_start, m_end, m_prev;
+    // The object buckets keep track of which objects reside on each visible scanline, so that
+    // object scan doesn't need to check all of OAM. Bit `n` of a line's mask is set if object `n`
+    // resides on that line. The buckets are updated whenever an object's position changes in OAM,
+    // and rebuilt whenever the object height changes.
+    std::uint64_t m_line_object_masks[screen_height];
+
+    // The range of scanlines, `[first, last)`, on which each object is currently bucketed.
+    std::uint8_t  m_object_first_line[object_count];
+    std::uint8_t  m_object_last_line[object_count];
+
+    // The indices of all objects in OAM, kept sorted in the priority order used when the low bit of
+    // the OPRI register is set: descending X position, then descending OAM index.
+    std::uint8_t  m_object_priority_order[object_count];
+
+  private: /* Frame Count and Frame Skipping ******************************************************/
+
+    std::uint64_t m_frame_count = 0;
+    std::uint64_t m_drawn_frame_count = 0;
+    std::uint32_t m_frame_skip = 0;
+    std::uint32_t m_frames_skipped = 0;
+    bool          m_skip_next_frame = false;
+    bool          m_frame_skipped = false;
+
+    // Indicates whether the pixel pipeline draws this frame's pixels on this thread. This is false
+    // on skipped frames, and whenever the render thread draws the pixels instead.
+    bool          m_draw_pixels = true;
+
+  private: /* Render Thread ***********************************************************************/
+
+    // While the render thread is enabled, this renderer forwards events through the render queue
+    // to the replica, a copy of this renderer which the render thread runs.
+    std::unique_ptr<render_queue>   m_render_queue = nullptr;
+    std::unique_ptr<renderer>       m_replica = nullptr;
+    std::thread                     m_render_thread;
+    bool                            m_render_thread_requested = false;
+
+    // Set on the replica, pointing to the renderer which forwards its events. The replica requests
+    // no interrupts, runs no OAM DMA, and leaves the completion of frames up to that renderer.
+    renderer*                       m_primary = nullptr;
     
   private: /** Handler Functions ******************************************************************/
   
     std::function<void (emulator&)> m_on_vblank = nullptr;
+    frame_sink*                     m_frame_sink = nullptr;
 
   private: /** Emulator Handle ********************************************************************/
   
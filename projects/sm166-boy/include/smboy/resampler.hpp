@@ -0,0 +1,82 @@
+/** @file smboy/resampler.hpp */
+
+#pragma once
+
+#include <smboy/common.hpp>
+
+namespace smboy
+{
+
+  /**
+   * @brief The @a `rate_resampler` class sits between the audio context's output and the audio
+   *        device, and resamples each batch of stereo frames by a ratio very close to one. The
+   *        ratio is nudged up while the device's buffer is emptier than its target fill level, and
+   *        down while it is fuller, so that the buffer settles at the target rather than slowly
+   *        running dry or overflowing as the emulated and host audio clocks drift apart.
+   *
+   *        The ratio never strays from one by more than the maximum deviation, which is small
+   *        enough that the change in pitch cannot be heard. Frames are interpolated with a cubic
+   *        Hermite spline, and the interpolation carries over from one batch to the next.
+   */
+  class rate_resampler
+  {
+
+  public:
+
+    /**
+     * @brief Starts the resampler over, forgetting the previous batch's frames.
+     */
+    void reset ();
+
+    /**
+     * @brief Resamples a batch of frames, at a ratio worked out from the device buffer's fill
+     *        level.
+     *
+     * @param samples     The frames' interleaved left and right samples.
+     * @param frame_count The number of frames to resample.
+     * @param fill_level  How full the device's buffer is, from `0.0` to `1.0`.
+     *
+     * @return  The number of resampled frames, which can be retrieved with @a `get_output`.
+     */
+    std::size_t process (const std::int16_t* samples, std::size_t frame_count, double fill_level);
+
+  public:
+
+    inline void set_fill_target (double target) { m_fill_target = std::clamp(target, 0.01, 0.99); }
+    inline void set_max_deviation (double deviation)
+      { m_max_deviation = std::clamp(deviation, 0.0, 0.05); }
+
+    inline double get_fill_target () const { return m_fill_target; }
+    inline double get_max_deviation () const { return m_max_deviation; }
+
+    /**
+     * @brief Retrieves the ratio of output frames to input frames used by the last batch.
+     */
+    inline double get_ratio () const { return m_ratio; }
+
+    /**
+     * @brief Retrieves the last batch's resampled frames, interleaved left and right.
+     */
+    inline const std::int16_t* get_output () const { return m_output.data(); }
+
+  private:
+
+    // The interpolation reaches back one frame, and ahead two frames, of the position it's at.
+    static constexpr std::size_t history_frames = 3;
+
+  private:
+
+    double                    m_fill_target = 0.5;
+    double                    m_max_deviation = 0.005;
+    double                    m_ratio = 1.0;
+
+    // The position of the next output frame, in frames from the start of the history.
+    double                    m_position = 1.0;
+
+    // The last few frames of the previous batch, followed by the current batch's frames.
+    std::vector<float>        m_input = std::vector<float>(history_frames * 2, 0.0f);
+    std::vector<std::int16_t> m_output;
+
+  };
+
+}
@@ -0,0 +1,103 @@
+/** @file smboy/scaler.hpp */
+
+#pragma once
+
+#include <smboy/common.hpp>
+
+namespace smboy
+{
+
+  /**
+   * @brief The @a `scale_filter` enum enumerates the filters with which the @a `frame_scaler` can
+   *        scale frames up on the CPU.
+   */
+  enum scale_filter : std::uint8_t
+  {
+    sf_nearest,   // Repeat each pixel N times in each direction.
+    sf_scale2x,   // Scale up 2x, rounding off diagonal edges. Also known as AdvMAME2x.
+    sf_scale3x,   // Scale up 3x, rounding off diagonal edges. Also known as AdvMAME3x.
+    sf_scale4x,   // Scale up 4x, by applying Scale2x twice.
+    sf_crt        // Repeat each pixel N times in each direction, darkening every Nth row.
+  };
+
+  /**
+   * @brief The @a `frame_scaler` class scales RGBA frames up on the CPU, so that the display
+   *        thread can upload a frame which needs no further filtering or scaling by the graphics
+   *        hardware. This matters most when the frontend runs on a software OpenGL implementation.
+   *
+   *        Each filter has a portable implementation, and SSE2 and AVX2 implementations which are
+   *        selected when the host supports them. The time taken to scale each frame is measured,
+   *        so that the filters can be compared on the host.
+   */
+  class frame_scaler
+  {
+
+  public:
+
+    frame_scaler ();
+
+  public:
+
+    /**
+     * @brief Sets the filter with which frames are scaled, and by how much.
+     *
+     * @param filter  The filter to scale frames with.
+     * @param factor  The scale factor, from 1 to 8. Only used by the nearest and CRT filters; the
+     *                ScaleNx filters always scale by N. The CRT filter needs a factor of at least 2.
+     *
+     * @return  @a `true` if the filter and factor are valid; @a `false` otherwise.
+     */
+    bool set_filter (scale_filter filter, std::uint32_t factor = 1);
+
+    /**
+     * @brief Scales a frame up with the current filter.
+     *
+     * @param pixels  The frame's `screen_buffer_size` RGBA pixels.
+     *
+     * @return  A pointer to the scaled frame's RGBA pixels, which remain valid until the next call.
+     */
+    const std::uint32_t* scale (const std::uint32_t* pixels);
+
+    /**
+     * @brief Resets the scale time measurements.
+     */
+    void reset_timing ();
+
+  public:
+
+    inline scale_filter get_filter () const { return m_filter; }
+    inline std::uint32_t get_factor () const { return m_factor; }
+    inline std::size_t get_output_width () const { return screen_width * m_factor; }
+    inline std::size_t get_output_height () const { return screen_height * m_factor; }
+    inline const char* get_implementation_name () const { return m_implementation; }
+    inline std::uint64_t get_scaled_count () const { return m_scaled_count; }
+    inline std::uint64_t get_last_time () const { return m_last_time; }
+    std::uint64_t get_average_time () const;
+
+    /**
+     * @brief Retrieves the name of the given filter, for diagnostics.
+     */
+    static const char* get_filter_name (scale_filter filter);
+
+  private:
+
+    scale_filter                m_filter = scale_filter::sf_nearest;
+    std::uint32_t               m_factor = 1;
+    const char*                 m_implementation = "scalar";
+
+    // The scaled frame, and the intermediate 2x frame used by the Scale4x filter.
+    std::vector<std::uint32_t>  m_output;
+    std::vector<std::uint32_t>  m_intermediate;
+
+    // The frame being scaled, surrounded by a border of repeated edge pixels. Used by the ScaleNx
+    // filters.
+    std::vector<std::uint32_t>  m_padded;
+
+    // Scale time measurements, in nanoseconds.
+    std::uint64_t               m_scaled_count = 0;
+    std::uint64_t               m_total_time = 0;
+    std::uint64_t               m_last_time = 0;
+
+  };
+
+}
@@ -0,0 +1,189 @@
+/** @file smboy/scheduler.hpp */
+
+#pragma once
+
+#include <smboy/common.hpp>
+
+namespace smboy
+{
+
+  /**
+   * @brief The @a `device_slot` enum enumerates the devices which run as coroutines on the
+   *        emulator's @a `scheduler`, one slot each. Slots due on the same cycle are resumed in
+   *        this order.
+   */
+  enum device_slot : std::uint8_t
+  {
+    ds_renderer,    // The renderer's mode machine.
+    ds_oam_dma,     // The renderer's OAM DMA transfer.
+    ds_timer,       // The timer's overflow and DIV-APU events.
+    ds_realtime,    // The realtime clock's seconds.
+    ds_input,       // The input queue's drains and pending events.
+    ds_count
+  };
+
+  /**
+   * @brief The @a `device_task` class owns a device's coroutine. The coroutine is started by the
+   *        @a `scheduler`, and is never expected to finish.
+   */
+  class device_task
+  {
+
+  public:
+
+    struct promise_type
+    {
+      device_task get_return_object ()
+        { return device_task { std::coroutine_handle<promise_type>::from_promise(*this) }; }
+
+      std::suspend_always initial_suspend () noexcept { return {}; }
+      std::suspend_always final_suspend () noexcept { return {}; }
+      void return_void () {}
+      void unhandled_exception () { std::terminate(); }
+    };
+
+  public:
+
+    device_task () = default;
+    explicit device_task (std::coroutine_handle<promise_type> handle) : m_handle { handle } {}
+    device_task (const device_task&) = delete;
+    device_task& operator= (const device_task&) = delete;
+
+    device_task (device_task&& other) noexcept : m_handle { std::exchange(other.m_handle, {}) } {}
+    device_task& operator= (device_task&& other) noexcept
+    {
+      if (this != &other)
+      {
+        if (m_handle) { m_handle.destroy(); }
+        m_handle = std::exchange(other.m_handle, {});
+      }
+
+      return *this;
+    }
+
+    ~device_task ()
+    {
+      if (m_handle) { m_handle.destroy(); }
+    }
+
+  public:
+    inline bool is_valid () const { return static_cast<bool>(m_handle); }
+    inline void resume () { m_handle.resume(); }
+
+  private:
+    std::coroutine_handle<promise_type> m_handle = nullptr;
+
+  };
+
+  class scheduler;
+
+  /**
+   * @brief The @a `cycle_awaiter` struct is what a device's coroutine awaits to sleep until a given
+   *        tick cycle. See @a `scheduler::wait_until`.
+   */
+  struct cycle_awaiter
+  {
+    scheduler*    owner;
+    device_slot   slot;
+    std::uint64_t cycle;
+
+    bool await_ready () const noexcept { return false; }
+    void await_suspend (std::coroutine_handle<>) const noexcept;
+    void await_resume () const noexcept {}
+  };
+
+  /**
+   * @brief The @a `scheduler` class is the emulator's central cycle scheduler.
+   *
+   *        Devices which only need to act on the odd tick cycle are written as coroutines, one per
+   *        slot, each looping over a `co_await` of @a `wait_until` (or @a `wait_cycles`) and the
+   *        work due on that cycle. The scheduler keeps the cycle each slot is waiting for, and the
+   *        earliest of these, so the emulator need only compare the cycle count against a single
+   *        value on each tick cycle, and only resumes a coroutine on the cycle it is due.
+   *
+   *        A device which learns of an earlier or later event while its coroutine is waiting - on a
+   *        register write, for instance - moves the wait with @a `reschedule`.
+   *
+   * @note  A coroutine keeps its device's state in the device itself, never in locals held across
+   *        a wait, so that the device can still be copied into and restored from snapshots.
+   */
+  class scheduler
+  {
+
+  public:
+
+    /**
+     * @brief Destroys the coroutines of all slots, leaving them empty.
+     */
+    void initialize ();
+
+    /**
+     * @brief Hands a device's coroutine to the given slot, then runs it up to its first wait.
+     */
+    void start (device_slot slot, device_task task);
+
+    /**
+     * @brief Called on each tick cycle. Only does any work once a slot is due.
+     *
+     * @param cycle_count The processor's tick cycle count.
+     */
+    inline void tick (std::uint64_t cycle_count)
+    {
+      if (cycle_count >= m_next_cycle) { run(cycle_count); }
+    }
+
+    /**
+     * @brief Moves the cycle on which the given slot's coroutine is resumed. Does nothing if the
+     *        slot has no coroutine.
+     */
+    void reschedule (device_slot slot, std::uint64_t cycle);
+
+    /**
+     * @brief Sets whether the given slot is held. Held slots are not resumed, even once due, until
+     *        they are released.
+     */
+    void set_held (device_slot slot, bool held);
+
+  public:
+
+    /**
+     * @brief Returns an awaiter which suspends the calling coroutine, in the given slot, until the
+     *        given cycle. A cycle which has already passed resumes it on the next tick cycle.
+     */
+    inline cycle_awaiter wait_until (device_slot slot, std::uint64_t cycle)
+      { return { this, slot, cycle }; }
+
+    inline cycle_awaiter wait_cycles (device_slot slot, std::uint64_t count)
+      { return { this, slot, m_cycle + count }; }
+
+  public:
+
+    /**
+     * @brief Retrieves the cycle the scheduler is running. Coroutines call this on resuming to
+     *        learn which cycle they were resumed on.
+     */
+    inline std::uint64_t get_cycle () const { return m_cycle; }
+    inline std::uint64_t get_next_cycle () const { return m_next_cycle; }
+
+  private:
+    void run (std::uint64_t cycle_count);
+    void update_next_cycle ();
+
+  private:
+
+    struct slot_state
+    {
+      device_task   task;
+      std::uint64_t cycle = std::numeric_limits<std::uint64_t>::max();
+      bool          held = false;
+    };
+
+    std::array<slot_state, device_slot::ds_count> m_slots;
+
+    // The earliest cycle any slot which isn't held is waiting for, and the cycle being run.
+    std::uint64_t m_next_cycle = std::numeric_limits<std::uint64_t>::max();
+    std::uint64_t m_cycle = 0;
+
+  };
+
+}
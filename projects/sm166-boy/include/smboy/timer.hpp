@@ -3,6 +3,7 @@
 #pragma once
 
 #include <smboy/common.hpp>
+#include <smboy/scheduler.hpp>
 
 namespace smboy
 {
@@ -32,6 +33,12 @@ namespace smboy
   /**
    * @brief The @a `timer` class is the `smboy` emulator's internal timer. This timer ticks at a
    *        configurable interval and requests an interrupt upon overflowing.
+   *
+   *        The timer is not ticked on every clock. Its divider is worked out from the processor's
+   *        tick cycle count and the cycle on which the divider was last reset, and its counter is
+   *        brought up to date only when it is accessed. The cycles of the counter's next overflow
+   *        and of the divider's next DIV-APU edge are worked out ahead of time, and the timer's
+   *        coroutine sleeps on the emulator's scheduler until the earlier of the two.
    */
   class timer
   {
@@ -39,34 +46,63 @@ namespace smboy
   public:
 
     void initialize (emulator* _emulator);
-    void tick ();
-    
+
+    /**
+     * @brief The timer's coroutine. It handles the counter's overflows, and clocks the audio
+     *        context's frame sequencer on the divider's DIV-APU edges, sleeping on the scheduler in
+     *        between. Register writes which move the next event reschedule it.
+     */
+    device_task run (scheduler& sched);
+
+    /**
+     * @brief Copies the timer's state into a snapshot, or restores it from one.
+     */
+    void save_state (timer& snapshot) const;
+    void load_state (const timer& snapshot);
+
   public:
-    inline bool audio_needs_update () const { return m_div_apu; }
+    inline std::uint64_t get_next_event_cycle () const { return m_next_event_cycle; }
     
   public:
     
-    inline std::uint8_t read_reg_div () const { return (m_divider >> 8) & 0xFF; }
-    inline std::uint8_t read_reg_tima () const { return m_counter; }
+    std::uint8_t read_reg_div () const;
+    std::uint8_t read_reg_tima ();
     inline std::uint8_t read_reg_tma () const { return m_modulo; }
     inline std::uint8_t read_reg_tac () const { return m_control.state; }
     
-    inline void write_reg_div () { m_divider = 0x0000; }
-    inline void write_reg_tima (std::uint8_t value) { m_counter = value; }
-    inline void write_reg_tma (std::uint8_t value) { m_modulo = value; }
-    inline void write_reg_tac (std::uint8_t value) { m_control.state = value; }
+    void write_reg_div ();
+    void write_reg_tima (std::uint8_t value);
+    void write_reg_tma (std::uint8_t value);
+    void write_reg_tac (std::uint8_t value);
 
   public:
-    inline std::uint16_t get_full_divider () const { return m_divider; }
+    std::uint16_t get_full_divider () const;
+
+  private:
+    bool handle_events (std::uint64_t cycle_count);
+    std::uint64_t get_cycle_count () const;
+    std::uint64_t get_counter_period () const;
+    void sync_counter (std::uint64_t cycle_count);
+    void schedule_events ();
 
   private:
 
     emulator*       m_emulator = nullptr;
-    std::uint16_t   m_divider = 0x0000;
     std::uint8_t    m_counter = 0x00;
     std::uint8_t    m_modulo  = 0x00;
     timer_control   m_control;
-    bool            m_div_apu = false;
+
+    // The divider counts up by one on every tick cycle, from the cycle on which it was last reset.
+    std::uint64_t   m_divider_reset_cycle = 0;
+
+    // The cycle up to which the counter has been brought up to date.
+    std::uint64_t   m_counter_cycle = 0;
+
+    // The cycles of the counter's next overflow, the divider's next DIV-APU edge, and whichever of
+    // the two comes first.
+    std::uint64_t   m_next_overflow_cycle = 0;
+    std::uint64_t   m_next_div_apu_cycle = 0;
+    std::uint64_t   m_next_event_cycle = 0;
 
   };
 
@@ -3,6 +3,11 @@
 #include <smboy/emulator.hpp>
 #include <smboy/audio.hpp>
 
+#if defined(__SSE2__)
+  #define SMBOY_SSE2_MIXER
+  #include <emmintrin.h>
+#endif
+
 namespace smboy
 {
 
@@ -12,6 +17,39 @@ namespace smboy
     0b00000001, 0b00000011, 0b00001111, 0b00111111
   };
 
+  /** Private Constants and Functions - Event Scheduling ******************************************/
+
+  // The step cycle of anything which is not going to step.
+  static constexpr std::uint64_t never = std::numeric_limits<std::uint64_t>::max();
+
+  // The pulse channels' period dividers are clocked every fourth cycle; the wave channel's, every
+  // other cycle.
+  static constexpr std::uint64_t pulse_divider_clock = 4;
+  static constexpr std::uint64_t wave_divider_clock = 2;
+
+  // Rounds a cycle up to the next multiple of the given clock.
+  static inline std::uint64_t round_up_cycle (std::uint64_t cycle, std::uint64_t clock)
+  {
+    return ((cycle + clock - 1) / clock) * clock;
+  }
+
+  // The number of times a period divider must be clocked, from the given value, before it
+  // overflows past $7FF and steps its channel.
+  static inline std::uint64_t get_divider_clocks (std::uint16_t divider)
+  {
+    return (divider >= 0x800) ? 1 : (0x800 - divider);
+  }
+
+  /** Private Constants - Band-Limited Output *****************************************************/
+
+  // The mixed output's amplitude, per unit of a channel's DAC output, at the lowest master volume.
+  // The four channels' DAC outputs together span -60 to 60 units, and the master volume multiplies
+  // them by up to eight, which keeps the mixed output within 16 bits.
+  static constexpr std::int32_t output_level_unit = 64;
+
+  // The band-limited output buffers hold this many seconds' worth of samples.
+  static constexpr std::uint32_t output_buffer_divisor = 10;
+
   /** Public Methods - Initialization *************************************************************/
   
   void audio::initialize (emulator* _emulator)
@@ -45,81 +83,143 @@ namespace smboy
     write_reg_nr52(0x00);
 
     set_mix_clock(44100);
+
+    // The processor's tick cycle count starts over when it is initialized. Its first cycle is
+    // cycle one.
+    m_cycle = 1;
+    m_schedule_valid = false;
+
+    // Likewise, start the band-limited output over.
+    m_left_output.clear();
+    m_right_output.clear();
+    m_output_frame_cycle = 1;
+    m_left_level = 0;
+    m_right_level = 0;
   }
   
-  /** Public Methods - Tick ***********************************************************************/
+  /** Public Methods - Update *********************************************************************/
   
-  void audio::tick (const std::uint64_t& cycle_count, bool needs_update)
+  void audio::update (std::uint64_t cycle_count)
   {
-    if (m_control.master_enable == false) { return; }
-
-    if (cycle_count % 2 == 0) { tick_wave_period_divider(); }
-    if (cycle_count % 4 == 0) { tick_pulse_period_dividers(); }
-    if (cycle_count % m_nc.clock_frequency == 0)
-      { tick_noise_divider(); }
-
-    if (needs_update == true)
+    if (cycle_count >= m_cycle)
     {
-      m_divider++;
-      if (m_divider % 2 == 0) { tick_length_timers(); }
-      if (m_divider % 4 == 0) { tick_frequency_sweep(); }
-      if (m_divider % 8 == 0) { tick_envelope_sweep(); }
+      run_until(cycle_count + 1);
     }
-
-    if (cycle_count % m_mix_clock == 0 && m_on_mix != nullptr)
-      { m_on_mix(get_sample()); }
   }
 
-  /** Public Methods - Mixing *********************************************************************/
-
-  audio_sample audio::get_sample () const
+  void audio::tick_frame_sequencer (std::uint64_t cycle_count)
   {
-    audio_sample sample;
+    if (cycle_count < m_cycle) { return; }
 
-    if (m_control.pc1_enabled && m_pc1.dac_enable)
+    // Run everything before this cycle, then the channel steps which fall on this cycle.
+    run_until(cycle_count);
+    if (m_control.master_enable == false)
     {
-      if (m_panning.pc1_left)  
-        { sample.left_input += m_pc1.dac_input;
-          sample.left_output += m_pc1.dac_output; }
-      if (m_panning.pc1_right) 
-        { sample.right_input += m_pc1.dac_input;
-          sample.right_output += m_pc1.dac_output; }
+      m_cycle = cycle_count + 1;
+      return;
     }
 
-    if (m_control.pc2_enabled && m_pc2.dac_enable)
-    {
-      if (m_panning.pc2_left)  
-        { sample.left_input += m_pc2.dac_input;
-          sample.left_output += m_pc2.dac_output; }
-      if (m_panning.pc2_right) 
-        { sample.right_input += m_pc2.dac_input;
-          sample.right_output += m_pc2.dac_output; }
-    }
+    run_channel_steps(cycle_count);
+    m_cycle = cycle_count + 1;
+    store_period_dividers();
 
-    if (m_control.wc_enabled && m_wc.dac_enable)
+    // Step the frame sequencer. This can change the channels' periods and enable states.
+    m_divider++;
+    if (m_divider % 2 == 0) { tick_length_timers(); }
+    if (m_divider % 4 == 0) { tick_frequency_sweep(); }
+    if (m_divider % 8 == 0) { tick_envelope_sweep(); }
+    m_schedule_valid = false;
+
+    // Finally, mix this cycle's sample, if one falls on it.
+    if (m_next_mix_cycle == cycle_count && m_on_mix != nullptr)
     {
-      if (m_panning.wc_left)  
-        { sample.left_input += m_wc.dac_input;
-          sample.left_output += m_wc.dac_output; }
-      if (m_panning.wc_right) 
-        { sample.right_input += m_wc.dac_input;
-          sample.right_output += m_wc.dac_output; }
+      if (m_output_muted == false)
+      {
+        m_on_mix(get_sample());
+        m_emulator->get_counters().mixed_samples++;
+      }
+
+      m_next_mix_cycle += m_mix_clock;
     }
+  }
 
-    if (m_control.nc_enabled && m_nc.dac_enable)
-    {
-      if (m_panning.nc_left)  
-        { sample.left_input += m_nc.dac_input;
-          sample.left_output += m_nc.dac_output; }
-      if (m_panning.nc_right) 
-        { sample.right_input += m_nc.dac_input;
-          sample.right_output += m_nc.dac_output; }
+  void audio::end_frame (std::uint64_t cycle_count)
+  {
+    if (m_output_enabled == false) { return; }
+
+    // Run up to, but not including, the given cycle. The frame is ended before the frame sequencer
+    // is clocked on that cycle, and it may yet step on it.
+    if (cycle_count > m_cycle) { run_until(cycle_count); }
+    flush_output(m_cycle);
+  }
+
+  bool audio::set_output_rate (std::uint32_t sample_rate)
+  {
+    m_output_enabled = false;
+    if (sample_rate == 0) { return true; }
+
+    std::size_t capacity = (sample_rate / output_buffer_divisor) + 1;
+    if (
+      m_left_output.set_rates(clock_speed, sample_rate, capacity) == false ||
+      m_right_output.set_rates(clock_speed, sample_rate, capacity) == false
+    ) {
+      return false;
     }
 
-    sample.left_input /= 4;
-    sample.right_input /= 4;
-    sample.left_output /= 4.0f;
-    sample.right_output /= 4.0f;
+    // Flush long output frames once they have filled half of the buffers.
+    m_max_output_clocks = m_left_output.get_max_frame_clocks() / 2;
+    m_output_samples.resize(capacity * 2);
+    m_output_frame_cycle = m_cycle;
+    m_left_level = 0;
+    m_right_level = 0;
+    m_output_enabled = true;
+
+    return true;
+  }
+
+  void audio::save_state (audio& snapshot) const
+  {
+    snapshot.load_state(*this);
+  }
+
+  void audio::load_state (const audio& snapshot)
+  {
+
+    // Hardware Registers
+    m_pc1 = snapshot.m_pc1;
+    m_pc2 = snapshot.m_pc2;
+    m_wc = snapshot.m_wc;
+    m_nc = snapshot.m_nc;
+    m_control = snapshot.m_control;
+    m_panning = snapshot.m_panning;
+    m_volume = snapshot.m_volume;
+    m_divider = snapshot.m_divider;
+
+    // Event Schedule
+    m_cycle = snapshot.m_cycle;
+    m_next_mix_cycle = snapshot.m_next_mix_cycle;
+    m_schedule_valid = snapshot.m_schedule_valid;
+
+    // Band-Limited Output
+    m_left_output = snapshot.m_left_output;
+    m_right_output = snapshot.m_right_output;
+    m_output_frame_cycle = snapshot.m_output_frame_cycle;
+    m_left_level = snapshot.m_left_level;
+    m_right_level = snapshot.m_right_level;
+
+  }
+
+  /** Public Methods - Mixing *********************************************************************/
+
+  audio_sample audio::get_sample () const
+  {
+    channel_mix mix = mix_channels();
+
+    audio_sample sample;
+    sample.left_input = static_cast<std::uint8_t>(mix.left_input / 4);
+    sample.right_input = static_cast<std::uint8_t>(mix.right_input / 4);
+    sample.left_output = static_cast<std::int16_t>(mix.left_output);
+    sample.right_output = static_cast<std::int16_t>(mix.right_output);
 
     return sample;
   }
@@ -128,6 +228,7 @@ namespace smboy
   
   void audio::write_reg_nr12 (std::uint8_t value)
   {
+    m_schedule_valid = false;
     m_pc1.vec.state = value;
     if ((m_pc1.vec.state & 0b11111000) == 0)
     {
@@ -142,6 +243,7 @@ namespace smboy
   
   void audio::write_reg_nr14 (std::uint8_t value)
   {
+    m_schedule_valid = false;
     m_pc1.phc.state = value;
     if (m_pc1.phc.trigger)
     {
@@ -155,6 +257,7 @@ namespace smboy
   
   void audio::write_reg_nr22 (std::uint8_t value)
   {
+    m_schedule_valid = false;
     m_pc2.vec.state = value;
     if ((m_pc2.vec.state & 0b11111000) == 0)
     {
@@ -169,6 +272,7 @@ namespace smboy
   
   void audio::write_reg_nr24 (std::uint8_t value)
   {
+    m_schedule_valid = false;
     m_pc2.phc.state = value;
     
     if (m_pc2.phc.trigger)
@@ -183,6 +287,7 @@ namespace smboy
   
   void audio::write_reg_nr30 (std::uint8_t value)
   {
+    m_schedule_valid = false;
     m_wc.dac = value;
     m_wc.dac_enable = (m_wc.dac & 0b10000000);
     if (m_wc.dac_enable == false)
@@ -193,6 +298,7 @@ namespace smboy
 
   void audio::write_reg_nr34 (std::uint8_t value)
   {
+    m_schedule_valid = false;
     m_wc.phc.state = value;
     
     if ((m_wc.phc.state & 0b10000000) == 1)
@@ -205,6 +311,7 @@ namespace smboy
 
   void audio::write_reg_nr42 (std::uint8_t value)
   {
+    m_schedule_valid = false;
     m_nc.vec.state = value;
     if ((m_nc.vec.state & 0b11111000) == 0)
     {
@@ -219,23 +326,19 @@ namespace smboy
 
   void audio::write_reg_nr43 (std::uint8_t value)
   {
+    m_schedule_valid = false;
     m_nc.lfsr.state = value;
 
-    float clock_frequency = 0.0f;
-    if (m_nc.lfsr.divider == 0)
-    {
-      clock_frequency = 262144.0f / (0.5f * std::pow(2, m_nc.lfsr.clock_shift));
-    }
-    else
-    {
-      clock_frequency = 262144.0f / (m_nc.lfsr.divider * std::pow(2, m_nc.lfsr.clock_shift));
-    }
-
-    m_nc.clock_frequency = (std::uint64_t) (4194304.0f / clock_frequency);
+    // The LFSR is clocked at 262144 / (r * 2^s) Hz, where `r` is the divider, or 0.5 if the
+    // divider is zero, and `s` is the clock shift. That's once every 16 * r * 2^s cycles.
+    m_nc.clock_frequency = (m_nc.lfsr.divider == 0) ?
+      (8ull << m_nc.lfsr.clock_shift) :
+      ((16ull * m_nc.lfsr.divider) << m_nc.lfsr.clock_shift);
   }
 
   void audio::write_reg_nr44 (std::uint8_t value)
   {
+    m_schedule_valid = false;
     m_nc.phc.state = value;
     
     if ((m_nc.phc.state & 0b10000000) == 1)
@@ -247,6 +350,12 @@ namespace smboy
     }
   }
 
+  void audio::write_reg_nr52 (std::uint8_t value)
+  {
+    m_schedule_valid = false;
+    m_control.state |= (value & 0b11110000);
+  }
+
   /* Private Methods - Ticking Methods ************************************************************/
 
   void audio::tick_length_timers ()
@@ -280,7 +389,7 @@ namespace smboy
   {
     if (m_control.pc1_enabled)
     {
-      std::uint16_t period_delta = m_pc1.current_period / std::pow(2, m_pc1.psc.step);
+      std::uint16_t period_delta = m_pc1.current_period >> m_pc1.psc.step;
       if (
         m_pc1.psc.direction == pulse_sweep_direction::psd_increase &&
         m_pc1.current_period + period_delta > 0x7FF
@@ -358,64 +467,286 @@ namespace smboy
     }
   }
 
-  void audio::tick_wave_period_divider ()
+  void audio::step_wave_channel ()
   {
-    if (m_control.wc_enabled && ++m_wc.period_divider > 0x7FF)
+    m_wc.period_divider = m_wc.current_period;
+    m_wc.sample_index = (m_wc.sample_index + 1) % (wave_ram_nibble_size);
+    m_wc.dac_input = m_wc.read_wave_ram_nibble(m_wc.sample_index);
+
+    switch (m_wc.olc.output_level)
     {
-      m_wc.period_divider = m_wc.current_period;
-      m_wc.sample_index = (m_wc.sample_index + 1) % (wave_ram_nibble_size);
-      m_wc.dac_input = m_wc.read_wave_ram_nibble(m_wc.sample_index);
+      case wave_output_level::wol_mute:     m_wc.dac_input = 0; break;
+      case wave_output_level::wol_full:     break;
+      case wave_output_level::wol_half:     m_wc.dac_input = (m_wc.dac_input >> 1) & 0b111; break;
+      case wave_output_level::wol_quarter:  m_wc.dac_input = (m_wc.dac_input >> 2) & 0b11;  break;
+      default: break;
+    }
+  }
+
+  void audio::step_pulse_channel (pulse_channel& channel)
+  {
+    channel.period_divider = channel.current_period;
+    channel.wave_pointer = (channel.wave_pointer + 1) % 8;
+    channel.dac_input = 
+      (wave_duty_patterns[channel.ldc.wave_duty_cycle] >> channel.wave_pointer) & 1;
+    channel.dac_input *= channel.current_volume;
+  }
 
-      switch (m_wc.olc.output_level)
+  void audio::step_noise_channel ()
+  {
+    std::uint8_t
+      bit0 = (m_nc.lfsr_state & 0b1),
+      bit1 = ((m_nc.lfsr_state >> 1) & 0b1),
+      bit15 = (bit0 == bit1) ? 1 : 0;
+
+    m_nc.lfsr_state |= (bit15 << 15);
+    if (m_nc.lfsr.width) { m_nc.lfsr_state |= (bit15 << 7); }
+
+    m_nc.lfsr_state >>= 1;
+    m_nc.dac_input = (m_nc.lfsr_state & 0b1) * m_nc.current_volume;
+  }
+
+  /* Private Methods - Event Scheduling ***********************************************************/
+
+  void audio::run_until (std::uint64_t end_cycle)
+  {
+
+    // Pick up any change in the output's amplitude made by register writes since the last run.
+    if (m_output_enabled == true) { add_output_deltas(m_cycle); }
+
+    // Nothing is clocked while the audio context is disabled.
+    if (m_control.master_enable == false)
+    {
+      m_cycle = end_cycle;
+      m_schedule_valid = false;
+      return;
+    }
+
+    if (m_schedule_valid == false) { schedule_events(); }
+
+    // Run from one channel step or mixed sample to the next, until the end cycle is reached.
+    while (true)
+    {
+      std::uint64_t cycle = std::min({
+        m_wc.next_step_cycle, m_pc1.next_step_cycle, m_pc2.next_step_cycle, m_nc.next_step_cycle,
+        m_next_mix_cycle
+      });
+      if (cycle >= end_cycle) { break; }
+
+      run_channel_steps(cycle);
+      if (m_output_enabled == true) { add_output_deltas(cycle); }
+      if (m_next_mix_cycle == cycle)
       {
-        case wave_output_level::wol_mute:     m_wc.dac_input = 0; break;
-        case wave_output_level::wol_full:     break;
-        case wave_output_level::wol_half:     m_wc.dac_input = (m_wc.dac_input >> 1) & 0b111; break;
-        case wave_output_level::wol_quarter:  m_wc.dac_input = (m_wc.dac_input >> 2) & 0b11;  break;
-        default: break;
+        if (m_output_muted == false)
+        {
+          m_on_mix(get_sample());
+          m_emulator->get_counters().mixed_samples++;
+        }
+
+        m_next_mix_cycle += m_mix_clock;
       }
+    }
+
+    m_cycle = end_cycle;
+    store_period_dividers();
 
-      m_wc.dac_output = -(((float) m_wc.dac_input / 7.5f) - 1.0f);
+  }
+
+  void audio::run_channel_steps (std::uint64_t cycle)
+  {
+
+    // Channels which step on the same cycle do so in this order: wave, pulse 1, pulse 2, noise.
+    if (m_wc.next_step_cycle == cycle)
+    {
+      step_wave_channel();
+      m_wc.next_step_cycle += wave_divider_clock * get_divider_clocks(m_wc.period_divider);
     }
+
+    if (m_pc1.next_step_cycle == cycle)
+    {
+      step_pulse_channel(m_pc1);
+      m_pc1.next_step_cycle += pulse_divider_clock * get_divider_clocks(m_pc1.period_divider);
+    }
+
+    if (m_pc2.next_step_cycle == cycle)
+    {
+      step_pulse_channel(m_pc2);
+      m_pc2.next_step_cycle += pulse_divider_clock * get_divider_clocks(m_pc2.period_divider);
+    }
+
+    if (m_nc.next_step_cycle == cycle)
+    {
+      step_noise_channel();
+      m_nc.next_step_cycle += m_nc.clock_frequency;
+    }
+
   }
 
-  void audio::tick_pulse_period_dividers ()
+  void audio::schedule_events ()
   {
-    if (m_control.pc1_enabled && ++m_pc1.period_divider > 0x7FF)
+
+    // A channel's period divider is clocked from the first clock edge at or after the current
+    // cycle, and steps the channel once it overflows. Disabled channels' dividers are not clocked.
+    auto schedule_divider = [this] (bool enabled, std::uint16_t divider, std::uint64_t clock)
     {
-      m_pc1.period_divider = m_pc1.current_period;
-      m_pc1.wave_pointer = (m_pc1.wave_pointer + 1) % 8;
-      m_pc1.dac_input = 
-        (wave_duty_patterns[m_pc1.ldc.wave_duty_cycle] >> m_pc1.wave_pointer) & 1;
-      m_pc1.dac_input *= m_pc1.current_volume;
-      m_pc1.dac_output = -(((float) m_pc1.dac_input / 7.5f) - 1.0f);
+      if (enabled == false) { return never; }
+      return round_up_cycle(m_cycle, clock) + clock * (get_divider_clocks(divider) - 1);
+    };
+
+    m_wc.next_step_cycle = schedule_divider(m_control.wc_enabled, m_wc.period_divider,
+      wave_divider_clock);
+    m_pc1.next_step_cycle = schedule_divider(m_control.pc1_enabled, m_pc1.period_divider,
+      pulse_divider_clock);
+    m_pc2.next_step_cycle = schedule_divider(m_control.pc2_enabled, m_pc2.period_divider,
+      pulse_divider_clock);
+
+    // The noise channel's LFSR is clocked whether or not the channel is enabled.
+    m_nc.next_step_cycle = round_up_cycle(m_cycle, m_nc.clock_frequency);
+
+    // Samples are only mixed if there is somewhere to send them.
+    m_next_mix_cycle = (m_on_mix != nullptr) ? round_up_cycle(m_cycle, m_mix_clock) : never;
+
+    m_schedule_valid = true;
+
+  }
+
+  void audio::store_period_dividers ()
+  {
+
+    // Work out what each enabled channel's period divider would hold by now, had it been clocked
+    // on every clock edge since it last stepped, so that the schedule can be rebuilt from it.
+    auto store_divider = [this] (std::uint16_t& divider, std::uint64_t next_step_cycle,
+      std::uint64_t clock)
+    {
+      if (next_step_cycle == never) { return; }
+
+      std::uint64_t clocks_left = ((next_step_cycle - round_up_cycle(m_cycle, clock)) / clock) + 1;
+      divider = static_cast<std::uint16_t>(0x800 - clocks_left);
+    };
+
+    if (m_schedule_valid == false) { return; }
+    store_divider(m_wc.period_divider, m_wc.next_step_cycle, wave_divider_clock);
+    store_divider(m_pc1.period_divider, m_pc1.next_step_cycle, pulse_divider_clock);
+    store_divider(m_pc2.period_divider, m_pc2.next_step_cycle, pulse_divider_clock);
+
+  }
+
+  /* Private Methods - Mixing *********************************************************************/
+
+  audio::channel_mix audio::mix_channels () const
+  {
+
+    // Work out which of the eight channel/side lanes are mixed: lanes 0 - 3 are pulse 1, pulse 2,
+    // wave and noise on the left side, and lanes 4 - 7 are the same on the right side. A channel is
+    // mixed into a side if it is enabled, its DAC is on, and it's panned to that side.
+    std::uint32_t enabled = m_control.state & (
+      (m_pc1.dac_enable ? 0b0001 : 0) | (m_pc2.dac_enable ? 0b0010 : 0) |
+      (m_wc.dac_enable  ? 0b0100 : 0) | (m_nc.dac_enable  ? 0b1000 : 0)
+    );
+    std::uint32_t lanes = ((m_panning.state >> 4) & enabled) | ((m_panning.state & enabled) << 4);
+
+    channel_mix mix;
+
+#if defined(SMBOY_SSE2_MIXER)
+
+    // Turn the lane bits into a lane mask, then sum each side's masked DAC inputs and outputs.
+    // Each channel's DAC maps its input from 0 - 15 onto an output of 15 down to -15.
+    const __m128i lane_bits = _mm_setr_epi16(1, 2, 4, 8, 16, 32, 64, 128);
+    const __m128i ones = _mm_set1_epi16(1);
+
+    __m128i mask = _mm_cmpeq_epi16(
+      _mm_and_si128(_mm_set1_epi16(static_cast<std::int16_t>(lanes)), lane_bits),
+      lane_bits
+    );
+    __m128i input = _mm_setr_epi16(
+      m_pc1.dac_input, m_pc2.dac_input, m_wc.dac_input, m_nc.dac_input,
+      m_pc1.dac_input, m_pc2.dac_input, m_wc.dac_input, m_nc.dac_input
+    );
+    __m128i output = _mm_sub_epi16(_mm_set1_epi16(15), _mm_add_epi16(input, input));
+
+    // Pairs of lanes are summed into four sums - two per side - and those into one sum per side.
+    __m128i input_sums = _mm_madd_epi16(_mm_and_si128(input, mask), ones);
+    __m128i output_sums = _mm_madd_epi16(_mm_and_si128(output, mask), ones);
+    input_sums = _mm_add_epi32(input_sums, _mm_shuffle_epi32(input_sums, _MM_SHUFFLE(2, 3, 0, 1)));
+    output_sums = _mm_add_epi32(output_sums,
+      _mm_shuffle_epi32(output_sums, _MM_SHUFFLE(2, 3, 0, 1)));
+
+    mix.left_input = _mm_cvtsi128_si32(input_sums);
+    mix.right_input = _mm_cvtsi128_si32(_mm_srli_si128(input_sums, 8));
+    mix.left_output = _mm_cvtsi128_si32(output_sums);
+    mix.right_output = _mm_cvtsi128_si32(_mm_srli_si128(output_sums, 8));
+
+#else
+
+    const std::uint8_t inputs[4] = {
+      m_pc1.dac_input, m_pc2.dac_input, m_wc.dac_input, m_nc.dac_input
+    };
+
+    mix = { 0, 0, 0, 0 };
+    for (std::uint32_t channel = 0; channel < 4; ++channel)
+    {
+      std::int32_t output = 15 - 2 * static_cast<std::int32_t>(inputs[channel]);
+      if (lanes & (1 << channel))       { mix.left_input += inputs[channel];
+                                          mix.left_output += output; }
+      if (lanes & (1 << (channel + 4))) { mix.right_input += inputs[channel];
+                                          mix.right_output += output; }
+    }
+
+#endif
+
+    // Apply the master volume, from one to eight.
+    mix.left_output *= (m_volume.left_volume + 1) * output_level_unit;
+    mix.right_output *= (m_volume.right_volume + 1) * output_level_unit;
+
+    return mix;
+
+  }
+
+  /* Private Methods - Band-Limited Output ********************************************************/
+
+  void audio::add_output_deltas (std::uint64_t cycle)
+  {
+
+    // If no video frame has ended in a long while, flush the output frame now, so that the buffers
+    // don't overflow.
+    if (cycle - m_output_frame_cycle >= m_max_output_clocks) { flush_output(cycle); }
+
+    channel_mix mix = mix_channels();
+    std::int32_t left = mix.left_output, right = mix.right_output;
+
+    if (left != m_left_level)
+    {
+      m_left_output.add_delta(cycle - m_output_frame_cycle, left - m_left_level);
+      m_left_level = left;
     }
 
-    if (m_control.pc2_enabled && ++m_pc2.period_divider > 0x7FF)
+    if (right != m_right_level)
     {
-      m_pc2.period_divider = m_pc2.current_period;
-      m_pc2.wave_pointer = (m_pc2.wave_pointer + 1) % 8;
-      m_pc2.dac_input = 
-        (wave_duty_patterns[m_pc2.ldc.wave_duty_cycle] >> m_pc2.wave_pointer) & 1;
-      m_pc2.dac_input *= m_pc2.current_volume;
-      m_pc2.dac_output = -(((float) m_pc2.dac_input / 7.5f) - 1.0f);
+      m_right_output.add_delta(cycle - m_output_frame_cycle, right - m_right_level);
+      m_right_level = right;
     }
+
   }
 
-  void audio::tick_noise_divider ()
+  void audio::flush_output (std::uint64_t cycle)
   {
-    std::uint8_t
-      bit0 = (m_nc.lfsr_state & 0b1),
-      bit1 = ((m_nc.lfsr_state >> 1) & 0b1),
-      bit15 = (bit0 == bit1) ? 1 : 0;
 
-    m_nc.lfsr_state |= (bit15 << 15);
-    if (m_nc.lfsr.width) { m_nc.lfsr_state |= (bit15 << 7); }
+    // End the output frame just before the given cycle, and start the next one on it.
+    m_left_output.end_frame(cycle - m_output_frame_cycle);
+    m_right_output.end_frame(cycle - m_output_frame_cycle);
+    m_output_frame_cycle = cycle;
+
+    // Read both channels' samples out, interleaved, and hand them over.
+    std::size_t frame_count = m_left_output.read_samples(m_output_samples.data(),
+      m_output_samples.size() / 2, 2);
+    m_right_output.read_samples(m_output_samples.data() + 1, frame_count, 2);
+
+    if (frame_count > 0 && m_on_output != nullptr && m_output_muted == false)
+    {
+      m_on_output(m_output_samples.data(), frame_count);
+      m_emulator->get_counters().output_samples += frame_count;
+    }
 
-    m_nc.lfsr_state >>= 1;
-    m_nc.dac_input = (m_nc.lfsr_state & 0b1) * m_nc.current_volume;
-    m_nc.dac_output = -(((float) m_nc.dac_input / 7.5f) - 1.0f);
   }
 
 }
-
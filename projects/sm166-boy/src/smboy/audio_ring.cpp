@@ -0,0 +1,64 @@
+/** @file smboy/audio_ring.cpp */
+
+#include <smboy/audio_ring.hpp>
+
+namespace smboy
+{
+
+  audio_ring::audio_ring (std::size_t frame_capacity)
+  {
+    m_capacity = 1;
+    while (m_capacity < frame_capacity) { m_capacity <<= 1; }
+
+    m_samples.resize(m_capacity * 2);
+  }
+
+  /** Producer Methods ****************************************************************************/
+
+  std::size_t audio_ring::push (const std::int16_t* samples, std::size_t frame_count)
+  {
+    std::uint32_t head = m_head.load(std::memory_order_relaxed);
+    std::uint32_t tail = m_tail.load(std::memory_order_acquire);
+
+    std::size_t space = m_capacity - (head - tail);
+    if (frame_count > space)
+    {
+      m_overruns.fetch_add(1, std::memory_order_relaxed);
+      frame_count = space;
+    }
+
+    // Copy the frames in, in two parts if they wrap around the end of the ring.
+    std::size_t start = head & (m_capacity - 1);
+    std::size_t first = std::min<std::size_t>(frame_count, m_capacity - start);
+    std::copy_n(samples, first * 2, m_samples.data() + start * 2);
+    std::copy_n(samples + first * 2, (frame_count - first) * 2, m_samples.data());
+
+    m_head.store(head + static_cast<std::uint32_t>(frame_count), std::memory_order_release);
+    return frame_count;
+  }
+
+  /** Consumer Methods ****************************************************************************/
+
+  std::size_t audio_ring::pop (std::int16_t* output, std::size_t frame_count)
+  {
+    std::uint32_t tail = m_tail.load(std::memory_order_relaxed);
+    std::uint32_t head = m_head.load(std::memory_order_acquire);
+
+    std::size_t available = head - tail;
+    if (frame_count > available)
+    {
+      m_underruns.fetch_add(1, std::memory_order_relaxed);
+      frame_count = available;
+    }
+
+    // Copy the frames out, in two parts if they wrap around the end of the ring.
+    std::size_t start = tail & (m_capacity - 1);
+    std::size_t first = std::min<std::size_t>(frame_count, m_capacity - start);
+    std::copy_n(m_samples.data() + start * 2, first * 2, output);
+    std::copy_n(m_samples.data(), (frame_count - first) * 2, output + first * 2);
+
+    m_tail.store(tail + static_cast<std::uint32_t>(frame_count), std::memory_order_release);
+    return frame_count;
+  }
+
+}
@@ -0,0 +1,169 @@
+/** @file smboy/audio_sink.cpp */
+
+#include <smboy/audio_sink.hpp>
+
+namespace smboy
+{
+
+  /** Private Functions - Little-Endian Output ****************************************************/
+
+  static void write_u16_le (std::ofstream& file, std::uint16_t value)
+  {
+    char bytes[2] = { static_cast<char>(value & 0xFF), static_cast<char>(value >> 8) };
+    file.write(bytes, sizeof(bytes));
+  }
+
+  static void write_u32_le (std::ofstream& file, std::uint32_t value)
+  {
+    write_u16_le(file, value & 0xFFFF);
+    write_u16_le(file, value >> 16);
+  }
+
+  /** Constructor and Destructor ******************************************************************/
+
+  audio_sink::audio_sink () :
+    m_ring { ring_frames }
+  {
+
+  }
+
+  audio_sink::~audio_sink ()
+  {
+    close();
+  }
+
+  /** Public Methods ******************************************************************************/
+
+  bool audio_sink::open (const fs::path& path, audio_capture_format format,
+    std::uint32_t sample_rate)
+  {
+    close();
+
+    m_format = format;
+    m_sample_rate = sample_rate;
+
+    m_file.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (m_file.is_open() == false) {
+      std::cerr <<  "[audio_sink] "
+                <<  "Could not open capture file '" << path << "' for writing." << std::endl;
+      return false;
+    }
+
+    // The WAV header's sizes aren't known until the sink is closed, so they're filled in then.
+    if (m_format == audio_capture_format::acf_wav)
+    {
+      write_wav_header(0);
+    }
+
+    // Start the writer thread.
+    m_written.store(0);
+    m_dropped.store(0);
+    m_stopping.store(false);
+    m_chunk.resize(chunk_frames * 2);
+    m_writer = std::thread { &audio_sink::run_writer, this };
+
+    return true;
+  }
+
+  void audio_sink::close ()
+  {
+    if (m_writer.joinable() == false) { return; }
+
+    // The writer thread drains the ring before it stops.
+    m_stopping.store(true, std::memory_order_release);
+    m_writer.join();
+
+    if (m_format == audio_capture_format::acf_wav)
+    {
+      m_file.seekp(0);
+      write_wav_header(m_written.load());
+    }
+
+    m_file.close();
+
+    if (m_dropped.load() > 0)
+    {
+      std::cerr <<  "[audio_sink] "
+                <<  "Dropped " << m_dropped.load() << " frame(s) because the writer fell behind."
+                <<  std::endl;
+    }
+  }
+
+  void audio_sink::submit (const std::int16_t* samples, std::size_t frame_count)
+  {
+    if (m_writer.joinable() == false) { return; }
+
+    std::size_t pushed = m_ring.push(samples, frame_count);
+    if (pushed < frame_count)
+    {
+      m_dropped.fetch_add(frame_count - pushed, std::memory_order_relaxed);
+    }
+  }
+
+  /** Private Methods *****************************************************************************/
+
+  void audio_sink::run_writer ()
+  {
+    while (true)
+    {
+
+      // Check whether to stop before draining the ring, so that nothing submitted before the sink
+      // was closed is left behind.
+      bool stopping = m_stopping.load(std::memory_order_acquire);
+      std::size_t frame_count = m_ring.pop(m_chunk.data(), chunk_frames);
+      if (frame_count == 0)
+      {
+        if (stopping == true) {
+          break;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        continue;
+      }
+
+      // PCM data is always little-endian.
+      if constexpr (std::endian::native == std::endian::big)
+      {
+        for (std::size_t i = 0; i < frame_count * 2; ++i)
+        {
+          std::uint16_t sample = static_cast<std::uint16_t>(m_chunk[i]);
+          m_chunk[i] = static_cast<std::int16_t>((sample >> 8) | (sample << 8));
+        }
+      }
+
+      m_file.write(reinterpret_cast<const char*>(m_chunk.data()), frame_count * 4);
+      m_written.fetch_add(frame_count, std::memory_order_relaxed);
+
+    }
+
+    m_file.flush();
+  }
+
+  void audio_sink::write_wav_header (std::uint64_t frame_count)
+  {
+
+    // A canonical 44-byte WAV header, describing 16-bit stereo PCM. Sizes are capped at what the
+    // format's 32-bit fields can hold.
+    std::uint32_t data_size = static_cast<std::uint32_t>(
+      std::min<std::uint64_t>(frame_count * 4, 0xFFFFFFFF - 36)
+    );
+
+    m_file.write("RIFF", 4);
+    write_u32_le(m_file, 36 + data_size);
+    m_file.write("WAVE", 4);
+
+    m_file.write("fmt ", 4);
+    write_u32_le(m_file, 16);
+    write_u16_le(m_file, 1);
+    write_u16_le(m_file, 2);
+    write_u32_le(m_file, m_sample_rate);
+    write_u32_le(m_file, m_sample_rate * 4);
+    write_u16_le(m_file, 4);
+    write_u16_le(m_file, 16);
+
+    m_file.write("data", 4);
+    write_u32_le(m_file, data_size);
+
+  }
+
+}
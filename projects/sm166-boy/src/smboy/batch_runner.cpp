@@ -0,0 +1,249 @@
+/** @file smboy/batch_runner.cpp */
+
+#include <smboy/emulator.hpp>
+#include <smboy/frame_sink.hpp>
+#include <smboy/batch_runner.hpp>
+#include <smboy/json.hpp>
+
+namespace smboy
+{
+
+  /** Public Methods ******************************************************************************/
+
+  std::vector<batch_result> batch_runner::run (const std::vector<batch_job>& jobs,
+    std::uint32_t thread_count)
+  {
+    m_jobs = &jobs;
+    m_results.assign(jobs.size(), batch_result {});
+    if (jobs.empty() == true) { return m_results; }
+
+    // Use one worker per host core by default, but never more workers than there are jobs.
+    if (thread_count == 0)
+    {
+      thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    thread_count = static_cast<std::uint32_t>(
+      std::min<std::size_t>(thread_count, jobs.size())
+    );
+
+    // Deal the jobs out to the workers' queues in turn.
+    m_queues.clear();
+    for (std::uint32_t i = 0; i < thread_count; ++i)
+    {
+      m_queues.push_back(std::make_unique<work_queue>());
+    }
+
+    for (std::size_t i = 0; i < jobs.size(); ++i)
+    {
+      m_queues[i % thread_count]->jobs.push_back(i);
+    }
+
+    // The calling thread works as the first worker.
+    std::vector<std::thread> threads;
+    for (std::uint32_t i = 1; i < thread_count; ++i)
+    {
+      threads.emplace_back(&batch_runner::run_worker, this, i);
+    }
+
+    run_worker(0);
+    for (auto& thread : threads)
+    {
+      thread.join();
+    }
+
+    m_queues.clear();
+    m_jobs = nullptr;
+    return std::move(m_results);
+  }
+
+  const char* batch_runner::get_status_name (batch_status status)
+  {
+    switch (status)
+    {
+      case batch_status::bs_pending:  return "pending";
+      case batch_status::bs_limited:  return "limited";
+      case batch_status::bs_stopped:  return "stopped";
+      case batch_status::bs_failed:   return "failed";
+      default:                        return "unknown";
+    }
+  }
+
+  void batch_runner::write_json (std::ostream& out, const std::vector<batch_job>& jobs,
+    const std::vector<batch_result>& results)
+  {
+    out << "[";
+    for (std::size_t i = 0; i < jobs.size() && i < results.size(); ++i)
+    {
+      const batch_result& result = results[i];
+      out << ((i == 0) ? "\n" : ",\n") << "  { \"program\": ";
+      write_json_string(out, jobs[i].program_file.string());
+      out << ", \"status\": \"" << get_status_name(result.status) << "\""
+          << ", \"frames\": " << result.frames
+          << ", \"cycles\": " << result.cycles
+          << ", \"instructions\": " << result.instructions
+          << ", \"seconds\": ";
+      write_json_number(out, result.seconds);
+      out << ", \"dropped_frames\": " << result.dropped_frames
+          << ", \"worker\": " << result.worker << " }";
+    }
+    out << ((jobs.empty() == true || results.empty() == true) ? "]\n" : "\n]\n");
+  }
+
+  /** Private Methods *****************************************************************************/
+
+  void batch_runner::run_worker (std::uint32_t worker)
+  {
+    std::size_t job = 0;
+    while (take_job(worker, job) == true)
+    {
+      batch_result result = run_job((*m_jobs)[job]);
+      result.worker = worker;
+
+      // Each job's result has a slot of its own, so no lock is needed to fill it in.
+      m_results[job] = result;
+    }
+  }
+
+  bool batch_runner::take_job (std::uint32_t worker, std::size_t& job)
+  {
+
+    // Take the next job from the front of the worker's own queue.
+    {
+      work_queue& own = *m_queues[worker];
+      std::lock_guard<std::mutex> lock { own.mutex };
+      if (own.jobs.empty() == false)
+      {
+        job = own.jobs.front();
+        own.jobs.pop_front();
+        return true;
+      }
+    }
+
+    // Failing that, steal a job from the back of another worker's queue. No jobs are added once
+    // the batch starts, so once every queue is empty, the worker is done.
+    for (std::size_t i = 1; i < m_queues.size(); ++i)
+    {
+      work_queue& victim = *m_queues[(worker + i) % m_queues.size()];
+      std::lock_guard<std::mutex> lock { victim.mutex };
+      if (victim.jobs.empty() == false)
+      {
+        job = victim.jobs.back();
+        victim.jobs.pop_back();
+        return true;
+      }
+    }
+
+    return false;
+
+  }
+
+  batch_result batch_runner::run_job (const batch_job& job)
+  {
+    batch_result result;
+    auto start_time = std::chrono::steady_clock::now();
+
+    // Emulator instances are large, so keep each one on the heap. Jobs neither read nor write SRAM
+    // files, so that jobs running the same program don't share, or race on, any state.
+    auto emu = std::make_unique<emulator>();
+    emu->initialize();
+    emu->get_realtime().set_epoch(job.rtc_epoch);
+    if (emu->get_program().load_file(job.program_file, false) == false)
+    {
+      result.status = batch_status::bs_failed;
+      return result;
+    }
+
+    if (job.input_replay.empty() == false &&
+        emu->get_input().load_replay(job.input_replay) == false)
+    {
+      result.status = batch_status::bs_failed;
+      return result;
+    }
+
+    // The frame hashes are compared against golden runs, so the sink must not drop any of them.
+    frame_sink sink;
+    if (job.frame_hash_path.empty() == false)
+    {
+      if (sink.open({}, frame_capture_format::fcf_none, 1, job.frame_hash_path, true) == false)
+      {
+        result.status = batch_status::bs_failed;
+        return result;
+      }
+
+      emu->get_renderer().set_frame_sink(&sink);
+    }
+
+    // A frame ends at vertical blank, or once a frame's worth of cycles has passed without one - as
+    // when the LCD is off - so that frame limits are reached either way.
+    bool limited = false;
+    std::uint64_t frame_start_cycle = 0;
+    auto end_frame = [&] (emulator& e)
+    {
+      result.frames++;
+      frame_start_cycle = e.get_processor().get_tick_cycles();
+      if (job.on_frame != nullptr)
+      {
+        job.on_frame(e, result.frames);
+      }
+
+      if (job.max_frames != 0 && result.frames >= job.max_frames)
+      {
+        limited = true;
+        e.stop();
+      }
+    };
+
+    emu->get_renderer().set_vblank_function(end_frame);
+
+    if (job.on_start != nullptr)
+    {
+      job.on_start(*emu);
+    }
+
+    // Run until a limit is reached, or the program stops the processor. A job with no limits runs
+    // until the program stops.
+    sm::processor& cpu = emu->get_processor();
+    bool failed = false;
+    while (emu->is_running() == true)
+    {
+
+      // Steps taken while the processor is halted don't execute an instruction.
+      bool halted = cpu.check_flag(sm::processor_flag_type::halt);
+      if (emu->step() == false)
+      {
+        failed = true;
+        break;
+      }
+
+      if (halted == false) { result.instructions++; }
+      if (cpu.get_tick_cycles() - frame_start_cycle >= ticks_per_frame)
+      {
+        end_frame(*emu);
+      }
+
+      if (job.max_cycles != 0 && cpu.get_tick_cycles() >= job.max_cycles)
+      {
+        limited = true;
+        break;
+      }
+
+    }
+
+    emu->stop();
+    emu->get_renderer().set_frame_sink(nullptr);
+    sink.close();
+    result.dropped_frames = sink.get_dropped_count();
+
+    if (failed == true)       { result.status = batch_status::bs_failed; }
+    else if (limited == true) { result.status = batch_status::bs_limited; }
+    else                      { result.status = batch_status::bs_stopped; }
+
+    result.cycles = cpu.get_tick_cycles();
+    result.seconds = std::chrono::duration<double> {
+      std::chrono::steady_clock::now() - start_time
+    }.count();
+
+    return result;
+  }
+
+}
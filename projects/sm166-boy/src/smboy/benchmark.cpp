@@ -0,0 +1,287 @@
+/** @file smboy/benchmark.cpp */
+
+#include <smboy/emulator.hpp>
+#include <smboy/benchmark.hpp>
+#include <smboy/json.hpp>
+
+#if defined(SM166_LINUX)
+  #include <pthread.h>
+  #include <sched.h>
+  #include <sys/resource.h>
+#endif
+
+namespace smboy
+{
+
+  /** Private Functions ***************************************************************************/
+
+  // Picks the given percentile out of a set of samples, by the nearest-rank method. The samples are
+  // reordered.
+  static double get_percentile (std::vector<double>& samples, double percentile)
+  {
+    if (samples.empty() == true) { return 0.0; }
+
+    std::size_t rank = static_cast<std::size_t>(std::ceil(percentile * samples.size()));
+    std::size_t index = (rank > 0) ? (rank - 1) : 0;
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+  }
+
+  /** Public Methods ******************************************************************************/
+
+  bool benchmark::run (emulator& emu, const benchmark_options& options)
+  {
+    m_options = options;
+    m_results.clear();
+    m_completed = false;
+    m_title = emu.get_program().get_title();
+
+    m_pinned = false;
+    if (m_options.core >= 0)
+    {
+      m_pinned = pin_to_core(m_options.core);
+      if (m_pinned == false)
+      {
+        std::cerr <<  "[benchmark] "
+                  <<  "Could not pin the benchmark to core " << m_options.core << "." << std::endl;
+      }
+    }
+
+    // Warm up first - filling caches, settling the host's clock speed and so on - without keeping
+    // any measurements.
+    if (run_frames(emu, m_options.warmup_frames, 0.0, false) == false)
+    {
+      return false;
+    }
+
+    for (std::uint32_t i = 0; i < m_options.repeat; ++i)
+    {
+      if (run_frames(emu, m_options.frames, m_options.seconds, true) == false)
+      {
+        return false;
+      }
+    }
+
+    m_completed = true;
+    return true;
+  }
+
+  void benchmark::on_frame ()
+  {
+    clock::time_point now = clock::now();
+    if (m_measuring == true)
+    {
+      m_frame_times.push_back(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_frame_time).count()
+      );
+    }
+
+    m_frame_time = now;
+    m_frame_count++;
+  }
+
+  void benchmark::write_json (std::ostream& out) const
+  {
+    out << "{\n";
+
+    out << "  \"program\": ";
+    write_json_string(out, m_title);
+    out << ",\n";
+
+    out << "  \"options\": { "
+        << "\"frames\": " << ((m_options.seconds > 0.0) ? 0 : m_options.frames) << ", "
+        << "\"seconds\": ";
+    write_json_number(out, m_options.seconds);
+    out << ", "
+        << "\"warmup_frames\": " << m_options.warmup_frames << ", "
+        << "\"repeat\": " << m_options.repeat << ", "
+        << "\"core\": " << m_options.core << ", "
+        << "\"pinned\": " << ((m_pinned == true) ? "true" : "false") << " },\n";
+
+    out << "  \"completed\": " << ((m_completed == true) ? "true" : "false") << ",\n";
+
+    // Each run's results, then the median of each rate across the runs.
+    std::vector<double> fps, instructions_per_second, emulated_mhz, frame_ns_p50, frame_ns_p99;
+    out << "  \"runs\": [";
+    for (std::size_t i = 0; i < m_results.size(); ++i)
+    {
+      const benchmark_result& result = m_results[i];
+      out << ((i == 0) ? "\n" : ",\n")
+          << "    { \"frames\": " << result.frames
+          << ", \"instructions\": " << result.instructions
+          << ", \"cycles\": " << result.cycles
+          << ", \"seconds\": ";
+      write_json_number(out, result.seconds);
+      out << ", \"fps\": ";
+      write_json_number(out, result.fps);
+      out << ", \"instructions_per_second\": ";
+      write_json_number(out, result.instructions_per_second);
+      out << ", \"emulated_mhz\": ";
+      write_json_number(out, result.emulated_mhz);
+      out << ", \"frame_ns_p50\": ";
+      write_json_number(out, result.frame_ns_p50);
+      out << ", \"frame_ns_p99\": ";
+      write_json_number(out, result.frame_ns_p99);
+      out << ", \"dropped_frames\": " << result.dropped_frames << " }";
+
+      fps.push_back(result.fps);
+      instructions_per_second.push_back(result.instructions_per_second);
+      emulated_mhz.push_back(result.emulated_mhz);
+      frame_ns_p50.push_back(result.frame_ns_p50);
+      frame_ns_p99.push_back(result.frame_ns_p99);
+    }
+    out << ((m_results.empty() == true) ? "],\n" : "\n  ],\n");
+
+    out << "  \"median\": { \"fps\": ";
+    write_json_number(out, get_percentile(fps, 0.5));
+    out << ", \"instructions_per_second\": ";
+    write_json_number(out, get_percentile(instructions_per_second, 0.5));
+    out << ", \"emulated_mhz\": ";
+    write_json_number(out, get_percentile(emulated_mhz, 0.5));
+    out << ", \"frame_ns_p50\": ";
+    write_json_number(out, get_percentile(frame_ns_p50, 0.5));
+    out << ", \"frame_ns_p99\": ";
+    write_json_number(out, get_percentile(frame_ns_p99, 0.5));
+    out << " },\n";
+
+    out << "  \"peak_rss_bytes\": " << get_peak_rss() << "\n";
+    out << "}\n";
+  }
+
+  /** Public Static Methods ***********************************************************************/
+
+  bool benchmark::pin_to_core (std::int32_t core)
+  {
+    #if defined(SM166_LINUX)
+      if (core < 0 || core >= CPU_SETSIZE) { return false; }
+
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      CPU_SET(core, &set);
+      return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+    #else
+      (void) core;
+      return false;
+    #endif
+  }
+
+  std::uint64_t benchmark::get_peak_rss ()
+  {
+    #if defined(SM166_LINUX)
+
+      // On Linux, the peak resident set size is given in kilobytes.
+      struct rusage usage;
+      if (getrusage(RUSAGE_SELF, &usage) != 0) { return 0; }
+      return static_cast<std::uint64_t>(usage.ru_maxrss) * 1024;
+
+    #else
+      return 0;
+    #endif
+  }
+
+  /** Private Methods *****************************************************************************/
+
+  bool benchmark::run_frames (emulator& emu, std::uint64_t frames, double seconds, bool measured)
+  {
+    if (frames == 0 && seconds <= 0.0) { return true; }
+
+    sm::processor& cpu = emu.get_processor();
+    benchmark_result result;
+
+    m_measuring = measured;
+    m_frame_times.clear();
+    if (measured == true && seconds <= 0.0)
+    {
+      m_frame_times.reserve(frames);
+    }
+
+    // If frames are being captured, count the frames the capture had to drop, too.
+    const frame_sink* sink = emu.get_renderer().get_frame_sink();
+    std::uint64_t start_dropped = (sink != nullptr) ? sink->get_dropped_count() : 0;
+
+    std::uint64_t start_frame = m_frame_count;
+    std::uint64_t start_cycle = cpu.get_tick_cycles();
+    clock::time_point start_time = clock::now();
+    clock::time_point deadline = start_time + std::chrono::duration_cast<clock::duration>(
+      std::chrono::duration<double> { seconds }
+    );
+    m_frame_time = start_time;
+
+    // Runs only ever end on a frame boundary. In timed runs, the time is checked only as each frame
+    // completes, so that the clock isn't read on every step.
+    //
+    // As with `emulator::run_frame`, a frame ends at vertical blank, or once a frame's worth of
+    // cycles has passed without one - as when the LCD is off - so that runs always end.
+    bool stopped = false;
+    std::uint64_t checked_frame = start_frame;
+    std::uint64_t seen_frame = start_frame;
+    std::uint64_t frame_start_cycle = start_cycle;
+    while (true)
+    {
+      if (seconds > 0.0)
+      {
+        if (m_frame_count != checked_frame)
+        {
+          if (m_frame_time >= deadline) { break; }
+          checked_frame = m_frame_count;
+        }
+      }
+      else if (m_frame_count - start_frame >= frames)
+      {
+        break;
+      }
+
+      if (emu.is_running() == false)
+      {
+        stopped = true;
+        break;
+      }
+
+      // Steps taken while the processor is halted don't execute an instruction.
+      bool halted = cpu.check_flag(sm::processor_flag_type::halt);
+      if (emu.step() == false)
+      {
+        emu.stop();
+        stopped = true;
+        break;
+      }
+
+      if (halted == false) { result.instructions++; }
+
+      if (m_frame_count != seen_frame)
+      {
+        seen_frame = m_frame_count;
+        frame_start_cycle = cpu.get_tick_cycles();
+      }
+      else if (cpu.get_tick_cycles() - frame_start_cycle >= ticks_per_frame)
+      {
+        on_frame();
+        seen_frame = m_frame_count;
+        frame_start_cycle = cpu.get_tick_cycles();
+      }
+    }
+
+    m_measuring = false;
+    if (measured == false) { return (stopped == false); }
+
+    // Measure up to the end of the last completed frame.
+    result.frames = m_frame_count - start_frame;
+    result.cycles = cpu.get_tick_cycles() - start_cycle;
+    result.dropped_frames = (sink != nullptr) ? sink->get_dropped_count() - start_dropped : 0;
+    result.seconds = std::chrono::duration<double> { m_frame_time - start_time }.count();
+    if (result.seconds > 0.0)
+    {
+      result.fps = result.frames / result.seconds;
+      result.instructions_per_second = result.instructions / result.seconds;
+      result.emulated_mhz = (result.cycles / result.seconds) / 1000000.0;
+    }
+
+    std::vector<double> frame_times { m_frame_times.begin(), m_frame_times.end() };
+    result.frame_ns_p50 = get_percentile(frame_times, 0.50);
+    result.frame_ns_p99 = get_percentile(frame_times, 0.99);
+
+    m_results.push_back(result);
+    return (stopped == false);
+  }
+
+}
@@ -0,0 +1,177 @@
+/** @file smboy/blip_buffer.cpp */
+
+#include <smboy/blip_buffer.hpp>
+
+namespace smboy
+{
+
+  /** Private Constants - Band-Limited Step Kernel ************************************************/
+
+  // Each band-limited step is chosen from this many kernels, by where between two output samples
+  // the step falls.
+  static constexpr std::uint32_t kernel_phase_bits = 6;
+  static constexpr std::uint32_t kernel_phase_count = (1 << kernel_phase_bits);
+
+  // The taps of each kernel add up to one, with this many fractional bits.
+  static constexpr std::uint32_t delta_bits = 14;
+
+  // The strength of the high-pass filter. Higher values filter less.
+  static constexpr std::uint32_t bass_shift = 9;
+
+  // The kernels pass frequencies up to this fraction of the Nyquist frequency.
+  static constexpr double kernel_cutoff = 0.9;
+
+  /** Private Functions - Band-Limited Step Kernel ************************************************/
+
+  struct blip_kernel
+  {
+    std::int32_t taps[kernel_phase_count][blip_buffer::kernel_width];
+  };
+
+  static blip_kernel make_kernel ()
+  {
+    constexpr double pi = 3.14159265358979323846;
+    constexpr std::int32_t half_width = blip_buffer::kernel_width / 2;
+    constexpr std::int32_t unit = (1 << delta_bits);
+
+    blip_kernel kernel;
+    for (std::uint32_t phase = 0; phase < kernel_phase_count; ++phase)
+    {
+
+      // Sample a Blackman-windowed sinc, centered just past the middle of the kernel by the phase.
+      double taps[blip_buffer::kernel_width];
+      double sum = 0.0;
+      for (std::int32_t i = 0; i < static_cast<std::int32_t>(blip_buffer::kernel_width); ++i)
+      {
+        double x = (i - (half_width - 1)) - (static_cast<double>(phase) / kernel_phase_count);
+        double sinc = (x == 0.0) ? 1.0 : std::sin(pi * kernel_cutoff * x) / (pi * kernel_cutoff * x);
+        double window = (std::abs(x) >= half_width) ? 0.0 :
+          0.42 + 0.5 * std::cos(pi * x / half_width) + 0.08 * std::cos(2.0 * pi * x / half_width);
+
+        taps[i] = sinc * window;
+        sum += taps[i];
+      }
+
+      // Scale the taps to integers which add up to exactly one, so that steps leave no error behind
+      // once integrated. Any rounding error goes into the largest tap.
+      std::int32_t int_sum = 0;
+      std::size_t largest = 0;
+      for (std::size_t i = 0; i < blip_buffer::kernel_width; ++i)
+      {
+        kernel.taps[phase][i] = static_cast<std::int32_t>(std::lround(taps[i] / sum * unit));
+        int_sum += kernel.taps[phase][i];
+        if (taps[i] > taps[largest]) { largest = i; }
+      }
+
+      kernel.taps[phase][largest] += (unit - int_sum);
+
+    }
+
+    return kernel;
+  }
+
+  static const blip_kernel& get_kernel ()
+  {
+    static const blip_kernel s_kernel = make_kernel();
+    return s_kernel;
+  }
+
+  /** Public Methods ******************************************************************************/
+
+  bool blip_buffer::set_rates (std::uint32_t clock_rate, std::uint32_t sample_rate,
+    std::size_t capacity)
+  {
+    if (clock_rate == 0 || sample_rate == 0 || sample_rate >= clock_rate)
+    {
+      std::cerr << "[blip_buffer] Invalid rates: " << sample_rate << " Hz output from a "
+                << clock_rate << " Hz clock." << std::endl;
+      return false;
+    }
+
+    if (capacity == 0)
+    {
+      std::cerr << "[blip_buffer] The buffer's capacity must be at least one sample." << std::endl;
+      return false;
+    }
+
+    // Round the length of a clock cycle up, so that a frame never produces fewer samples than it
+    // should.
+    m_sample_rate = sample_rate;
+    m_capacity = capacity;
+    m_factor = ((std::uint64_t(sample_rate) << time_bits) + clock_rate - 1) / clock_rate;
+
+    // Kernels added near the end of the buffer reach up to a kernel's width past it.
+    m_deltas.assign(m_capacity + kernel_width, 0);
+    clear();
+
+    return true;
+  }
+
+  void blip_buffer::clear ()
+  {
+    std::fill(m_deltas.begin(), m_deltas.end(), 0);
+    m_offset = 0;
+    m_integrator = 0;
+  }
+
+  void blip_buffer::add_delta (std::uint64_t clock_time, std::int32_t delta)
+  {
+    std::uint64_t fixed_time = clock_time * m_factor + m_offset;
+    std::size_t index = static_cast<std::size_t>(fixed_time >> time_bits);
+    if (index >= m_capacity) { return; }
+
+    // Pick the kernel by the fractional part of the step's position.
+    std::uint32_t phase = static_cast<std::uint32_t>(
+      (fixed_time >> (time_bits - kernel_phase_bits)) & (kernel_phase_count - 1)
+    );
+
+    const std::int32_t* taps = get_kernel().taps[phase];
+    std::int32_t* output = m_deltas.data() + index;
+    for (std::size_t i = 0; i < kernel_width; ++i)
+    {
+      output[i] += taps[i] * delta;
+    }
+  }
+
+  void blip_buffer::end_frame (std::uint64_t clock_duration)
+  {
+    m_offset += clock_duration * m_factor;
+
+    // Samples past the end of the buffer are lost, rather than overflowing it.
+    if ((m_offset >> time_bits) > m_capacity)
+    {
+      m_offset = std::uint64_t(m_capacity) << time_bits;
+    }
+  }
+
+  std::size_t blip_buffer::read_samples (std::int16_t* output, std::size_t count,
+    std::size_t stride)
+  {
+    count = std::min(count, get_samples_available());
+    if (count == 0) { return 0; }
+
+    // Integrate the amplitude changes into samples. Some of each sample is fed back out of the
+    // integrator, which filters out any DC offset.
+    std::int64_t sum = m_integrator;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+      std::int64_t sample = (sum >> delta_bits);
+      sum += m_deltas[i];
+
+      sample = std::clamp<std::int64_t>(sample, -32768, 32767);
+      output[i * stride] = static_cast<std::int16_t>(sample);
+      sum -= (sample << (delta_bits - bass_shift));
+    }
+
+    m_integrator = sum;
+
+    // Remove the samples which were read. Amplitude changes beyond them, including the tails of
+    // kernels which straddle them, move down to the front of the buffer.
+    std::copy(m_deltas.begin() + count, m_deltas.end(), m_deltas.begin());
+    std::fill(m_deltas.end() - count, m_deltas.end(), 0);
+    m_offset -= (std::uint64_t(count) << time_bits);
+
+    return count;
+  }
+
+}
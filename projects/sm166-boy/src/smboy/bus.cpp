@@ -17,44 +17,53 @@ namespace smboy
     {
       return 0xFF;
     }
-  
+
+    perf_counters& counters = m_emulator->get_counters();
     if (address < rom_end_addr)
     {
+      counters.bus_reads[bus_region::br_rom]++;
       return m_emulator->get_program().read_rom(address);
     }
     
     else if (address >= wram_start_addr && address < wram_end_addr)
     {
+      counters.bus_reads[bus_region::br_wram]++;
       return m_emulator->get_ram().read_wram(address - wram_start_addr);
     }
     
     else if (address >= sram_start_addr && address < sram_end_addr)
     {
+      counters.bus_reads[bus_region::br_sram]++;
       return m_emulator->get_program().read_sram(address - sram_start_addr);
     }
     
     else if (address >= vram_start_addr && address < vram_end_addr)
     {
+      counters.bus_reads[bus_region::br_vram]++;
       return m_emulator->get_renderer().read_vram(address - vram_start_addr);
     }
     
     else if (address >= oam_start_addr && address < oam_end_addr)
     {
+      counters.bus_reads[bus_region::br_oam]++;
       return m_emulator->get_renderer().read_oam(address - oam_start_addr);
     }
 
     else if (address >= stack_start_addr && address < stack_end_addr)
     {
+      counters.bus_reads[bus_region::br_stack]++;
       return m_emulator->get_ram().read_stack(address - stack_start_addr);
     }
     
     else if (address >= hram_start_addr && address < hram_end_addr)
     {
+      counters.bus_reads[bus_region::br_hram]++;
       return m_emulator->get_ram().read_hram(address - hram_start_addr);
     }    
     
     else if (address >= io_start_addr) 
     {
+      counters.bus_reads[bus_region::br_io]++;
       return read_io(address & 0xFF);
     }
     
@@ -67,39 +76,47 @@ namespace smboy
     {
       return;
     }
-    
+
+    perf_counters& counters = m_emulator->get_counters();
     if (address >= wram_start_addr && address < wram_end_addr)
     {
+      counters.bus_writes[bus_region::br_wram]++;
       m_emulator->get_ram().write_wram(address - wram_start_addr, value);
     }
     
     else if (address >= sram_start_addr && address < sram_end_addr)
     {
+      counters.bus_writes[bus_region::br_sram]++;
       m_emulator->get_program().write_sram(address - sram_start_addr, value);
     }
     
     else if (address >= vram_start_addr && address < vram_end_addr)
     {
+      counters.bus_writes[bus_region::br_vram]++;
       m_emulator->get_renderer().write_vram(address - vram_start_addr, value);
     }
     
     else if (address >= oam_start_addr && address < oam_end_addr)
     {
+      counters.bus_writes[bus_region::br_oam]++;
       m_emulator->get_renderer().write_oam(address - oam_start_addr, value);
     }
     
     else if (address >= stack_start_addr && address < stack_end_addr)
     {
+      counters.bus_writes[bus_region::br_stack]++;
       m_emulator->get_ram().write_stack(address - stack_start_addr, value);
     }
     
     else if (address >= hram_start_addr && address < hram_end_addr)
     {
+      counters.bus_writes[bus_region::br_hram]++;
       m_emulator->get_ram().write_hram(address - hram_start_addr, value);
     }
     
     else if (address >= io_start_addr) 
     {
+      counters.bus_writes[bus_region::br_io]++;
       write_io(address & 0xFF, value);
     }
   }
@@ -190,6 +207,13 @@ namespace smboy
 
   void bus::write_io (std::uint8_t address, std::uint8_t value)
   {
+
+    // The audio context runs lazily. Bring it up to date before any of its registers change.
+    if (address >= 0x10 && address <= 0x3F)
+    {
+      m_emulator->get_audio().update(m_emulator->get_processor().get_tick_cycles());
+    }
+
     switch (address) {
       case 0x02:  m_emulator->get_joypad().write_reg_joyc(value); break;
       case 0x04:  m_emulator->get_timer().write_reg_div(); break;
@@ -0,0 +1,250 @@
+/** @file smboy/compositor.cpp */
+
+#include <smboy/compositor.hpp>
+
+#if defined(__x86_64__) || defined(__i386__)
+  #define SMBOY_X86_COMPOSITORS
+  #include <immintrin.h>
+#endif
+
+namespace smboy
+{
+
+  /** Public Functions - Scalar Compositor ********************************************************/
+
+  void composite_line_scalar (const line_pixel* pixels, std::uint8_t* output, std::size_t count)
+  {
+    for (std::size_t x = 0; x < count; ++x)
+    {
+      line_pixel pixel = pixels[x];
+      std::uint32_t bgw = (pixel & 0xFF);
+
+      // Start with the background/window layer's color.
+      std::uint32_t color = (bgw & lp_palette_color_mask);
+
+      // An object is drawn over the background/window layer if the background/window color index
+      // is zero, or if the background and window layers have been stripped of their priority.
+      bool bgw_yields = (bgw & lp_color_index_mask) == 0 || (bgw & lp_lcdc_priority_bit) == 0;
+
+      // Check the object slots in order of priority. The first visible object wins.
+      for (std::uint32_t slot = 0; slot < lp_object_slot_count; ++slot)
+      {
+        std::uint32_t obj = (pixel >> (8 * (slot + 1))) & 0xFF;
+
+        // A color index of zero indicates transparency.
+        if ((obj & lp_color_index_mask) == 0) { continue; }
+
+        // Otherwise, the object is visible if neither the tile nor the object itself gives the
+        // background/window layer priority.
+        if (
+          bgw_yields == true ||
+          (
+            (bgw & lp_bgw_priority_bit) == 0 &&
+            (obj & lp_bgw_priority_bit) == 0
+          )
+        ) {
+          color = cram_color_count + (obj & lp_palette_color_mask);
+          break;
+        }
+      }
+
+      output[x] = static_cast<std::uint8_t>(color);
+    }
+  }
+
+  /** Private Functions - Vector Compositors ******************************************************/
+
+#if defined(SMBOY_X86_COMPOSITORS)
+
+  // The vector compositors work just the same as the scalar compositor above, except that the
+  // per-pixel branches are replaced with lane masks: each object slot that is visible, and is not
+  // beaten by an earlier slot, replaces the palette color index selected so far.
+
+  static void composite_line_sse2 (const line_pixel* pixels, std::uint8_t* output,
+    std::size_t count)
+  {
+    const __m128i byte_mask     = _mm_set1_epi32(0xFF);
+    const __m128i index_mask    = _mm_set1_epi32(lp_color_index_mask);
+    const __m128i color_mask    = _mm_set1_epi32(lp_palette_color_mask);
+    const __m128i priority_bit  = _mm_set1_epi32(lp_bgw_priority_bit);
+    const __m128i lcdc_bit      = _mm_set1_epi32(lp_lcdc_priority_bit);
+    const __m128i object_base   = _mm_set1_epi32(cram_color_count);
+    const __m128i zero          = _mm_setzero_si128();
+
+    std::size_t x = 0;
+    for (; x + 4 <= count; x += 4)
+    {
+      __m128i pixel = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + x));
+      __m128i bgw   = _mm_and_si128(pixel, byte_mask);
+      __m128i color = _mm_and_si128(bgw, color_mask);
+
+      __m128i bgw_yields = _mm_or_si128(
+        _mm_cmpeq_epi32(_mm_and_si128(bgw, index_mask), zero),
+        _mm_cmpeq_epi32(_mm_and_si128(bgw, lcdc_bit), zero)
+      );
+      __m128i bgw_no_priority = _mm_cmpeq_epi32(_mm_and_si128(bgw, priority_bit), zero);
+      __m128i taken = zero;
+
+      for (std::uint32_t slot = 0; slot < lp_object_slot_count; ++slot)
+      {
+        __m128i obj = _mm_and_si128(
+          _mm_srl_epi32(pixel, _mm_cvtsi32_si128(8 * (slot + 1))),
+          byte_mask
+        );
+
+        __m128i transparent = _mm_cmpeq_epi32(_mm_and_si128(obj, index_mask), zero);
+        __m128i wins = _mm_or_si128(
+          bgw_yields,
+          _mm_and_si128(
+            bgw_no_priority,
+            _mm_cmpeq_epi32(_mm_and_si128(obj, priority_bit), zero)
+          )
+        );
+        wins = _mm_andnot_si128(_mm_or_si128(transparent, taken), wins);
+
+        __m128i obj_color = _mm_add_epi32(_mm_and_si128(obj, color_mask), object_base);
+        color = _mm_or_si128(_mm_and_si128(wins, obj_color), _mm_andnot_si128(wins, color));
+        taken = _mm_or_si128(taken, wins);
+      }
+
+      // Narrow the four palette indices down to bytes.
+      __m128i words = _mm_packs_epi32(color, color);
+      std::uint32_t indices = _mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+      std::memcpy(output + x, &indices, sizeof(indices));
+    }
+
+    composite_line_scalar(pixels + x, output + x, count - x);
+  }
+
+  __attribute__((target("avx2")))
+  static void composite_line_avx2 (const line_pixel* pixels, std::uint8_t* output,
+    std::size_t count)
+  {
+    const __m256i byte_mask     = _mm256_set1_epi32(0xFF);
+    const __m256i index_mask    = _mm256_set1_epi32(lp_color_index_mask);
+    const __m256i color_mask    = _mm256_set1_epi32(lp_palette_color_mask);
+    const __m256i priority_bit  = _mm256_set1_epi32(lp_bgw_priority_bit);
+    const __m256i lcdc_bit      = _mm256_set1_epi32(lp_lcdc_priority_bit);
+    const __m256i object_base   = _mm256_set1_epi32(cram_color_count);
+    const __m256i zero          = _mm256_setzero_si256();
+
+    std::size_t x = 0;
+    for (; x + 8 <= count; x += 8)
+    {
+      __m256i pixel = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels + x));
+      __m256i bgw   = _mm256_and_si256(pixel, byte_mask);
+      __m256i color = _mm256_and_si256(bgw, color_mask);
+
+      __m256i bgw_yields = _mm256_or_si256(
+        _mm256_cmpeq_epi32(_mm256_and_si256(bgw, index_mask), zero),
+        _mm256_cmpeq_epi32(_mm256_and_si256(bgw, lcdc_bit), zero)
+      );
+      __m256i bgw_no_priority = _mm256_cmpeq_epi32(_mm256_and_si256(bgw, priority_bit), zero);
+      __m256i taken = zero;
+
+      for (std::uint32_t slot = 0; slot < lp_object_slot_count; ++slot)
+      {
+        __m256i obj = _mm256_and_si256(
+          _mm256_srlv_epi32(pixel, _mm256_set1_epi32(8 * (slot + 1))),
+          byte_mask
+        );
+
+        __m256i transparent = _mm256_cmpeq_epi32(_mm256_and_si256(obj, index_mask), zero);
+        __m256i wins = _mm256_or_si256(
+          bgw_yields,
+          _mm256_and_si256(
+            bgw_no_priority,
+            _mm256_cmpeq_epi32(_mm256_and_si256(obj, priority_bit), zero)
+          )
+        );
+        wins = _mm256_andnot_si256(_mm256_or_si256(transparent, taken), wins);
+
+        __m256i obj_color = _mm256_add_epi32(_mm256_and_si256(obj, color_mask), object_base);
+        color = _mm256_blendv_epi8(color, obj_color, wins);
+        taken = _mm256_or_si256(taken, wins);
+      }
+
+      // Narrow the eight palette indices down to bytes.
+      __m128i words = _mm_packs_epi32(_mm256_castsi256_si128(color),
+        _mm256_extracti128_si256(color, 1));
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(output + x), _mm_packus_epi16(words, words));
+    }
+
+    composite_line_scalar(pixels + x, output + x, count - x);
+  }
+
+#endif
+
+  /** Public Functions - Compositor Selection *****************************************************/
+
+  line_compositor select_line_compositor ()
+  {
+#if defined(SMBOY_X86_COMPOSITORS)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) { return composite_line_avx2; }
+    if (__builtin_cpu_supports("sse2")) { return composite_line_sse2; }
+#endif
+
+    return composite_line_scalar;
+  }
+
+  const char* get_line_compositor_name (line_compositor compositor)
+  {
+#if defined(SMBOY_X86_COMPOSITORS)
+    if (compositor == composite_line_avx2) { return "avx2"; }
+    if (compositor == composite_line_sse2) { return "sse2"; }
+#endif
+
+    return (compositor == composite_line_scalar) ? "scalar" : "unknown";
+  }
+
+  /** Public Functions - Scalar Palette Expander **************************************************/
+
+  void expand_palette_scalar (const std::uint8_t* indices, const std::uint32_t* palette,
+    std::uint32_t* output, std::size_t count)
+  {
+    for (std::size_t x = 0; x < count; ++x)
+    {
+      output[x] = palette[indices[x]];
+    }
+  }
+
+  /** Private Functions - Vector Palette Expanders ************************************************/
+
+#if defined(SMBOY_X86_COMPOSITORS)
+
+  __attribute__((target("avx2")))
+  static void expand_palette_avx2 (const std::uint8_t* indices, const std::uint32_t* palette,
+    std::uint32_t* output, std::size_t count)
+  {
+    std::size_t x = 0;
+    for (; x + 8 <= count; x += 8)
+    {
+
+      // Widen eight palette indices, then gather all eight palette colors at once.
+      __m256i index = _mm256_cvtepu8_epi32(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(indices + x))
+      );
+      __m256i rgba = _mm256_i32gather_epi32(reinterpret_cast<const int*>(palette), index, 4);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + x), rgba);
+
+    }
+
+    expand_palette_scalar(indices + x, palette, output + x, count - x);
+  }
+
+#endif
+
+  /** Public Functions - Palette Expander Selection ***********************************************/
+
+  palette_expander select_palette_expander ()
+  {
+#if defined(SMBOY_X86_COMPOSITORS)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) { return expand_palette_avx2; }
+#endif
+
+    return expand_palette_scalar;
+  }
+
+}
@@ -7,23 +7,28 @@ namespace smboy
 
   /** Public Methods ******************************************************************************/
   
-  emulator& emulator::get_instance ()
-  {
-    static emulator s_instance;
-    return s_instance;
-  }
-  
   void emulator::initialize ()
   {
+    m_scheduler.initialize();
+    m_counters = {};
     m_bus.initialize(this);
     m_timer.initialize(this);
     m_realtime.initialize(this);
     m_renderer.initialize(this);
     m_joypad.initialize(this);
+    m_input.initialize(this);
     m_audio.initialize(this);
     m_ram.initialize();
     m_processor.initialize();
     m_processor.set_cycle_function(std::bind(&emulator::on_tick_cycle, this, std::placeholders::_1));
+
+    // The devices which sleep in between their events run as coroutines on the scheduler.
+    m_scheduler.start(device_slot::ds_renderer, m_renderer.run(m_scheduler));
+    m_scheduler.start(device_slot::ds_oam_dma, m_renderer.run_oam_dma(m_scheduler));
+    m_scheduler.start(device_slot::ds_timer, m_timer.run(m_scheduler));
+    m_scheduler.start(device_slot::ds_realtime, m_realtime.run(m_scheduler));
+    m_scheduler.start(device_slot::ds_input, m_input.run(m_scheduler));
+    set_speculative(false);
     m_running = true;
   }
 
@@ -34,7 +39,19 @@ namespace smboy
   
   bool emulator::step ()
   {
+    std::uint64_t start_cycle = m_processor.get_tick_cycles();
+    bool halted = m_processor.check_flag(sm::processor_flag_type::halt);
+
     bool result = m_processor.step(m_bus);
+
+    std::uint64_t cycles = m_processor.get_tick_cycles() - start_cycle;
+    m_counters.cycles += cycles;
+    if (halted == true) {
+      m_counters.halted_cycles += cycles;
+    } else {
+      m_counters.instructions++;
+    }
+
     if (m_processor.check_flag(sm::processor_flag_type::stop) == true)
     {
       m_running = false;
@@ -42,16 +59,86 @@ namespace smboy
     
     return result;
   }
+
+  bool emulator::run_frame ()
+  {
+    std::uint64_t frame_count = m_renderer.get_frame_count();
+    std::uint64_t end_cycle = m_processor.get_tick_cycles() + ticks_per_frame;
+
+    while (
+      m_running == true &&
+      m_renderer.get_frame_count() == frame_count &&
+      m_processor.get_tick_cycles() < end_cycle
+    )
+    {
+      if (step() == false) { return false; }
+    }
+
+    return true;
+  }
+
+  perf_counters emulator::read_counters () const
+  {
+
+    // The processor counts its own interrupts.
+    perf_counters counters = m_counters;
+    for (std::uint8_t id = 0; id < 8; ++id)
+    {
+      counters.interrupts_requested[id] = m_processor.get_requested_interrupt_count(id);
+      counters.interrupts_serviced[id] = m_processor.get_serviced_interrupt_count(id);
+    }
+
+    return counters;
+  }
+
+  /** Snapshots ***********************************************************************************/
+
+  void emulator::save_snapshot ()
+  {
+    if (m_snapshot == nullptr) { m_snapshot = std::make_unique<snapshot>(); }
+
+    m_processor.save_state(m_snapshot->processor);
+    m_timer.save_state(m_snapshot->timer);
+    m_realtime.save_state(m_snapshot->realtime);
+    m_joypad.save_state(m_snapshot->joypad);
+    m_audio.save_state(m_snapshot->audio);
+    m_program.save_state(m_snapshot->program);
+    m_ram.save_state(m_snapshot->ram);
+    m_renderer.save_state(m_snapshot->renderer);
+  }
+
+  bool emulator::load_snapshot ()
+  {
+    if (m_snapshot == nullptr) { return false; }
+
+    m_processor.load_state(m_snapshot->processor);
+    m_timer.load_state(m_snapshot->timer);
+    m_realtime.load_state(m_snapshot->realtime);
+    m_joypad.load_state(m_snapshot->joypad);
+    m_audio.load_state(m_snapshot->audio);
+    m_program.load_state(m_snapshot->program);
+    m_ram.load_state(m_snapshot->ram);
+    m_renderer.load_state(m_snapshot->renderer);
+    return true;
+  }
+
+  void emulator::set_speculative (bool speculative)
+  {
+    m_speculative = speculative;
+    m_audio.set_output_muted(speculative);
+    m_scheduler.set_held(device_slot::ds_input, speculative);
+  }
   
   /** Tick Cycle Callback *************************************************************************/
   
   void emulator::on_tick_cycle (const std::uint64_t& cycle_count)
   {
-    m_timer.tick();
-    m_realtime.tick();
+    // The renderer's pixel pipeline runs on every dot while drawing pixels. Otherwise, the renderer,
+    // the timer, the realtime clock and the input queue sleep on the scheduler until their next
+    // events. The timer clocks the audio context's frame sequencer; otherwise, the audio context
+    // runs lazily, between its own channel steps.
     m_renderer.tick(cycle_count);
-    m_audio.tick(cycle_count, m_timer.audio_needs_update());
+    m_scheduler.tick(cycle_count);
   }
 
 }
-
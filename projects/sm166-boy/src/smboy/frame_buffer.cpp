@@ -0,0 +1,120 @@
+/** @file smboy/frame_buffer.cpp */
+
+#include <smboy/compositor.hpp>
+#include <smboy/frame_buffer.hpp>
+
+namespace smboy
+{
+
+  /** Public Functions - Frame Data ***************************************************************/
+
+  void copy_frame (const frame_data& source, frame_data& destination)
+  {
+    destination.format = source.format;
+    std::memcpy(destination.pixels, source.pixels,
+      screen_buffer_size * get_frame_pixel_size(source.format));
+
+    if (source.format == frame_format::ff_indexed8)
+    {
+      destination.palette_count = source.palette_count;
+      std::memcpy(destination.line_palettes, source.line_palettes, sizeof(source.line_palettes));
+      std::memcpy(destination.palettes, source.palettes,
+        source.palette_count * sizeof(source.palettes[0]));
+    }
+  }
+
+  void convert_frame_to_rgba (const frame_data& frame, std::uint32_t* output)
+  {
+    switch (frame.format)
+    {
+      case frame_format::ff_rgb565:
+      {
+        const std::uint16_t* pixels = reinterpret_cast<const std::uint16_t*>(frame.pixels);
+        for (std::size_t i = 0; i < screen_buffer_size; ++i)
+        {
+          output[i] = unpack_rgb565(pixels[i]);
+        }
+      } break;
+
+      case frame_format::ff_indexed8:
+      {
+
+        // Look each scanline's indices up in that scanline's palette snapshot.
+        static const palette_expander expander = select_palette_expander();
+        for (std::size_t y = 0; y < screen_height; ++y)
+        {
+          expander(frame.pixels + (y * screen_width), frame.palettes[frame.line_palettes[y]],
+            output + (y * screen_width), screen_width);
+        }
+
+      } break;
+
+      default:
+        std::memcpy(output, frame.pixels, screen_buffer_size * 4);
+        break;
+    }
+  }
+
+  /** Constructor *********************************************************************************/
+
+  frame_buffer::frame_buffer ()
+  {
+    clear();
+  }
+
+  /** Producer Methods ****************************************************************************/
+
+  void frame_buffer::clear ()
+  {
+    for (frame_data& frame : m_frames)
+    {
+      frame.format = frame_format::ff_rgba8888;
+      frame.palette_count = 0;
+      std::memset(frame.pixels, 0, sizeof(frame.pixels));
+    }
+
+    std::memset(m_sequences, 0, sizeof(m_sequences));
+    m_back = 0;
+    m_front = 2;
+    m_middle.store(1, std::memory_order_release);
+    m_published.store(0, std::memory_order_release);
+  }
+
+  std::uint64_t frame_buffer::publish ()
+  {
+
+    // Stamp the finished frame with its sequence number before handing it over.
+    std::uint64_t sequence = m_published.load(std::memory_order_relaxed) + 1;
+    m_sequences[m_back] = sequence;
+
+    // Swap the back buffer into the middle, marking it fresh. Whatever was in the middle - either
+    // a stale frame, or one the consumer never got around to acquiring - becomes the new back
+    // buffer.
+    std::uint8_t old_middle = m_middle.exchange(m_back | fresh_bit, std::memory_order_acq_rel);
+    m_back = (old_middle & index_mask);
+
+    m_published.store(sequence, std::memory_order_release);
+    return sequence;
+
+  }
+
+  /** Consumer Methods ****************************************************************************/
+
+  bool frame_buffer::acquire ()
+  {
+
+    // Don't bother swapping if nothing new has been published since the last acquisition.
+    if ((m_middle.load(std::memory_order_acquire) & fresh_bit) == 0)
+    {
+      return false;
+    }
+
+    // Swap the front buffer into the middle, clearing the fresh bit, and take the published frame.
+    std::uint8_t old_middle = m_middle.exchange(m_front, std::memory_order_acq_rel);
+    m_front = (old_middle & index_mask);
+
+    return true;
+
+  }
+
+}
@@ -0,0 +1,341 @@
+/** @file smboy/frame_sink.cpp */
+
+#include <smboy/frame_sink.hpp>
+
+namespace smboy
+{
+
+  /** Private Functions - Checksums ***************************************************************/
+
+  // The CRC-32 used by PNG and zlib: reflected, with polynomial $EDB88320.
+  static constexpr auto crc32_table = [] ()
+  {
+    std::array<std::uint32_t, 256> table {};
+    for (std::uint32_t i = 0; i < 256; ++i)
+    {
+      std::uint32_t crc = i;
+      for (std::uint32_t bit = 0; bit < 8; ++bit)
+      {
+        crc = (crc & 1) ? ((crc >> 1) ^ 0xEDB88320) : (crc >> 1);
+      }
+      table[i] = crc;
+    }
+    return table;
+  } ();
+
+  static std::uint32_t update_crc32 (std::uint32_t crc, const std::uint8_t* data, std::size_t size)
+  {
+    crc = ~crc;
+    for (std::size_t i = 0; i < size; ++i)
+    {
+      crc = crc32_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+  }
+
+  static std::uint32_t update_adler32 (std::uint32_t adler, const std::uint8_t* data,
+    std::size_t size)
+  {
+    std::uint32_t a = (adler & 0xFFFF), b = (adler >> 16);
+    for (std::size_t i = 0; i < size; ++i)
+    {
+      a = (a + data[i]) % 65521;
+      b = (b + a) % 65521;
+    }
+    return (b << 16) | a;
+  }
+
+  /** Private Functions - Image Encoding **********************************************************/
+
+  static void append_u32_be (std::vector<std::uint8_t>& out, std::uint32_t value)
+  {
+    out.push_back((value >> 24) & 0xFF);
+    out.push_back((value >> 16) & 0xFF);
+    out.push_back((value >>  8) & 0xFF);
+    out.push_back((value      ) & 0xFF);
+  }
+
+  static void append_png_chunk (std::vector<std::uint8_t>& out, const char* type,
+    const std::vector<std::uint8_t>& data)
+  {
+    append_u32_be(out, static_cast<std::uint32_t>(data.size()));
+
+    std::size_t type_start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+
+    // The chunk's CRC covers its type and data, but not its length.
+    append_u32_be(out, update_crc32(0, out.data() + type_start, out.size() - type_start));
+  }
+
+  /** Constructor and Destructor ******************************************************************/
+
+  frame_sink::frame_sink () :
+    m_slots { std::make_unique<frame_slot[]>(slot_count) }
+  {
+
+  }
+
+  frame_sink::~frame_sink ()
+  {
+    close();
+  }
+
+  /** Public Methods ******************************************************************************/
+
+  bool frame_sink::open (const fs::path& path, frame_capture_format format, std::uint32_t interval,
+    const fs::path& hash_path, bool lossless)
+  {
+    close();
+
+    m_format = format;
+    m_interval = (interval > 0) ? interval : 1;
+    m_lossless = lossless;
+    m_path = path;
+
+    // Open the image output, as needed by the capture format.
+    if (m_format == frame_capture_format::fcf_png)
+    {
+      std::error_code ec;
+      fs::create_directories(m_path, ec);
+      if (fs::is_directory(m_path) == false) {
+        std::cerr <<  "[frame_sink] "
+                  <<  "Could not create capture directory '" << m_path << "'." << std::endl;
+        return false;
+      }
+    }
+    else if (m_format != frame_capture_format::fcf_none)
+    {
+      m_file.open(m_path, std::ios::out | std::ios::binary | std::ios::trunc);
+      if (m_file.is_open() == false) {
+        std::cerr <<  "[frame_sink] "
+                  <<  "Could not open capture file '" << m_path << "' for writing." << std::endl;
+        return false;
+      }
+
+      // The YUV4MPEG2 stream header. The frame rate is the emulated machine's exact frame rate.
+      if (m_format == frame_capture_format::fcf_y4m)
+      {
+        m_file  <<  "YUV4MPEG2 W" << screen_width << " H" << screen_height
+                <<  " F" << clock_speed << ":" << ticks_per_frame
+                <<  " Ip A1:1 C444\n";
+      }
+    }
+
+    // Open the hash output, if requested.
+    if (hash_path.empty() == false)
+    {
+      m_hash_file.open(hash_path, std::ios::out | std::ios::trunc);
+      if (m_hash_file.is_open() == false) {
+        std::cerr <<  "[frame_sink] "
+                  <<  "Could not open hash file '" << hash_path << "' for writing." << std::endl;
+        m_file.close();
+        return false;
+      }
+    }
+
+    // Start the writer thread.
+    m_head.store(0);
+    m_tail.store(0);
+    m_written.store(0);
+    m_dropped.store(0);
+    m_stopping.store(false);
+    m_writer = std::thread { &frame_sink::run_writer, this };
+
+    return true;
+  }
+
+  void frame_sink::close ()
+  {
+    if (m_writer.joinable() == false) { return; }
+
+    // The writer thread drains the queue before it stops.
+    m_stopping.store(true, std::memory_order_release);
+    m_writer.join();
+
+    m_file.close();
+    m_hash_file.close();
+
+    if (m_dropped.load() > 0)
+    {
+      std::cerr <<  "[frame_sink] "
+                <<  "Dropped " << m_dropped.load() << " frame(s) because the writer fell behind."
+                <<  std::endl;
+    }
+  }
+
+  void frame_sink::submit (std::uint64_t frame_number, const frame_data& frame)
+  {
+    if (m_writer.joinable() == false) { return; }
+
+    // Only capture every Nth frame, starting with the first.
+    if ((frame_number - 1) % m_interval != 0) { return; }
+
+    // If the queue is full, drop the frame rather than wait for the writer - unless the sink is
+    // lossless, in which case wait for the writer to free up a slot.
+    std::uint32_t head = m_head.load(std::memory_order_relaxed);
+    while (head - m_tail.load(std::memory_order_acquire) == slot_count)
+    {
+      if (m_lossless == false)
+      {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+
+    frame_slot& slot = m_slots[head % slot_count];
+    slot.number = frame_number;
+    copy_frame(frame, slot.frame);
+    m_head.store(head + 1, std::memory_order_release);
+  }
+
+  /** Private Methods *****************************************************************************/
+
+  void frame_sink::run_writer ()
+  {
+    while (true)
+    {
+      std::uint32_t tail = m_tail.load(std::memory_order_relaxed);
+
+      // If the queue is empty, either stop or wait a little while for more frames.
+      if (m_head.load(std::memory_order_acquire) == tail)
+      {
+        if (m_stopping.load(std::memory_order_acquire) == true) {
+          break;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        continue;
+      }
+
+      write_frame(m_slots[tail % slot_count]);
+      m_tail.store(tail + 1, std::memory_order_release);
+    }
+
+    m_file.flush();
+    m_hash_file.flush();
+  }
+
+  void frame_sink::write_frame (const frame_slot& slot)
+  {
+
+    // Convert the frame into RGBA first, so that the images and hashes written don't depend on the
+    // renderer's frame format.
+    convert_frame_to_rgba(slot.frame, m_pixels);
+
+    switch (m_format)
+    {
+      case frame_capture_format::fcf_raw: write_raw_frame(); break;
+      case frame_capture_format::fcf_y4m: write_y4m_frame(); break;
+      case frame_capture_format::fcf_png: write_png_frame(slot.number); break;
+      default: break;
+    }
+
+    if (m_hash_file.is_open() == true)
+    {
+      std::uint32_t crc = update_crc32(0, reinterpret_cast<const std::uint8_t*>(m_pixels),
+        sizeof(m_pixels));
+
+      char line[40];
+      std::snprintf(line, sizeof(line), "%llu %08x\n",
+        static_cast<unsigned long long>(slot.number), crc);
+      m_hash_file << line;
+    }
+
+    m_written.fetch_add(1, std::memory_order_relaxed);
+
+  }
+
+  void frame_sink::write_raw_frame ()
+  {
+    m_file.write(reinterpret_cast<const char*>(m_pixels), sizeof(m_pixels));
+  }
+
+  void frame_sink::write_y4m_frame ()
+  {
+
+    // Convert the frame's RGBA pixels into three full-size Y, Cb and Cr planes, using the BT.601
+    // studio-swing coefficients.
+    std::vector<std::uint8_t> planes(screen_buffer_size * 3);
+    std::uint8_t* y_plane = planes.data();
+    std::uint8_t* cb_plane = y_plane + screen_buffer_size;
+    std::uint8_t* cr_plane = cb_plane + screen_buffer_size;
+    for (std::size_t i = 0; i < screen_buffer_size; ++i)
+    {
+      std::int32_t red   = (m_pixels[i]      ) & 0xFF,
+                   green = (m_pixels[i] >>  8) & 0xFF,
+                   blue  = (m_pixels[i] >> 16) & 0xFF;
+
+      y_plane[i]  = ((  66 * red + 129 * green +  25 * blue + 128) >> 8) +  16;
+      cb_plane[i] = (( -38 * red -  74 * green + 112 * blue + 128) >> 8) + 128;
+      cr_plane[i] = (( 112 * red -  94 * green -  18 * blue + 128) >> 8) + 128;
+    }
+
+    m_file << "FRAME\n";
+    m_file.write(reinterpret_cast<const char*>(planes.data()), planes.size());
+
+  }
+
+  bool frame_sink::write_png_frame (std::uint64_t frame_number)
+  {
+
+    // Each frame goes into its own file, named after its frame number.
+    char name[32];
+    std::snprintf(name, sizeof(name), "%08llu.png", static_cast<unsigned long long>(frame_number));
+
+    std::ofstream file { m_path / name, std::ios::out | std::ios::binary | std::ios::trunc };
+    if (file.is_open() == false) {
+      std::cerr <<  "[frame_sink] "
+                <<  "Could not open capture file '" << (m_path / name) << "' for writing."
+                <<  std::endl;
+      return false;
+    }
+
+    // Lay out the image data: each RGBA scanline, preceded by a filter type byte of zero.
+    static constexpr std::size_t row_size = 1 + (screen_width * 4);
+    std::vector<std::uint8_t> rows(row_size * screen_height);
+    for (std::size_t y = 0; y < screen_height; ++y)
+    {
+      rows[y * row_size] = 0;
+      std::memcpy(&rows[(y * row_size) + 1], &m_pixels[y * screen_width], screen_width * 4);
+    }
+
+    // Wrap the image data in a zlib stream made of uncompressed deflate blocks. These are quick to
+    // write, and need no compression library.
+    std::vector<std::uint8_t> idat { 0x78, 0x01 };
+    for (std::size_t offset = 0; offset < rows.size(); )
+    {
+      std::size_t   length = std::min<std::size_t>(rows.size() - offset, 65535);
+      bool          final = (offset + length == rows.size());
+
+      idat.push_back(final ? 1 : 0);
+      idat.push_back(length & 0xFF);
+      idat.push_back((length >> 8) & 0xFF);
+      idat.push_back(~length & 0xFF);
+      idat.push_back((~length >> 8) & 0xFF);
+      idat.insert(idat.end(), rows.begin() + offset, rows.begin() + offset + length);
+
+      offset += length;
+    }
+    append_u32_be(idat, update_adler32(1, rows.data(), rows.size()));
+
+    // The image header: width, height, eight bits per channel, RGBA color, default compression,
+    // filtering and interlacing.
+    std::vector<std::uint8_t> ihdr;
+    append_u32_be(ihdr, screen_width);
+    append_u32_be(ihdr, screen_height);
+    ihdr.insert(ihdr.end(), { 8, 6, 0, 0, 0 });
+
+    std::vector<std::uint8_t> png { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    append_png_chunk(png, "IHDR", ihdr);
+    append_png_chunk(png, "IDAT", idat);
+    append_png_chunk(png, "IEND", {});
+
+    file.write(reinterpret_cast<const char*>(png.data()), png.size());
+    return true;
+
+  }
+
+}
@@ -0,0 +1,222 @@
+/** @file smboy/input_queue.cpp */
+
+#include <smboy/emulator.hpp>
+#include <smboy/input_queue.hpp>
+
+namespace smboy
+{
+
+  /** Private Constants ***************************************************************************/
+
+  // The ring is drained, and drained events are spread out, over one scanline's worth of cycles.
+  static constexpr std::uint64_t drain_interval = ticks_per_line;
+
+  /** Public Methods ******************************************************************************/
+
+  void input_queue::initialize (emulator* _emulator)
+  {
+    m_emulator = _emulator;
+    m_tail.store(m_head.load(std::memory_order_acquire), std::memory_order_release);
+    m_pending.clear();
+    m_drain_time = 0;
+    m_drained = false;
+    m_next_drain_cycle = drain_interval;
+    update_next_event_cycle();
+  }
+
+  device_task input_queue::run (scheduler& sched)
+  {
+    while (true)
+    {
+      co_await sched.wait_until(device_slot::ds_input, m_next_event_cycle);
+      handle_events(sched.get_cycle());
+    }
+  }
+
+  /** Producer Methods ****************************************************************************/
+
+  bool input_queue::push (input_type type, std::uint8_t index, bool pressed)
+  {
+    std::uint32_t head = m_head.load(std::memory_order_relaxed);
+    std::uint32_t tail = m_tail.load(std::memory_order_acquire);
+    if (head - tail >= capacity)
+    {
+      m_dropped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    input_event& event = m_ring[head & (capacity - 1)];
+    event.cycle = 0;
+    event.host_time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      clock::now().time_since_epoch()
+    ).count();
+    event.type = type;
+    event.index = index;
+    event.pressed = pressed;
+
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /** Public Methods ******************************************************************************/
+
+  void input_queue::schedule (const input_event& event)
+  {
+
+    // Keep the pending events in cycle order. Events mostly arrive in order, so look for their
+    // place from the back.
+    auto it = m_pending.end();
+    while (it != m_pending.begin() && std::prev(it)->cycle > event.cycle)
+    {
+      --it;
+    }
+
+    m_pending.insert(it, event);
+    update_next_event_cycle();
+
+  }
+
+  bool input_queue::open_log (const fs::path& path)
+  {
+    m_log.open(path, std::ios::out | std::ios::trunc);
+    if (m_log.is_open() == false)
+    {
+      std::cerr <<  "[input_queue] "
+                <<  "Could not open input log '" << path << "' for writing." << std::endl;
+      return false;
+    }
+
+    return true;
+  }
+
+  bool input_queue::load_replay (const fs::path& path)
+  {
+    std::ifstream file { path };
+    if (file.is_open() == false)
+    {
+      std::cerr <<  "[input_queue] "
+                <<  "Could not open input log '" << path << "' for reading." << std::endl;
+      return false;
+    }
+
+    // Each line holds one event: its cycle, `button` or `dpad`, its index, and `1` if pressed or
+    // `0` if released.
+    std::string line;
+    std::size_t line_number = 0;
+    while (std::getline(file, line))
+    {
+      line_number++;
+      if (line.empty() == true || line[0] == '#') { continue; }
+
+      std::istringstream stream { line };
+      input_event event;
+      std::string type;
+      unsigned int index = 0, pressed = 0;
+      if (!(stream >> event.cycle >> type >> index >> pressed) ||
+          (type == "button" && index > static_cast<unsigned int>(joypad_button::start)) ||
+          (type == "dpad" && index > static_cast<unsigned int>(joypad_dpad::right)) ||
+          (type != "button" && type != "dpad"))
+      {
+        std::cerr <<  "[input_queue] "
+                  <<  "Malformed event on line " << line_number << " of input log '" << path
+                  <<  "'." << std::endl;
+        return false;
+      }
+
+      event.type = (type == "button") ? input_type::it_button : input_type::it_dpad;
+      event.index = static_cast<std::uint8_t>(index);
+      event.pressed = (pressed != 0);
+      schedule(event);
+    }
+
+    return true;
+  }
+
+  /** Private Methods *****************************************************************************/
+
+  void input_queue::handle_events (std::uint64_t cycle_count)
+  {
+    while (m_pending.empty() == false && m_pending.front().cycle <= cycle_count)
+    {
+      input_event event = m_pending.front();
+      m_pending.pop_front();
+
+      event.cycle = cycle_count;
+      apply(event);
+    }
+
+    if (cycle_count >= m_next_drain_cycle)
+    {
+      drain(cycle_count);
+      m_next_drain_cycle = cycle_count + drain_interval;
+    }
+
+    update_next_event_cycle();
+  }
+
+  void input_queue::drain (std::uint64_t cycle_count)
+  {
+    std::int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      clock::now().time_since_epoch()
+    ).count();
+
+    std::uint32_t tail = m_tail.load(std::memory_order_relaxed);
+    std::uint32_t head = m_head.load(std::memory_order_acquire);
+    for (; tail != head; ++tail)
+    {
+      input_event event = m_ring[tail & (capacity - 1)];
+
+      // Map the event's host time, from the span since the previous drain, onto the next drain
+      // interval's cycles. On the first drain, there's no previous drain to measure from.
+      double fraction = 1.0;
+      if (m_drained == true && now > m_drain_time)
+      {
+        fraction = static_cast<double>(event.host_time - m_drain_time) / (now - m_drain_time);
+        fraction = std::clamp(fraction, 0.0, 1.0);
+      }
+
+      std::uint64_t offset = static_cast<std::uint64_t>(std::llround(fraction * drain_interval));
+      event.cycle = cycle_count + std::max<std::uint64_t>(offset, 1);
+      schedule(event);
+    }
+
+    m_tail.store(tail, std::memory_order_release);
+
+    m_drain_time = now;
+    m_drained = true;
+  }
+
+  void input_queue::apply (const input_event& event)
+  {
+    joypad& pad = m_emulator->get_joypad();
+    if (event.type == input_type::it_button)
+    {
+      pad.set_button(static_cast<joypad_button>(event.index), event.pressed);
+    }
+    else
+    {
+      pad.set_dpad(static_cast<joypad_dpad>(event.index), event.pressed);
+    }
+
+    if (m_log.is_open() == true)
+    {
+      m_log << event.cycle << ((event.type == input_type::it_button) ? " button " : " dpad ")
+            << static_cast<unsigned int>(event.index) << " " << (event.pressed ? 1 : 0) << "\n";
+    }
+  }
+
+  void input_queue::update_next_event_cycle ()
+  {
+    m_next_event_cycle = m_next_drain_cycle;
+    if (m_pending.empty() == false)
+    {
+      m_next_event_cycle = std::min(m_next_event_cycle, m_pending.front().cycle);
+    }
+
+    if (m_emulator != nullptr)
+    {
+      m_emulator->get_scheduler().reschedule(device_slot::ds_input, m_next_event_cycle);
+    }
+  }
+
+}
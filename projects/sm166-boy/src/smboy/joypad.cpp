@@ -13,6 +13,18 @@ namespace smboy
     m_control.buttons = 1;
     m_control.dpad = 1;
   }
+
+  void joypad::save_state (joypad& snapshot) const
+  {
+    snapshot.load_state(*this);
+  }
+
+  void joypad::load_state (const joypad& snapshot)
+  {
+    m_buttons = snapshot.m_buttons;
+    m_dpad = snapshot.m_dpad;
+    m_control = snapshot.m_control;
+  }
   
   void joypad::set_button (joypad_button button, bool pressed)
   {
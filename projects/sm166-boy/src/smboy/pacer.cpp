@@ -0,0 +1,137 @@
+/** @file smboy/pacer.cpp */
+
+#include <smboy/pacer.hpp>
+
+namespace smboy
+{
+
+  /** Public Methods ******************************************************************************/
+
+  void pacer::initialize (pacing_mode mode, double speed)
+  {
+    set_mode(mode, speed);
+
+    m_frame = 0;
+    m_stats_start = clock::now();
+    m_stats_frame = 0;
+    m_stats_cycle = 0;
+    m_fps.store(0.0, std::memory_order_relaxed);
+    m_emulated_mhz.store(0.0, std::memory_order_relaxed);
+    m_frames.store(0, std::memory_order_relaxed);
+  }
+
+  void pacer::on_frame (std::uint64_t cycle_count)
+  {
+    m_frame++;
+    m_behind = false;
+
+    switch (m_mode)
+    {
+      case pacing_mode::pm_realtime:    wait_for_deadline();  break;
+      case pacing_mode::pm_audio:       wait_for_audio();     break;
+      case pacing_mode::pm_unthrottled: break;
+      default: break;
+    }
+
+    update_stats(cycle_count);
+  }
+
+  void pacer::set_mode (pacing_mode mode, double speed)
+  {
+    m_mode = mode;
+    m_speed = (speed > 0.0) ? speed : 1.0;
+
+    // One emulated frame lasts `ticks_per_frame` cycles of the emulated clock. Divide by the speed
+    // multiplier to get the host time each frame should take.
+    std::chrono::duration<double> period {
+      (static_cast<double>(ticks_per_frame) / clock_speed) / m_speed
+    };
+    m_frame_period = std::chrono::duration_cast<clock::duration>(period);
+
+    // Restart the deadlines from the next frame.
+    m_epoch = clock::now();
+    m_epoch_frame = m_frame;
+  }
+
+  pacer_stats pacer::get_stats () const
+  {
+    pacer_stats stats;
+    stats.fps = m_fps.load(std::memory_order_relaxed);
+    stats.emulated_mhz = m_emulated_mhz.load(std::memory_order_relaxed);
+    stats.speed = (stats.emulated_mhz * 1000000.0) / clock_speed;
+    stats.frames = m_frames.load(std::memory_order_relaxed);
+    return stats;
+  }
+
+  /** Private Methods *****************************************************************************/
+
+  void pacer::wait_for_deadline ()
+  {
+
+    // Each frame's deadline is measured from the epoch, not from the previous frame, so any time
+    // overslept on one frame is taken back on the next.
+    clock::time_point deadline = m_epoch + (m_frame - m_epoch_frame) * m_frame_period;
+    clock::time_point now = clock::now();
+    m_behind = (now > deadline);
+
+    // If we've fallen too far behind, don't race to catch up. Just restart the deadlines.
+    if (now > deadline + (max_frames_behind * m_frame_period))
+    {
+      m_epoch = now;
+      m_epoch_frame = m_frame;
+      return;
+    }
+
+    if (now < deadline)
+    {
+      std::this_thread::sleep_until(deadline);
+    }
+
+  }
+
+  void pacer::wait_for_audio ()
+  {
+
+    // Without an audio output to follow, fall back to realtime pacing.
+    if (m_audio_fill == nullptr)
+    {
+      wait_for_deadline();
+      return;
+    }
+
+    // Wait for the audio output to consume enough of its buffer. Don't wait longer than a few
+    // frames, in case the audio output has stalled or been stopped.
+    clock::time_point give_up = clock::now() + (max_frames_behind * m_frame_period);
+    while (m_audio_fill() > m_audio_fill_target && clock::now() < give_up)
+    {
+      std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+
+    // Keep the realtime deadlines moving, so that switching back to realtime mode doesn't cause a
+    // burst of catch-up frames.
+    m_epoch = clock::now();
+    m_epoch_frame = m_frame;
+
+  }
+
+  void pacer::update_stats (std::uint64_t cycle_count)
+  {
+    m_frames.store(m_frame, std::memory_order_relaxed);
+
+    clock::time_point now = clock::now();
+    std::chrono::duration<double> elapsed = (now - m_stats_start);
+    if (elapsed.count() >= 1.0)
+    {
+      double frames = static_cast<double>(m_frame - m_stats_frame);
+      double cycles = static_cast<double>(cycle_count - m_stats_cycle);
+
+      m_fps.store(frames / elapsed.count(), std::memory_order_relaxed);
+      m_emulated_mhz.store((cycles / elapsed.count()) / 1000000.0, std::memory_order_relaxed);
+
+      m_stats_start = now;
+      m_stats_frame = m_frame;
+      m_stats_cycle = cycle_count;
+    }
+  }
+
+}
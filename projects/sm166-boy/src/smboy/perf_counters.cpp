@@ -0,0 +1,122 @@
+/** @file smboy/perf_counters.cpp */
+
+#include <smboy/perf_counters.hpp>
+
+namespace smboy
+{
+
+  /** Private Constants ***************************************************************************/
+
+  static constexpr const char* interrupt_names[8] =
+  {
+    "vblank", "lcd", "timer", "serial", "joypad", "realtime", "int6", "int7"
+  };
+
+  /** Private Functions ***************************************************************************/
+
+  // Writes one line of the table: the counter's name, its count, and its rate, if known.
+  static void write_counter (std::ostream& out, const std::string& name, std::uint64_t count,
+    double seconds)
+  {
+    char line[128];
+    int length = std::snprintf(line, sizeof(line), "  %-24s %16llu", name.c_str(),
+      static_cast<unsigned long long>(count));
+    if (seconds > 0.0 && length > 0 && static_cast<std::size_t>(length) < sizeof(line))
+    {
+      std::snprintf(line + length, sizeof(line) - length, " %16.1f/s", count / seconds);
+    }
+
+    out << line << "\n";
+  }
+
+  /** Public Functions ****************************************************************************/
+
+  perf_counters operator- (const perf_counters& later, const perf_counters& earlier)
+  {
+    perf_counters result;
+    result.instructions = later.instructions - earlier.instructions;
+    result.cycles = later.cycles - earlier.cycles;
+    result.halted_cycles = later.halted_cycles - earlier.halted_cycles;
+
+    for (std::size_t i = 0; i < br_count; ++i)
+    {
+      result.bus_reads[i] = later.bus_reads[i] - earlier.bus_reads[i];
+      result.bus_writes[i] = later.bus_writes[i] - earlier.bus_writes[i];
+    }
+
+    result.blocked_vram = later.blocked_vram - earlier.blocked_vram;
+    result.blocked_oam = later.blocked_oam - earlier.blocked_oam;
+
+    for (std::size_t i = 0; i < 8; ++i)
+    {
+      result.interrupts_requested[i] = later.interrupts_requested[i] -
+        earlier.interrupts_requested[i];
+      result.interrupts_serviced[i] = later.interrupts_serviced[i] -
+        earlier.interrupts_serviced[i];
+    }
+
+    result.dma_bytes = later.dma_bytes - earlier.dma_bytes;
+    result.frames = later.frames - earlier.frames;
+    result.drawn_frames = later.drawn_frames - earlier.drawn_frames;
+    result.mixed_samples = later.mixed_samples - earlier.mixed_samples;
+    result.output_samples = later.output_samples - earlier.output_samples;
+    return result;
+  }
+
+  const char* get_bus_region_name (bus_region region)
+  {
+    switch (region)
+    {
+      case bus_region::br_rom:    return "rom";
+      case bus_region::br_wram:   return "wram";
+      case bus_region::br_sram:   return "sram";
+      case bus_region::br_vram:   return "vram";
+      case bus_region::br_oam:    return "oam";
+      case bus_region::br_stack:  return "stack";
+      case bus_region::br_hram:   return "hram";
+      case bus_region::br_io:     return "io";
+      default:                    return "unknown";
+    }
+  }
+
+  void write_perf_counters (std::ostream& out, const perf_counters& counters, double seconds)
+  {
+    out << "Processor:\n";
+    write_counter(out, "instructions", counters.instructions, seconds);
+    write_counter(out, "cycles", counters.cycles, seconds);
+    write_counter(out, "halted cycles", counters.halted_cycles, seconds);
+
+    out << "Bus:\n";
+    for (std::size_t i = 0; i < br_count; ++i)
+    {
+      std::string name = get_bus_region_name(static_cast<bus_region>(i));
+      write_counter(out, name + " reads", counters.bus_reads[i], seconds);
+      write_counter(out, name + " writes", counters.bus_writes[i], seconds);
+    }
+
+    write_counter(out, "blocked vram accesses", counters.blocked_vram, seconds);
+    write_counter(out, "blocked oam accesses", counters.blocked_oam, seconds);
+    write_counter(out, "oam dma bytes", counters.dma_bytes, seconds);
+
+    out << "Interrupts:\n";
+    for (std::size_t i = 0; i < 8; ++i)
+    {
+      if (counters.interrupts_requested[i] == 0 && counters.interrupts_serviced[i] == 0)
+      {
+        continue;
+      }
+
+      write_counter(out, std::string { interrupt_names[i] } + " requested",
+        counters.interrupts_requested[i], seconds);
+      write_counter(out, std::string { interrupt_names[i] } + " serviced",
+        counters.interrupts_serviced[i], seconds);
+    }
+
+    out << "Output:\n";
+    write_counter(out, "frames", counters.frames, seconds);
+    write_counter(out, "drawn frames", counters.drawn_frames, seconds);
+    write_counter(out, "mixed samples", counters.mixed_samples, seconds);
+    write_counter(out, "output samples", counters.output_samples, seconds);
+  }
+
+}
@@ -5,9 +5,36 @@
 namespace smboy
 {
 
+  /** Private Constants - SRAM File ***************************************************************/
+
+  // The realtime clock's time is saved after the SRAM data: a four-byte tag, followed by the time
+  // in seconds since the Unix epoch, as a 64-bit little-endian integer, followed by the host's time
+  // when the file was saved, likewise. Older files have the `RTC0` tag, and no host time.
+  static constexpr const char* rtc_trailer_tag = "RTC1";
+  static constexpr const char* rtc_trailer_tag_v0 = "RTC0";
+  static constexpr std::size_t rtc_trailer_size = 20;
+  static constexpr std::size_t rtc_trailer_size_v0 = 12;
+
+  /** Private Functions - SRAM File ***************************************************************/
+
+  static std::int64_t read_trailer_time (const std::uint8_t* bytes)
+  {
+    std::uint64_t time = 0;
+    for (std::size_t i = 0; i < 8; ++i) { time |= std::uint64_t(bytes[i]) << (8 * i); }
+    return static_cast<std::int64_t>(time);
+  }
+
+  static void write_trailer_time (std::uint8_t* bytes, std::int64_t time)
+  {
+    for (std::size_t i = 0; i < 8; ++i)
+    {
+      bytes[i] = (static_cast<std::uint64_t>(time) >> (8 * i)) & 0xFF;
+    }
+  }
+
   /** Public Methods ******************************************************************************/
   
-  bool program::load_file (const fs::path& path)
+  bool program::load_file (const fs::path& path, bool use_sram_file)
   {
   
     // Get the absolute form of the file's path, then load the program file.
@@ -52,7 +79,8 @@ namespace smboy
 
     // If the program has SRAM allocated, then deduce the path to the program's SRAM file and load
     // that file.
-    if (m_sram.size() != 0) {
+    m_sram_path.clear();
+    if (m_sram.size() != 0 && use_sram_file == true) {
       m_sram_path = absolute.string() + "-sram";
       load_sram_file();
     }
@@ -96,6 +124,31 @@ namespace smboy
 
       // Load the SRAM data. Don't load any more than 256 KB of SRAM.
       file.read(reinterpret_cast<char*>(m_sram.data()), m_sram.size());
+
+      // The realtime clock's time may be saved after the SRAM data, behind a four-byte tag, along
+      // with the host's time when it was saved.
+      m_has_saved_rtc_time = false;
+      m_has_saved_host_time = false;
+      if (static_cast<std::size_t>(size) >= m_sram.size() + rtc_trailer_size_v0)
+      {
+        std::uint8_t trailer[rtc_trailer_size] = {};
+        file.read(reinterpret_cast<char*>(trailer), rtc_trailer_size);
+        if (
+          std::memcmp(trailer, rtc_trailer_tag, 4) == 0 &&
+          static_cast<std::size_t>(size) >= m_sram.size() + rtc_trailer_size
+        ) {
+          m_rtc_time = read_trailer_time(trailer + 4);
+          m_saved_host_time = read_trailer_time(trailer + 12);
+          m_has_saved_rtc_time = true;
+          m_has_saved_host_time = true;
+        }
+        else if (std::memcmp(trailer, rtc_trailer_tag_v0, 4) == 0)
+        {
+          m_rtc_time = read_trailer_time(trailer + 4);
+          m_has_saved_rtc_time = true;
+        }
+      }
+
       file.close();
     }
     else
@@ -124,21 +177,45 @@ namespace smboy
     }
 
     // Open the SRAM file for writing.
-    std::fstream file { m_sram_path, std::ios::in | std::ios::binary };
+    std::fstream file { m_sram_path, std::ios::out | std::ios::binary | std::ios::trunc };
     if (file.is_open() == false) {
       std::cerr <<  "[program] "
                 <<  "Could not open SRAM file '" << m_sram_path << "' for writing." << std::endl;
       return false;
     }
 
-    // Save the current contents of SRAM to the file.
+    // Save the current contents of SRAM to the file, followed by the realtime clock's time, and the
+    // host's time now, so that the clock can make up for the time that passes until it's loaded.
     file.write(reinterpret_cast<const char*>(m_sram.data()), m_sram.size());
+
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    std::uint8_t trailer[rtc_trailer_size];
+    std::memcpy(trailer, rtc_trailer_tag, 4);
+    write_trailer_time(trailer + 4, m_rtc_time);
+    write_trailer_time(trailer + 12, std::chrono::duration_cast<std::chrono::seconds>(now).count());
+    file.write(reinterpret_cast<const char*>(trailer), rtc_trailer_size);
     file.close();
 
     return true;
   
   }
   
+  bool program::get_saved_rtc_time (std::int64_t& time) const
+  {
+    if (m_has_saved_rtc_time == false) { return false; }
+
+    time = m_rtc_time;
+    return true;
+  }
+
+  bool program::get_saved_host_time (std::int64_t& time) const
+  {
+    if (m_has_saved_host_time == false) { return false; }
+
+    time = m_saved_host_time;
+    return true;
+  }
+
   std::uint8_t program::read_rom (std::uint32_t address) const
   {
     if (address >= m_rom.size()) {
@@ -172,6 +249,17 @@ namespace smboy
     m_sram[address] = value;
   }
 
+  void program::save_state (program& snapshot) const
+  {
+    snapshot.load_state(*this);
+  }
+
+  void program::load_state (const program& snapshot)
+  {
+    m_sram = snapshot.m_sram;
+    m_rtc_time = snapshot.m_rtc_time;
+  }
+
   /** Program Validation **************************************************************************/
   
   bool program::validate ()
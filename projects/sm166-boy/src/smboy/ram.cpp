@@ -5,6 +5,30 @@
 namespace smboy
 {
 
+  /** Private Constants ***************************************************************************/
+
+  // The buffers are saved into snapshots in pages of 4 KB.
+  static constexpr std::uint32_t page_shift = 12;
+  static constexpr std::uint32_t page_size = (1 << page_shift);
+
+  /** Private Functions ***************************************************************************/
+
+  // Copies the pages of the source buffer which are flagged as dirty into the destination buffer,
+  // then clears the flags.
+  static void copy_dirty_pages (byte_buffer& dest, const byte_buffer& source, byte_buffer& dirty)
+  {
+    dest.resize(source.size());
+    for (std::size_t page = 0; page < dirty.size(); ++page)
+    {
+      if (dirty[page] == 0) { continue; }
+
+      std::size_t offset = page << page_shift;
+      std::size_t length = std::min<std::size_t>(page_size, source.size() - offset);
+      std::memcpy(dest.data() + offset, source.data() + offset, length);
+      dirty[page] = 0;
+    }
+  }
+
   /** Public Methods ******************************************************************************/
   
   void ram::initialize ()
@@ -16,6 +40,11 @@ namespace smboy
     m_wram.resize(wram_size, 0x00);
     m_hram.resize(hram_size, 0x00);
     m_stack.resize(stack_size, 0x00);
+
+    // Every page differs from whatever snapshot was taken before, if any.
+    m_wram_dirty.assign((wram_size + page_size - 1) >> page_shift, 0x01);
+    m_hram_dirty.assign((hram_size + page_size - 1) >> page_shift, 0x01);
+    m_stack_dirty.assign((stack_size + page_size - 1) >> page_shift, 0x01);
   }
   
   std::uint8_t ram::read_wram (std::uint32_t address) const
@@ -60,6 +89,7 @@ namespace smboy
     }
 
     m_wram[address] = value;
+    m_wram_dirty[address >> page_shift] = 0x01;
   }
   
   void ram::write_hram (std::uint32_t address, std::uint8_t value)
@@ -71,6 +101,7 @@ namespace smboy
     }
 
     m_hram[address] = value;
+    m_hram_dirty[address >> page_shift] = 0x01;
   }
   
   void ram::write_stack (std::uint32_t address, std::uint8_t value)
@@ -82,7 +113,21 @@ namespace smboy
     }
 
     m_stack[address] = value;
+    m_stack_dirty[address >> page_shift] = 0x01;
   }
 
-}
+  void ram::save_state (ram& snapshot)
+  {
+    copy_dirty_pages(snapshot.m_wram, m_wram, m_wram_dirty);
+    copy_dirty_pages(snapshot.m_hram, m_hram, m_hram_dirty);
+    copy_dirty_pages(snapshot.m_stack, m_stack, m_stack_dirty);
+  }
 
+  void ram::load_state (const ram& snapshot)
+  {
+    copy_dirty_pages(m_wram, snapshot.m_wram, m_wram_dirty);
+    copy_dirty_pages(m_hram, snapshot.m_hram, m_hram_dirty);
+    copy_dirty_pages(m_stack, snapshot.m_stack, m_stack_dirty);
+  }
+
+}
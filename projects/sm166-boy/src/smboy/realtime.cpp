@@ -6,54 +6,187 @@
 namespace smboy
 {
 
+  /** Private Constants ***************************************************************************/
+
+  // The cycle of anything which is not going to happen.
+  static constexpr std::uint64_t never = std::numeric_limits<std::uint64_t>::max();
+
+  /** Public Methods ******************************************************************************/
+
   void realtime::initialize (emulator* _emulator)
   {
     m_emulator = _emulator;
-  
-    auto now          = std::chrono::system_clock::now().time_since_epoch();
-    auto seconds      = std::chrono::duration_cast<std::chrono::seconds>(now).count();
-    auto minutes      = std::chrono::duration_cast<std::chrono::minutes>(now).count();
-    auto hours        = std::chrono::duration_cast<std::chrono::hours>(now).count();
-    auto days         = std::chrono::duration_cast<std::chrono::duration<int, std::ratio<86400>>>(now).count();
 
-    m_seconds = (seconds % 60);
-    m_minutes = (minutes % 60);
-    m_hours   = (hours   % 24);
-    m_days    = ((days & 0xFFFF) % 365);
+    // The epoch is worked out on the first tick, by which time the program and its SRAM file have
+    // been loaded - unless it has been set explicitly.
+    m_epoch_valid = m_epoch_explicit;
+    m_started = false;
+    m_next_second_cycle = 0;
+    m_host_started = false;
+    reschedule();
+  }
+
+  device_task realtime::run (scheduler& sched)
+  {
+    while (true)
+    {
+      co_await sched.wait_until(device_slot::ds_realtime, m_next_second_cycle);
+      tick_second(sched.get_cycle());
+    }
+  }
+
+  void realtime::on_frame ()
+  {
+    if (m_host_sync == false || m_epoch_valid == false) { return; }
+
+    host_clock::time_point now = host_clock::now();
+    if (m_host_started == false)
+    {
+      m_host_start = now;
+      m_host_start_time = m_time;
+      m_host_started = true;
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - m_host_start).count();
+    set_time(m_host_start_time + elapsed);
+  }
+
+  void realtime::set_epoch (std::int64_t seconds)
+  {
+    m_epoch = seconds;
+    m_epoch_valid = true;
+    m_epoch_explicit = true;
+    m_host_started = false;
+    m_next_second_cycle = 0;
+    reschedule();
+  }
+
+  void realtime::set_host_sync (bool enabled)
+  {
+    if (enabled == m_host_sync) { return; }
+    m_host_sync = enabled;
+    m_host_started = false;
+
+    // Going back to the emulated cycle count, move the epoch so that the clock carries on from the
+    // time it reached while synced to the host.
+    if (enabled == false && m_epoch_valid == true && m_emulator != nullptr)
+    {
+      std::uint64_t cycle_count = m_emulator->get_processor().get_tick_cycles();
+      m_epoch = m_time - static_cast<std::int64_t>(cycle_count / clock_speed);
+    }
+
+    m_next_second_cycle = 0;
+    reschedule();
+  }
+
+  void realtime::save_state (realtime& snapshot) const
+  {
+    snapshot.load_state(*this);
   }
 
-  void realtime::tick ()
+  void realtime::load_state (const realtime& snapshot)
+  {
+    m_seconds = snapshot.m_seconds;
+    m_minutes = snapshot.m_minutes;
+    m_hours = snapshot.m_hours;
+    m_days = snapshot.m_days;
+    m_control = snapshot.m_control;
+    m_epoch = snapshot.m_epoch;
+    m_time = snapshot.m_time;
+    m_epoch_valid = snapshot.m_epoch_valid;
+    m_epoch_explicit = snapshot.m_epoch_explicit;
+    m_started = snapshot.m_started;
+    m_next_second_cycle = snapshot.m_next_second_cycle;
+    m_host_started = snapshot.m_host_started;
+    m_host_start = snapshot.m_host_start;
+    m_host_start_time = snapshot.m_host_start_time;
+    reschedule();
+  }
+
+  /** Private Methods *****************************************************************************/
+
+  void realtime::tick_second (std::uint64_t cycle_count)
   {
     if (m_emulator == nullptr)
     {
+      m_next_second_cycle = never;
       return;
     }
-  
-    std::uint16_t old_div = m_divider;
-    m_divider++;
 
-    if (is_enabled() == false) {
+    bool first_tick = (m_started == false);
+    if (m_epoch_valid == false) { resolve_epoch(); }
+    m_started = true;
+
+    // While synced to the host, the clock only changes at the end of each frame.
+    if (m_host_sync == true)
+    {
+      if (first_tick == true) { set_time(m_epoch, true); }
+      m_next_second_cycle = never;
       return;
     }
 
-    bool needs_update = (sm_getbit(old_div, 9) != 0) && (sm_getbit(m_divider, 9) == 0);
-    if (needs_update == true) {
-      auto now          = std::chrono::system_clock::now().time_since_epoch();
-      auto seconds      = std::chrono::duration_cast<std::chrono::seconds>(now).count();
-      auto minutes      = std::chrono::duration_cast<std::chrono::minutes>(now).count();
-      auto hours        = std::chrono::duration_cast<std::chrono::hours>(now).count();
-      auto days         = std::chrono::duration_cast<std::chrono::duration<int, std::ratio<86400>>>(now).count();
+    std::uint64_t elapsed = cycle_count / clock_speed;
+    set_time(m_epoch + static_cast<std::int64_t>(elapsed), first_tick);
+    m_next_second_cycle = (elapsed + 1) * clock_speed;
+  }
+
+  void realtime::resolve_epoch ()
+  {
 
-      std::uint8_t old_seconds = m_seconds;
-      m_seconds = (seconds % 60);
-      m_minutes = (minutes % 60);
-      m_hours   = (hours   % 24);
-      m_days    = ((days & 0xFFFF) % 365);
+    // Carry on from the time saved with the program's SRAM, if there is one, plus the time which
+    // has passed on the host since it was saved: the clock keeps running while the emulator is
+    // closed. Otherwise, start from the host's time. The host's clock is read this once.
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    std::int64_t host_time = std::chrono::duration_cast<std::chrono::seconds>(now).count();
 
-      if (m_seconds != old_seconds) {
-        m_emulator->get_processor().request_interrupt(interrupt_type::int_realtime);
+    const program& prog = m_emulator->get_program();
+    std::int64_t saved_time = 0, saved_host_time = 0;
+    if (prog.get_saved_rtc_time(saved_time) == true)
+    {
+      m_epoch = saved_time;
+      if (prog.get_saved_host_time(saved_host_time) == true && host_time > saved_host_time)
+      {
+        m_epoch += host_time - saved_host_time;
       }
     }
+    else
+    {
+      m_epoch = host_time;
+    }
+
+    m_epoch_valid = true;
+
+  }
+
+  void realtime::set_time (std::int64_t time, bool initial)
+  {
+    bool changed = (time != m_time);
+    m_time = time;
+
+    // Keep the time which is saved with the program's SRAM up to date.
+    m_emulator->get_program().set_rtc_time(time);
+
+    // The registers only count while the clock is enabled, but they're set from the initial time
+    // either way.
+    if (is_enabled() == false && initial == false) { return; }
+
+    std::int64_t days = time / 86400;
+    m_seconds = static_cast<std::uint8_t>(time % 60);
+    m_minutes = static_cast<std::uint8_t>((time / 60) % 60);
+    m_hours   = static_cast<std::uint8_t>((time / 3600) % 24);
+    m_days    = static_cast<std::uint16_t>((days & 0xFFFF) % 365);
+
+    if (changed == true && initial == false && is_enabled() == true) {
+      m_emulator->get_processor().request_interrupt(interrupt_type::int_realtime);
+    }
+  }
+
+  void realtime::reschedule ()
+  {
+    if (m_emulator != nullptr)
+    {
+      m_emulator->get_scheduler().reschedule(device_slot::ds_realtime, m_next_second_cycle);
+    }
   }
 
 }
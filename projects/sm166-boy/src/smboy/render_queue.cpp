@@ -0,0 +1,83 @@
+/** @file smboy/render_queue.cpp */
+
+#include <smboy/render_queue.hpp>
+
+namespace smboy
+{
+
+  render_queue::render_queue ()
+  {
+    m_spin_count = (std::thread::hardware_concurrency() > 1) ? max_spin_count : 0;
+  }
+
+  /** Producer Methods ****************************************************************************/
+
+  void render_queue::push (const render_event& event)
+  {
+    std::uint32_t head = m_head.load(std::memory_order_relaxed);
+
+    // If the queue is full, make sure the consumer is awake, then wait for it to make room.
+    if (head - m_tail.load(std::memory_order_acquire) == capacity)
+    {
+      m_head.notify_one();
+      while (head - m_tail.load(std::memory_order_acquire) == capacity)
+      {
+        std::this_thread::yield();
+      }
+    }
+
+    m_events[head & (capacity - 1)] = event;
+    m_head.store(head + 1, std::memory_order_release);
+
+    // Only wake the consumer for events which let it make progress.
+    if (
+      event.type == render_event_type::ret_advance ||
+      event.type == render_event_type::ret_sync ||
+      event.type == render_event_type::ret_stop
+    ) {
+      m_head.notify_one();
+    }
+  }
+
+  void render_queue::sync (std::uint64_t stamp)
+  {
+    push({ stamp, 0, render_event_type::ret_sync, 0 });
+    m_sync_count++;
+
+    std::uint64_t synced = m_synced.load(std::memory_order_acquire);
+    while (synced < m_sync_count)
+    {
+      m_synced.wait(synced, std::memory_order_acquire);
+      synced = m_synced.load(std::memory_order_acquire);
+    }
+  }
+
+  /** Consumer Methods ****************************************************************************/
+
+  render_event render_queue::pop ()
+  {
+    std::uint32_t tail = m_tail.load(std::memory_order_relaxed);
+
+    // Wait for an event to arrive. Spin for a little while first, before going to sleep.
+    std::uint32_t spins = 0;
+    while (m_head.load(std::memory_order_acquire) == tail)
+    {
+      if (spins < m_spin_count) {
+        spins++;
+      } else {
+        m_head.wait(tail, std::memory_order_acquire);
+      }
+    }
+
+    render_event event = m_events[tail & (capacity - 1)];
+    m_tail.store(tail + 1, std::memory_order_release);
+    return event;
+  }
+
+  void render_queue::report_sync ()
+  {
+    m_synced.fetch_add(1, std::memory_order_release);
+    m_synced.notify_one();
+  }
+
+}
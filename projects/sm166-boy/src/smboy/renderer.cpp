@@ -6,22 +6,63 @@
 namespace smboy
 {
 
+  /** Private Constants ***************************************************************************/
+
+  // The cycle of anything which is not going to happen.
+  static constexpr std::uint64_t never = std::numeric_limits<std::uint64_t>::max();
+
+  /** Private Functions - Color Decoding **********************************************************/
+
+  static std::uint32_t decode_cram_color (const std::uint8_t* cram, std::uint8_t start_index)
+  {
+
+    // Retrieve the color components from color RAM. Tney are laid out in the following order:
+    //  - Red, Green, Blue
+    std::uint32_t red = (
+      (cram[start_index] & 0b11111000) >> 3
+    ) * 8;
+    std::uint32_t green = (
+      ((cram[start_index] & 0b00000111) << 2) |
+      ((cram[start_index + 1] & 0b11000000) >> 6)
+    ) * 8;
+    std::uint32_t blue = (
+      (cram[start_index + 1] & 0b00111110) >> 1
+    ) * 8;
+
+    return        (red         ) |
+                  (green  <<  8) |
+                  (blue   << 16) |
+                  0xFF000000;
+
+  }
+
   renderer::renderer () :
     m_vram { m_vram0 }
   {
-  
+    m_screen = &m_frames.get_back_frame();
+  }
+
+  renderer::~renderer ()
+  {
+    stop_render_thread();
   }
   
   /** Initialization and Ticking ******************************************************************/
 
   void renderer::initialize (emulator* _emulator)
   {
+
+    // If the render thread is running, stop it. It is restarted on the next tick, if still
+    // requested.
+    stop_render_thread();
   
     m_emulator = _emulator;
 
     // Initialize Memory Storage
     m_vram = m_vram0;
     // m_screen.clear();   m_screen.resize(screen_width * screen_height);
+    m_frames.clear();
+    m_screen = &m_frames.get_back_frame();
 
     // Initialize Background Palette Memory
     for (std::size_t i = 0; i < cram_size; i += 8)
@@ -36,11 +77,20 @@ namespace smboy
       m_bg_cram[i + 7] = 0b01000010; m_obj_cram[i + 7] = 0b01000010;
     }
 
+    // Decode the initial palette memory into the palette cache.
+    for (std::uint8_t i = 0; i < cram_size; i += 2)
+    {
+      update_bg_palette_color(i);
+      update_obj_palette_color(i);
+    }
+
     // Initialize Internal Values
     m_dma_source            = 0x00000000;
     m_dma_delay             = 0x00;
     m_line_tick             = 0x00;
     m_window_line           = 0x00;
+    m_step_cycle            = 0;
+    m_every_dot             = false;
 
     // Initialize Hardware Registers
     m_control.state         = 0x91;
@@ -54,51 +104,106 @@ namespace smboy
     m_priority_mode         = 0x00;
     m_dma_source            = 0xFFFE0000;
 
-    // Initialize frame time...
-    m_start = std::chrono::system_clock::now();
+    // Bucket whatever objects are currently in OAM.
+    rebuild_object_lines();
+
+    // Pick the fastest line compositor and palette expander the host supports.
+    m_compositor = select_line_compositor();
+    m_expander = select_palette_expander();
+
+    // Start the first frame in the requested frame format.
+    m_frame_format = m_requested_frame_format;
+    start_frame_data();
+
+    // Initialize the frame counts. The renderer starts out in vertical blank, so the first frame
+    // goes through the same skip decision as any other when it begins.
+    m_frame_count = 0;
+    m_drawn_frame_count = 0;
+    m_frames_skipped = 0;
+    m_skip_next_frame = false;
+    m_frame_skipped = false;
+    m_draw_pixels = true;
 
   }
 
-  void renderer::tick (const std::uint64_t& cycle_count)
+  device_task renderer::run (scheduler& sched)
   {
-  
-    // Don't bother ticking if the renderer has no parent emulator attached.
-    if (m_emulator == nullptr) {
-      return;
+    while (true)
+    {
+      co_await sched.wait_until(device_slot::ds_renderer, get_next_step_cycle());
+      step(sched.get_cycle());
     }
-    
-    // Check the renderer's master enable. Don't bother ticking if it is turned off.
-    if (m_control.master_enable == false) {
-      return;
+  }
+
+  device_task renderer::run_oam_dma (scheduler& sched)
+  {
+    while (true)
+    {
+      co_await sched.wait_until(device_slot::ds_oam_dma, get_next_dma_cycle());
+      tick_oam_dma();
     }
+  }
 
-    // Increment the current line tick, then run the state machine.
-    m_line_tick++;
-    switch (m_status.mode)
+  void renderer::save_state (renderer& snapshot)
+  {
+
+    // Count the dots up to this point, so that the snapshot's line tick is up to date. The next
+    // step's cycle stays the same.
+    catch_up(get_cycle_count());
+    snapshot.copy_state_from(*this);
+
+    // While the render thread runs, the replica holds the pixel pipeline. Let it catch up, then
+    // take the pipeline from it instead.
+    if (m_replica != nullptr)
     {
-      case display_mode::dm_horizontal_blank: tick_horizontal_blank();  break;
-      case display_mode::dm_vertical_blank:   tick_vertical_blank();    break;
-      case display_mode::dm_object_scan:      tick_object_scan();       break;
-      case display_mode::dm_drawing_pixels:   tick_drawing_pixels();    break;
-      default: break;
+      sync_render_thread();
+      snapshot.copy_pipeline_from(*m_replica);
     }
 
-    // On each machine cycle (every four tick cycles), run the OAM DMA transfer if it is active.
-    if (cycle_count % 4 == 0) {
-      tick_oam_dma();
+    snapshot.m_frame_count = m_frame_count;
+    snapshot.m_drawn_frame_count = m_drawn_frame_count;
+    snapshot.m_frames_skipped = m_frames_skipped;
+    snapshot.m_skip_next_frame = m_skip_next_frame;
+
+  }
+
+  void renderer::load_state (const renderer& snapshot)
+  {
+
+    // Let the render thread, if running, finish with the events forwarded so far, so that it is
+    // idle while its state is replaced below.
+    sync_render_thread();
+
+    copy_state_from(snapshot);
+    m_frame_count = snapshot.m_frame_count;
+    m_drawn_frame_count = snapshot.m_drawn_frame_count;
+    m_frames_skipped = snapshot.m_frames_skipped;
+    m_skip_next_frame = snapshot.m_skip_next_frame;
+
+    // Carry on from the restored state in the replica, as if the render thread had just started.
+    if (m_replica != nullptr)
+    {
+      m_replica->copy_state_from(*this);
+      m_replica->m_screen = m_screen;
+      m_draw_pixels = false;
     }
 
+    // Wake the coroutines on the restored mode's next dot and the restored transfer's next byte.
+    reschedule();
+
   }
 
   /** Memory Storage Accesses *********************************************************************/
 
   std::uint8_t renderer::read_vram (std::uint32_t address) const
   {
-    if (
-      address >= vram_size ||
-      m_status.mode == display_mode::dm_drawing_pixels
-    ) { 
-      return 0xFF; 
+    if (address >= vram_size) {
+      return 0xFF;
+    }
+
+    if (m_status.mode == display_mode::dm_drawing_pixels) {
+      m_emulator->get_counters().blocked_vram++;
+      return 0xFF;
     }
 
     return m_vram[address];
@@ -106,11 +211,15 @@ namespace smboy
 
   std::uint8_t renderer::read_oam (std::uint32_t address) const
   {
+    if (address >= oam_size) {
+      return 0xFF;
+    }
+
     if (
-      address >= oam_size ||
       m_status.mode == display_mode::dm_object_scan ||
       m_status.mode == display_mode::dm_drawing_pixels
     ) { 
+      m_emulator->get_counters().blocked_oam++;
       return 0xFF; 
     }
 
@@ -129,6 +238,11 @@ namespace smboy
       //           << std::endl;
 
       m_vram[address] = value;
+      forward_event(render_event_type::ret_vram, address, value);
+    }
+    else if (address < vram_size)
+    {
+      m_emulator->get_counters().blocked_vram++;
     }
   }
 
@@ -139,8 +253,11 @@ namespace smboy
       m_status.mode != display_mode::dm_object_scan &&
       m_status.mode != display_mode::dm_drawing_pixels
     ) {
-      std::uint8_t* oam_bytes = reinterpret_cast<std::uint8_t*>(m_oam);
-      oam_bytes[address] = value;
+      write_oam_byte(address, value);
+    }
+    else if (address < oam_size)
+    {
+      m_emulator->get_counters().blocked_oam++;
     }
   }
 
@@ -148,12 +265,12 @@ namespace smboy
 
   const std::uint32_t* renderer::get_screen_buffer () const
   {
-    return m_screen;
+    return reinterpret_cast<const std::uint32_t*>(m_screen->pixels);
   }
 
   const std::uint8_t* renderer::get_screen_bytes () const
   {
-    return reinterpret_cast<const std::uint8_t*>(m_screen);
+    return m_screen->pixels;
   }
 
   /** Non-Inline Hardware Register Accesses *******************************************************/
@@ -178,15 +295,63 @@ namespace smboy
     return m_obj_cram[m_obj_pal_spec & 0b01111111];
   }
 
+  void renderer::write_reg_lcdc (std::uint8_t value)
+  {
+
+    // Count the dots up to this write while the master enable still has its old value. The replica
+    // counts its own.
+    if (m_primary == nullptr) { catch_up(get_cycle_count()); }
+
+    std::uint8_t old_tall_objects = m_control.tall_objects;
+    m_control.state = value;
+    forward_event(render_event_type::ret_lcdc, 0, value);
+
+    // Changing the object height changes which lines every object resides on.
+    if (m_control.tall_objects != old_tall_objects)
+    {
+      rebuild_object_lines();
+    }
+
+    // Turning the display on or off starts or stops the mode machine.
+    reschedule();
+
+  }
+
+  void renderer::write_reg_scy (std::uint8_t value)
+  {
+    m_scroll_y = value;
+    forward_event(render_event_type::ret_scy, 0, value);
+  }
+
+  void renderer::write_reg_scx (std::uint8_t value)
+  {
+    m_scroll_x = value;
+    forward_event(render_event_type::ret_scx, 0, value);
+  }
+
   void renderer::write_reg_dma4 ()
   {
     m_dma_source &= 0xFFFFFF00;
     m_dma_delay = 2;
+    reschedule();
+  }
+
+  void renderer::write_reg_wy (std::uint8_t value)
+  {
+    m_window_y = value;
+    forward_event(render_event_type::ret_wy, 0, value);
+  }
+
+  void renderer::write_reg_wx (std::uint8_t value)
+  {
+    m_window_x = value;
+    forward_event(render_event_type::ret_wx, 0, value);
   }
 
   void renderer::write_reg_vbk (std::uint8_t value)
   {
     m_vram_bank = value;
+    forward_event(render_event_type::ret_vbk, 0, value);
 
     if (sm_getbit(m_vram_bank, 0) == 0) {
       m_vram = m_vram0;
@@ -195,13 +360,21 @@ namespace smboy
     }
   }
 
+  void renderer::write_reg_bcps (std::uint8_t value)
+  {
+    m_bg_pal_spec = value;
+    forward_event(render_event_type::ret_bcps, 0, value);
+  }
+
   void renderer::write_reg_bcpd (std::uint8_t value)
   {
     std::uint8_t address = (m_bg_pal_spec & 0b01111111);
+    forward_event(render_event_type::ret_bcpd, 0, value);
 
     if (m_status.mode != display_mode::dm_drawing_pixels)
     {
       m_bg_cram[address] = value;
+      update_bg_palette_color(address);
     }
 
     if (sm_getbit(m_bg_pal_spec, 7) != 0)
@@ -210,13 +383,21 @@ namespace smboy
     }
   }
 
+  void renderer::write_reg_obps (std::uint8_t value)
+  {
+    m_obj_pal_spec = value;
+    forward_event(render_event_type::ret_obps, 0, value);
+  }
+
   void renderer::write_reg_obpd (std::uint8_t value)
   {
     std::uint8_t address = (m_obj_pal_spec & 0b01111111);
+    forward_event(render_event_type::ret_obpd, 0, value);
 
     if (m_status.mode != display_mode::dm_drawing_pixels)
     {
       m_obj_cram[address] = value;
+      update_obj_palette_color(address);
     }
 
     if (sm_getbit(m_obj_pal_spec, 7) != 0)
@@ -225,8 +406,140 @@ namespace smboy
     }
   }
 
+  void renderer::write_reg_opri (std::uint8_t value)
+  {
+    m_priority_mode = value;
+    forward_event(render_event_type::ret_opri, 0, value);
+  }
+
   /** Renderer State Machine Methods **************************************************************/
 
+  void renderer::step (std::uint64_t cycle_count)
+  {
+
+    // Count the dots skipped since the last step, up to this one.
+    catch_up(cycle_count - 1);
+
+    // Start or stop the render thread, if requested. The replica starts from the dots counted so
+    // far.
+    if (m_render_thread_requested != (m_replica != nullptr))
+    {
+      if (m_render_thread_requested == true) {
+        start_render_thread();
+      } else {
+        stop_render_thread();
+      }
+    }
+
+    // Check the renderer's master enable. Don't bother ticking if it is turned off.
+    m_step_cycle = cycle_count;
+    if (m_control.master_enable == true) {
+      tick_dot();
+    }
+
+    // Drawing pixels acts on every dot. Leave those to `tick`.
+    m_every_dot = acts_on_every_dot();
+
+  }
+
+  void renderer::step_every_dot (std::uint64_t cycle_count)
+  {
+    step(cycle_count);
+
+    // Hand the mode machine back to the coroutine once drawing pixels is done.
+    if (m_every_dot == false)
+    {
+      m_emulator->get_scheduler().reschedule(device_slot::ds_renderer, get_next_step_cycle());
+    }
+  }
+
+  void renderer::catch_up (std::uint64_t cycle_count)
+  {
+    if (cycle_count <= m_step_cycle) {
+      return;
+    }
+
+    // The mode machine does nothing on the dots in between its steps, other than count them.
+    if (m_control.master_enable == true) {
+      m_line_tick += static_cast<std::uint16_t>(cycle_count - m_step_cycle);
+    }
+
+    m_step_cycle = cycle_count;
+  }
+
+  void renderer::tick_dot ()
+  {
+
+    // Increment the current line tick, then run the state machine.
+    m_line_tick++;
+    switch (m_status.mode)
+    {
+      case display_mode::dm_horizontal_blank: tick_horizontal_blank();  break;
+      case display_mode::dm_vertical_blank:   tick_vertical_blank();    break;
+      case display_mode::dm_object_scan:      tick_object_scan();       break;
+      case display_mode::dm_drawing_pixels:   tick_drawing_pixels();    break;
+      default: break;
+    }
+
+  }
+
+  std::uint64_t renderer::get_next_step_cycle () const
+  {
+
+    // While drawing pixels, the dots are stepped by `tick` instead. Otherwise, requests to start or
+    // stop the render thread are handled on the next dot, even while the display is off, and
+    // nothing else happens while it is off.
+    if (m_every_dot == true) {
+      return never;
+    }
+    else if (m_render_thread_requested != (m_replica != nullptr)) {
+      return m_step_cycle + 1;
+    }
+    else if (m_control.master_enable == false) {
+      return never;
+    }
+
+    // Work out the line tick on which the current mode next acts.
+    std::uint32_t target = 0;
+    switch (m_status.mode)
+    {
+      case display_mode::dm_horizontal_blank:
+      case display_mode::dm_vertical_blank:   target = ticks_per_line; break;
+      case display_mode::dm_object_scan:      target = (m_line_tick < 1) ? 1 : 80; break;
+      default: return m_step_cycle + 1;
+    }
+
+    return m_step_cycle + ((m_line_tick < target) ? (target - m_line_tick) : 1);
+
+  }
+
+  void renderer::reschedule ()
+  {
+
+    // Only the renderer which the CPU can see runs on the scheduler.
+    if (m_emulator == nullptr || m_primary != nullptr) { return; }
+
+    // The display may have been turned on or off, or restored into a different mode.
+    m_every_dot = acts_on_every_dot();
+
+    scheduler& sched = m_emulator->get_scheduler();
+    sched.reschedule(device_slot::ds_renderer, get_next_step_cycle());
+    sched.reschedule(device_slot::ds_oam_dma, get_next_dma_cycle());
+
+  }
+
+  bool renderer::acts_on_every_dot () const
+  {
+    return
+      m_control.master_enable == true &&
+      m_status.mode == display_mode::dm_drawing_pixels;
+  }
+
+  std::uint64_t renderer::get_cycle_count () const
+  {
+    return m_emulator->get_processor().get_tick_cycles();
+  }
+
   void renderer::tick_horizontal_blank ()
   {
 
@@ -241,47 +554,21 @@ namespace smboy
       // blank mode.
       if (m_line >= screen_height)
       {
-      
-        // Get a pointer to the emulator's processor.
-        sm::processor& processor = m_emulator->get_processor();
 
         // Move to vertical blank mode and request the vblank interrupt.
         m_status.mode = display_mode::dm_vertical_blank;
-        processor.request_interrupt(interrupt_type::int_vblank);
+        request_interrupt(interrupt_type::int_vblank);
 
         // Also request a STAT interrupt, if desired.
         if (m_status.vblank_stat == 1) {
-          processor.request_interrupt(interrupt_type::int_lcd);
-        }
-
-        // Update FPS
-        m_current_frame++;
-        m_end = std::chrono::system_clock::now();
-        std::chrono::duration<float, std::milli> frame = (m_end - m_prev);
-        static constexpr float FIXED_TIMESTEP = (1000.0f / 59.7f);
-        if (frame.count() < FIXED_TIMESTEP)
-        {
-          std::this_thread::sleep_for(
-            std::chrono::duration<float, std::milli>(FIXED_TIMESTEP - frame.count())
-          );
+          request_interrupt(interrupt_type::int_lcd);
         }
 
-        std::chrono::duration<float, std::milli> dur = (m_end - m_start);
-        if (dur.count() >= 1000.0f)
-        {
-          m_start = m_end;
-          m_fps = m_current_frame;
-          m_current_frame = 0;
-          std::printf("[renderer] FPS: %lu\n", m_fps);
-        }
-
-        m_prev = std::chrono::system_clock::now();
-        
-        // On VBlank Function
-        if (m_on_vblank != nullptr)
-        {
-          m_on_vblank(*m_emulator);
-        }
+        // Count the completed frame, then finish it up - unless this is the replica, in which case
+        // the renderer forwarding its events does that.
+        m_frame_count++;
+        if (m_frame_skipped == false) { m_drawn_frame_count++; }
+        if (m_primary == nullptr) { finish_frame(); }
 
       }
       else
@@ -291,7 +578,7 @@ namespace smboy
         // to object scan mode.
         m_status.mode = display_mode::dm_object_scan;
         if (m_status.oam_stat == 1) {
-          m_emulator->get_processor().request_interrupt(interrupt_type::int_lcd);
+          request_interrupt(interrupt_type::int_lcd);
         }
 
       }
@@ -303,6 +590,82 @@ namespace smboy
 
   }
 
+  void renderer::begin_frame ()
+  {
+
+    // Skip this frame if asked to explicitly. Otherwise, the fixed frame skip setting decides: skip
+    // frames until the setting's number of frames have been skipped in a row, then draw one.
+    if (m_skip_next_frame == true || m_frame_skip == frame_skip_all) {
+      m_frame_skipped = true;
+    } else {
+      m_frame_skipped = (m_frames_skipped < m_frame_skip);
+    }
+
+    // Keep count of how many frames have been skipped in a row.
+    m_frames_skipped = (m_frame_skipped == true) ? (m_frames_skipped + 1) : 0;
+    m_skip_next_frame = false;
+
+    // Frame format changes take effect here, so that no frame mixes formats.
+    m_frame_format = m_requested_frame_format;
+
+    // If the render thread is enabled, let it know whether or not to draw the new frame, and in
+    // which format. Pixels are drawn here only if the frame isn't skipped, and the render thread
+    // isn't drawing them.
+    forward_event(render_event_type::ret_begin_frame, m_frame_format, m_frame_skipped);
+    m_draw_pixels = (m_frame_skipped == false && m_replica == nullptr);
+    if (m_draw_pixels == true)
+    {
+      start_frame_data();
+    }
+
+  }
+
+  void renderer::finish_frame ()
+  {
+
+    // Count the frame, whether drawn or not.
+    perf_counters& counters = m_emulator->get_counters();
+    counters.frames++;
+    if (m_frame_skipped == false) { counters.drawn_frames++; }
+
+    // If the render thread is drawing this frame, wait for it to catch up to this point.
+    if (m_frame_skipped == false)
+    {
+      sync_render_thread();
+    }
+
+    // Hand the completed frame to the frame sink, if there is one. Skipped frames are not captured,
+    // and neither are speculative frames, which are going to be rolled back.
+    if (
+      m_frame_sink != nullptr &&
+      m_frame_skipped == false &&
+      m_emulator->is_speculative() == false
+    ) {
+      m_frame_sink->submit(m_frame_count, *m_screen);
+    }
+
+    // Hand the frame's worth of band-limited audio samples to the audio output, if it's on.
+    m_emulator->get_audio().end_frame(m_emulator->get_processor().get_tick_cycles());
+
+    // Let the realtime clock catch up with the host's clock, if it follows it.
+    m_emulator->get_realtime().on_frame();
+
+    // On VBlank Function. Speculative frames, which are going to be rolled back, don't count.
+    if (m_on_vblank != nullptr && m_emulator->is_speculative() == false)
+    {
+      m_on_vblank(*m_emulator);
+    }
+
+    // Publish the completed frame to the display thread, then start drawing the next frame
+    // into the new back buffer. Skipped frames have nothing to publish.
+    if (m_frame_skipped == false)
+    {
+      m_frames.publish();
+      m_screen = &m_frames.get_back_frame();
+    }
+
+  }
+
   void renderer::tick_vertical_blank ()
   {
 
@@ -321,13 +684,16 @@ namespace smboy
 
         m_status.mode = display_mode::dm_object_scan;
         if (m_status.oam_stat == 1) {
-          m_emulator->get_processor().request_interrupt(interrupt_type::int_lcd);
+          request_interrupt(interrupt_type::int_lcd);
         }
 
         // Reset the line and window line counters.
         m_line = 0;
         m_window_line = 0;
 
+        // Decide whether or not the new frame will be drawn.
+        begin_frame();
+
       }
 
       // Reset the line ticks.
@@ -350,11 +716,12 @@ namespace smboy
       m_fetcher.fifo_x = 0;
     }
 
-    // Scan the OAM for line objects on the first tick of this mode.
+    // Scan the OAM for line objects on the first tick of this mode. Don't bother scanning if this
+    // frame's pixels aren't being drawn here.
     if (m_line_tick == 1)
     {
       m_line_object_count = 0;
-      load_line_objects();
+      if (m_draw_pixels == true) { load_line_objects(); }
     }
   }
 
@@ -367,13 +734,14 @@ namespace smboy
     if (m_fetcher.pushed_x >= screen_width)
     {
 
-      // Reset the pixel pipeline when we're done with it.
+      // Resolve the finished scanline into the screen buffer, then reset the pixel pipeline.
+      if (m_draw_pixels == true) { composite_line(); }
       reset_pipeline();
 
       // Move to horizontal blank mode. Request a STAT interrupt here if desired.
       m_status.mode = display_mode::dm_horizontal_blank;
       if (m_status.hblank_stat == 1) {
-        m_emulator->get_processor().request_interrupt(interrupt_type::int_lcd);
+        request_interrupt(interrupt_type::int_lcd);
       }
 
     }
@@ -392,13 +760,25 @@ namespace smboy
       }
       else
       {
-        std::uint8_t* oam_bytes = reinterpret_cast<std::uint8_t*>(m_oam);
-        oam_bytes[dma_byte] = m_emulator->get_bus().read_byte(m_dma_source);
+        write_oam_byte(dma_byte, m_emulator->get_bus().read_byte(m_dma_source));
         m_dma_source++;
+        m_emulator->get_counters().dma_bytes++;
       }
     }
   }
 
+  std::uint64_t renderer::get_next_dma_cycle () const
+  {
+
+    // The transfer copies a byte on each machine cycle - every four tick cycles - while active.
+    if ((m_dma_source & 0xFF) >= 0xA0) {
+      return never;
+    }
+
+    return ((get_cycle_count() / 4) + 1) * 4;
+
+  }
+
   /* Object Scan Methods **************************************************************************/
 
   void renderer::clear_line_objects ()
@@ -412,9 +792,11 @@ namespace smboy
     // Don't bother checking for any more objects if the maximum of ten objects were already picked
     // up on this line.
     if (m_line_object_count == objects_per_line) { return; }
+    if (m_line >= screen_height) { return; }
 
-    // Check the control register for the current object height.
-    std::uint8_t object_height = (m_control.tall_objects == 1) ? 16 : 8;
+    // Grab the bucket of objects which reside on the current line. The buckets already account for
+    // each object's X position being greater than zero, and for the current object height.
+    std::uint64_t line_mask = m_line_object_masks[m_line];
 
     // The low bit of the OPRI hardware register dictates how priority among OAM objects is
     // determined.
@@ -425,26 +807,12 @@ namespace smboy
       // If the bit is cleared, then the object's priority is determined by its index in OAM.
       // The lower the index, the higher the priority.
       //
-      // As such, iterate over OAM in reverse order here.
-      for (std::int8_t object_index = object_count - 1; object_index >= 0; --object_index)
+      // As such, pick objects from the bucket in reverse order here.
+      while (line_mask != 0 && m_line_object_count < objects_per_line)
       {
-        const object& obj = m_oam[object_index];
-
-        // Add the object's index to the line object indices array if the following are true:
-        //
-        // - The object's X position is greather than zero.
-        // - The current line counter, plus 16 pixels, is greater than or equal to the object's Y 
-        //    position.
-        // - The current line counter, plus 16 pixels, is less than the object's Y position, plus 
-        //    the object height.
-        if (
-          obj.x_position > 0 &&
-          m_line + 16 >= obj.y_position &&
-          m_line + 16 <  obj.y_position + object_height
-        ) {
-          m_line_object_indices[m_line_object_count++] = object_index;
-          if (m_line_object_count == objects_per_line) { break; }
-        }
+        std::uint8_t object_index = 63 - __builtin_clzll(line_mask);
+        m_line_object_indices[m_line_object_count++] = object_index;
+        line_mask &= ~(1ull << object_index);
       }
 
     }
@@ -454,37 +822,26 @@ namespace smboy
       // If the bit is set, then the object's priority is determined by its X position. The smaller
       // this coordinate, the higher the priority. If two line objects share the same X position,
       // then the object with the lower index in OAM has priority.
-      for (std::size_t object_index = 0; object_index < object_count; ++object_index)
+      //
+      // The ten objects with the lowest OAM indices are picked up first...
+      std::uint64_t picked_mask = 0;
+      std::uint8_t  picked_count = 0;
+      while (line_mask != 0 && picked_count < objects_per_line)
       {
-        const object& obj = m_oam[object_index];
-        
-        if (
-          obj.x_position > 0 &&
-          m_line + 16 >= obj.y_position &&
-          m_line + 16 <  obj.y_position + object_height
-        ) {
-          m_line_object_indices[m_line_object_count++] = object_index;
+        std::uint64_t lowest_bit = (line_mask & (~line_mask + 1));
+        picked_mask |= lowest_bit;
+        line_mask &= ~lowest_bit;
+        picked_count++;
+      }
 
-          // In this case, when a line object is inserted, then the line object indices array needs
-          // to be sorted to ensure that the referenced objects' X positions are in descending
-          // order.
-          std::sort(
-            std::begin(m_line_object_indices),
-            std::begin(m_line_object_indices) + m_line_object_count,
-            [&] (const std::uint8_t index_a, const std::uint8_t index_b)
-            {
-              const auto& object_a = m_oam[index_a];
-              const auto& object_b = m_oam[index_b];
-
-              if (object_a.x_position == object_b.x_position) {
-                return index_a > index_b;
-              } else {
-                return object_a.x_position > object_b.x_position;
-              }
-            }
-          );
-
-          if (m_line_object_count == objects_per_line) { break; }
+      // ...then placed in the line object indices array in the order kept by the priority order
+      // array, so that the referenced objects' X positions are in descending order.
+      for (std::size_t i = 0; i < object_count && m_line_object_count < picked_count; ++i)
+      {
+        std::uint8_t object_index = m_object_priority_order[i];
+        if ((picked_mask >> object_index) & 1)
+        {
+          m_line_object_indices[m_line_object_count++] = object_index;
         }
       }
 
@@ -492,101 +849,141 @@ namespace smboy
 
   }
 
-  /* Pixel Pipeline Methods ***********************************************************************/
-
-  void renderer::push_color_value (std::uint32_t color_value)
+  void renderer::write_oam_byte (std::uint8_t address, std::uint8_t value)
   {
-    // m_fetcher.fifo.push(color_value);
-    // m_fetcher.fifo[m_fetcher.size++] = color_value;
+    std::uint8_t* oam_bytes = reinterpret_cast<std::uint8_t*>(m_oam);
+    if (oam_bytes[address] == value) { return; }
 
-    m_fetcher.fifo[m_fetcher.rear] = color_value;
-    m_fetcher.rear = (m_fetcher.rear + 1) % 32;
-    m_fetcher.size++;
+    oam_bytes[address] = value;
+    forward_event(render_event_type::ret_oam, address, value);
+
+    // Only the Y and X positions of an object affect which lines it resides on, and only its X
+    // position affects its place in the priority order.
+    std::uint8_t object_index = (address / sizeof(object));
+    switch (address % sizeof(object))
+    {
+      case 0:
+        update_object_lines(object_index);
+        break;
+      case 1:
+        update_object_lines(object_index);
+        update_object_priority(object_index);
+        break;
+      default: break;
+    }
   }
 
-  // std::uint32_t renderer::pop_color_value ()
-  void renderer::pop_color_value (std::uint32_t& color_value)
+  void renderer::update_object_lines (std::uint8_t object_index)
   {
-    // std::uint32_t color_value = m_fetcher.fifo.front();
-    // m_fetcher.fifo.pop();
-    // return color_value;
-    // return m_fetcher.fifo[--m_fetcher.size];
+    const object& obj = m_oam[object_index];
+    std::uint64_t object_bit = (1ull << object_index);
 
-    color_value = m_fetcher.fifo[m_fetcher.front];
-    m_fetcher.front = (m_fetcher.front + 1) % 32;
-    m_fetcher.size--;
+    // Remove the object from the buckets of the lines it used to reside on.
+    for (std::uint8_t line = m_object_first_line[object_index];
+      line < m_object_last_line[object_index]; ++line)
+    {
+      m_line_object_masks[line] &= ~object_bit;
+    }
+
+    // An object resides on a line if its X position is greater than zero, and if that line, plus
+    // 16 pixels, lies between the object's Y position and its Y position plus the object height.
+    std::int32_t first_line = 0, last_line = 0;
+    if (obj.x_position > 0)
+    {
+      std::int32_t object_height = (m_control.tall_objects == 1) ? 16 : 8;
+      first_line = std::clamp<std::int32_t>(obj.y_position - 16, 0, screen_height);
+      last_line = std::clamp<std::int32_t>(obj.y_position + object_height - 16, 0, screen_height);
+    }
+
+    // Add the object to the buckets of the lines it now resides on.
+    for (std::int32_t line = first_line; line < last_line; ++line)
+    {
+      m_line_object_masks[line] |= object_bit;
+    }
+
+    m_object_first_line[object_index] = first_line;
+    m_object_last_line[object_index] = std::max(first_line, last_line);
   }
 
-  std::uint32_t renderer::get_bgw_color (std::uint8_t palette_index, std::uint8_t color_index)
+  void renderer::update_object_priority (std::uint8_t object_index)
   {
+    auto begin = std::begin(m_object_priority_order);
+    auto end = std::end(m_object_priority_order);
 
-    // Ensure that the palette and color indices are correct.
-    palette_index = (palette_index  % 8);
-    color_index   = (color_index    % 4);
+    // Move the object to the end of the priority order, leaving the rest of the array sorted...
+    auto current = std::find(begin, end, object_index);
+    std::rotate(current, current + 1, end);
 
-    // Calculate the starting index in color RAM of the color we wish to obtain.
-    std::uint8_t start_index = (palette_index * bytes_per_palette) + (color_index * 2);
+    // ...then rotate it back in at its new place.
+    auto position = std::upper_bound(begin, end - 1, object_index,
+      [&] (const std::uint8_t index_a, const std::uint8_t index_b)
+      {
+        return object_goes_before(index_a, index_b);
+      }
+    );
+    std::rotate(position, end - 1, end);
+  }
 
-    // Retrieve the color components from color RAM. Tney are laid out in the following order:
-    //  - Red, Green, Blue
-    std::uint32_t red = (
-      (m_bg_cram[start_index] & 0b11111000) >> 3
-    ) * 8;
-    std::uint32_t green = (
-      ((m_bg_cram[start_index] & 0b00000111) << 2) |
-      ((m_bg_cram[start_index + 1] & 0b11000000) >> 6)
-    ) * 8;
-    std::uint32_t blue = (
-      (m_bg_cram[start_index + 1] & 0b00111110) >> 1
-    ) * 8;
+  void renderer::rebuild_object_lines ()
+  {
+    std::memset(m_line_object_masks, 0, sizeof(m_line_object_masks));
+    std::memset(m_object_first_line, 0, sizeof(m_object_first_line));
+    std::memset(m_object_last_line, 0, sizeof(m_object_last_line));
 
-    return        (red         ) |
-                  (green  <<  8) |
-                  (blue   << 16) |
-                  0xFF000000;
+    for (std::uint8_t object_index = 0; object_index < object_count; ++object_index)
+    {
+      m_object_priority_order[object_index] = object_index;
+      update_object_lines(object_index);
+    }
 
+    std::sort(
+      std::begin(m_object_priority_order),
+      std::end(m_object_priority_order),
+      [&] (const std::uint8_t index_a, const std::uint8_t index_b)
+      {
+        return object_goes_before(index_a, index_b);
+      }
+    );
   }
 
-  std::uint32_t renderer::get_obj_color (std::uint8_t palette_index, std::uint8_t color_index)
+  bool renderer::object_goes_before (std::uint8_t index_a, std::uint8_t index_b) const
   {
+    const auto& object_a = m_oam[index_a];
+    const auto& object_b = m_oam[index_b];
 
-    // The process of retrieving an object's color works just the same as with the background
-    // color, just with object CRAM.
+    if (object_a.x_position == object_b.x_position) {
+      return index_a > index_b;
+    } else {
+      return object_a.x_position > object_b.x_position;
+    }
+  }
 
-    palette_index = (palette_index  % 8);
-    color_index   = (color_index    % 4);
+  /* Pixel Pipeline Methods ***********************************************************************/
 
-    std::uint8_t start_index = (palette_index * bytes_per_palette) + (color_index * 2);
-    std::uint32_t red = (
-      (m_bg_cram[start_index] & 0b11111000) >> 3
-    ) * 8;
-    std::uint32_t green = (
-      ((m_bg_cram[start_index] & 0b00000111) << 2) |
-      ((m_bg_cram[start_index + 1] & 0b11000000) >> 6)
-    ) * 8;
-    std::uint32_t blue = (
-      (m_bg_cram[start_index + 1] & 0b00111110) >> 1
-    ) * 8;
+  void renderer::push_line_pixel (line_pixel pixel)
+  {
+    m_fetcher.fifo[m_fetcher.rear] = pixel;
+    m_fetcher.rear = (m_fetcher.rear + 1) % 32;
+    m_fetcher.size++;
+  }
 
-    return        (red         ) |
-                  (green  <<  8) |
-                  (blue   << 16) |
-                  0xFF000000;
-  }  
+  void renderer::pop_line_pixel (line_pixel& pixel)
+  {
+    pixel = m_fetcher.fifo[m_fetcher.front];
+    m_fetcher.front = (m_fetcher.front + 1) % 32;
+    m_fetcher.size--;
+  }
 
-  std::uint32_t renderer::fetch_obj_pixel (std::uint8_t bit, std::uint8_t color_index, 
-    std::uint32_t color_value, std::uint8_t bgw_priority)
+  line_pixel renderer::fetch_obj_pixel ()
   {
 
-    // The `color_index` parameter contains the index of the color used to render a background or
-    // window layer tile over which one or more of the objects fetched by the pixel fetcher may
-    // reside.
-    //
-    // Store that old color index here, as we may still need it.
-    std::uint8_t bgw_color_index = color_index;
+    // Deciding which layer is visible on this pixel is left to the line compositor. Here, we only
+    // need to find the color index of each object fetched for this pixel, if any, and fill in the
+    // object slots of the pixel's descriptor.
+    line_pixel obj_slots = 0;
 
     // Loop through the indices of the objects fetched during the processing of the current pixel.
-    for (std::size_t i = 0; i < m_fetcher.fetched_obj_count; ++i)
+    for (std::uint8_t i = 0; i < m_fetcher.fetched_obj_count; ++i)
     {
 
       // Get a handle to the fetched object in OAM.
@@ -603,41 +1000,25 @@ namespace smboy
       std::int8_t offset = m_fetcher.fifo_x - obj_x;
       if (offset < 0 || offset > 7) { continue; }
 
-      // Using the above-calculated offset and the object's `x_flip` attribute, correct the given
-      // bit number.
-      bit = (obj.attributes.x_flip == true) ? offset : (7 - offset);
+      // Using the above-calculated offset and the object's `x_flip` attribute, determine which bit
+      // of the object's tile data to use.
+      std::uint8_t bit = (obj.attributes.x_flip == true) ? offset : (7 - offset);
 
       // Grab the proper bit from the proper low and high bytes. Bitwise OR these bits together to
       // retrieve the color index.
       std::uint8_t  low_bit     = !!(m_fetcher.obj_fetch_data[i * 2] & (1 << bit)),
-                    high_bit    = !!(m_fetcher.obj_fetch_data[(i * 2) + 1] & (1 << bit));
+                    high_bit    = !!(m_fetcher.obj_fetch_data[(i * 2) + 1] & (1 << bit)),
                     color_index = (high_bit << 1) | low_bit;
 
-      // When it comes to objects, a color index of zero indicates transparency. If the color index
-      // retrieved is zero, then ignore this object.
+      // A color index of zero indicates transparency, which the empty slot already describes.
       if (color_index == 0) { continue; }
 
-      // Check to see if one of the following is true:
-      // - The background and window layers do not have priority over this object.
-      // - The background/window color index (`bgw_color_index`) is zero.
-      if (
-        bgw_color_index == 0 ||
-        m_control.bgw_priority == 0 ||
-        (
-          bgw_priority == 0 &&
-          obj.attributes.bgw_priority == 0
-        )
-      ) {
-
-        // Read the proper color value from the object CRAM.
-        color_value = get_obj_color(obj.attributes.palette_number, color_index);
-        if (color_index > 0) { break; }
-
-      }
+      obj_slots |= make_obj_line_pixel(i, color_index, obj.attributes.palette_number,
+        obj.attributes.bgw_priority);
 
     }
 
-    return color_value;
+    return obj_slots;
 
   }
 
@@ -658,6 +1039,16 @@ namespace smboy
     // screen's bounds.
     if (offset_x < 0) { return true; }
 
+    // If this frame's pixels aren't being drawn here, then the contents of the FIFO don't matter;
+    // only the timing does. Just advance the FIFO's counters as if eight pixels had been added.
+    if (m_draw_pixels == false)
+    {
+      m_fetcher.rear = (m_fetcher.rear + 8) % 32;
+      m_fetcher.size += 8;
+      m_fetcher.fifo_x += 8;
+      return true;
+    }
+
     // Iterate over the eight pixels to be added to the fetcher's FIFO.
     for (std::uint8_t i = 0; i < 8; ++i)
     {
@@ -671,17 +1062,18 @@ namespace smboy
       std::uint8_t high_bit    = !!(m_fetcher.bgw_fetch_data[2] & (1 << bit));
       std::uint8_t color_index = (high_bit << 1) | low_bit;
 
-      // Retrieve the proper color to render the background/window pixel.
-      std::uint32_t color_value = get_bgw_color(attributes.palette_number, color_index);
+      // Describe the background/window pixel.
+      line_pixel pixel = make_bgw_line_pixel(color_index, attributes.palette_number,
+        attributes.bgw_priority, m_control.bgw_priority);
 
-      // If the object layer is currently enabled and there is at least one object residing on this
-      // pixel, then fetch the appropriate pixel color from the object with priority, instead.
+      // If the object layer is currently enabled, then describe any objects residing on this pixel,
+      // as well.
       if (m_control.obj_enable == 1) {
-        color_value = fetch_obj_pixel(bit, color_index, color_value, attributes.bgw_priority);
+        pixel |= fetch_obj_pixel();
       }
 
       // Add the pixel to the FIFO.
-      push_color_value(color_value);
+      push_line_pixel(pixel);
       m_fetcher.fifo_x++;
 
     }
@@ -697,20 +1089,15 @@ namespace smboy
     if (m_fetcher.size > 8)
     {
 
-      // Pop the next color value from the FIFO.
-      std::uint32_t color_value; pop_color_value(color_value);
+      // Pop the next pixel descriptor from the FIFO.
+      line_pixel pixel; pop_line_pixel(pixel);
 
       // Ensure that the FIFO's current pixel is within screen bounds.
       if (m_fetcher.line_x >= (m_scroll_x % 8))
       {
-        // Determine the index in the screen buffer where the pixel needs to be emplaced.
-        std::uint32_t index = m_fetcher.pushed_x + (m_line * screen_width);
-
-        (void) color_value;
-        (void) index;
-
-        // Emplace the pixel. Advance the FIFO's pushed pixel count afterward.
-        m_screen[index] = color_value;
+        // Emplace the pixel in the line buffer, if this frame's pixels are being drawn here. Advance
+        // the FIFO's pushed pixel count afterward.
+        if (m_draw_pixels == true) { m_line_pixels[m_fetcher.pushed_x] = pixel; }
         m_fetcher.pushed_x++;
       }
 
@@ -874,9 +1261,14 @@ namespace smboy
           //  - ...background layer.
           //  - ...window layer, if enabled.
           //  - ...object layer, if enabled and there are objects on the current scanline.
-          if (m_control.bgw_priority) { load_background_tile_number(); }
-          if (m_control.bgw_priority && m_control.win_enable) { load_window_tile_number(); }
-          if (m_control.obj_enable && m_line_object_count > 0) { load_object_tile_number(); }
+          //
+          // If this frame's pixels aren't being drawn here, there is no need to fetch anything.
+          if (m_draw_pixels == true)
+          {
+            if (m_control.bgw_priority) { load_background_tile_number(); }
+            if (m_control.bgw_priority && m_control.win_enable) { load_window_tile_number(); }
+            if (m_control.obj_enable && m_line_object_count > 0) { load_object_tile_number(); }
+          }
 
           // Advance the fetcher's X coordinate by 8 pixels, then proceed to fetch the tile data.
           m_fetcher.fetch_x += 8;
@@ -886,6 +1278,12 @@ namespace smboy
 
         case pixel_fetch_mode::pfm_tile_data_low: {
 
+          // Frames whose pixels aren't being drawn here fetch no tile data.
+          if (m_draw_pixels == false) {
+            m_fetcher.mode = pixel_fetch_mode::pfm_tile_data_high;
+            break;
+          }
+
           // Get the number of the tile that needs to be fetched, then the target address to fetch
           // from. Adjust according to the BGW tile data area flag, if needed.
           std::uint8_t  tile_number = m_fetcher.bgw_fetch_data[0];
@@ -915,6 +1313,11 @@ namespace smboy
 
         case pixel_fetch_mode::pfm_tile_data_high: {
 
+          if (m_draw_pixels == false) {
+            m_fetcher.mode = pixel_fetch_mode::pfm_sleep;
+            break;
+          }
+
           // Repeat the same process as with `pfm_tile_data_low`, except now for the high byte of
           // the tile. Offset the target address by an additional 1.
           std::uint8_t  tile_number = m_fetcher.bgw_fetch_data[0];
@@ -962,7 +1365,111 @@ namespace smboy
     m_fetcher.front = 0;
     m_fetcher.rear = 0;
   }
+
+  void renderer::composite_line ()
+  {
+    m_compositor(m_line_pixels, m_line_indices, screen_width);
+
+    #if defined(SM166_DEBUG)
+
+      // In debug builds, check the selected compositor's output against the scalar compositor.
+      if (m_compositor != composite_line_scalar)
+      {
+        std::uint8_t expected[screen_width];
+        composite_line_scalar(m_line_pixels, expected, screen_width);
+        if (std::memcmp(expected, m_line_indices, sizeof(expected)) != 0)
+        {
+          std::cerr << "[renderer] The " << get_line_compositor_name(m_compositor)
+                    << " line compositor disagrees with the scalar compositor on line "
+                    << (int) m_line << "." << std::endl;
+        }
+      }
+
+    #endif
+
+    // Store the scanline's palette indices in the frame's format.
+    std::size_t offset = m_line * screen_width;
+    switch (m_screen->format)
+    {
+      case frame_format::ff_rgb565:
+      {
+        std::uint16_t* line = reinterpret_cast<std::uint16_t*>(m_screen->pixels) + offset;
+        for (std::size_t x = 0; x < screen_width; ++x)
+        {
+          line[x] = m_palette565[m_line_indices[x]];
+        }
+      } break;
+
+      case frame_format::ff_indexed8:
+      {
+
+        // Indexed frames keep the indices as they are. If the palette has changed since the last
+        // snapshot was taken, take a new one for this scanline.
+        if (m_palette_dirty == true)
+        {
+          std::memcpy(m_screen->palettes[m_screen->palette_count++], m_palette, sizeof(m_palette));
+          m_palette_dirty = false;
+        }
+
+        std::memcpy(m_screen->pixels + offset, m_line_indices, screen_width);
+        m_screen->line_palettes[m_line] = m_screen->palette_count - 1;
+
+      } break;
+
+      default:
+        m_expander(m_line_indices, m_palette,
+          reinterpret_cast<std::uint32_t*>(m_screen->pixels) + offset, screen_width);
+        break;
+    }
+  }
+
+  void renderer::start_frame_data ()
+  {
+    m_screen->format = m_frame_format;
+
+    // Indexed frames start with a snapshot of the current palette, which every scanline uses until
+    // the palette changes.
+    if (m_frame_format == frame_format::ff_indexed8)
+    {
+      std::memcpy(m_screen->palettes[0], m_palette, sizeof(m_palette));
+      std::memset(m_screen->line_palettes, 0, sizeof(m_screen->line_palettes));
+      m_screen->palette_count = 1;
+      m_palette_dirty = false;
+    }
+    else
+    {
+      m_screen->palette_count = 0;
+    }
+  }
   
+  /* Palette Cache Methods ************************************************************************/
+
+  void renderer::update_bg_palette_color (std::uint8_t address)
+  {
+
+    // Palette specification addresses can run past the end of color RAM. Ignore those.
+    if (address >= cram_size) { return; }
+
+    // Each color occupies two bytes of color RAM. Re-decode the color containing the byte at the
+    // given address.
+    std::uint8_t start_index = (address & ~1);
+    m_palette[start_index / 2] = decode_cram_color(m_bg_cram, start_index);
+    m_palette565[start_index / 2] = pack_rgb565(m_palette[start_index / 2]);
+    m_palette_dirty = true;
+
+  }
+
+  void renderer::update_obj_palette_color (std::uint8_t address)
+  {
+    if (address >= cram_size) { return; }
+
+    std::uint8_t start_index = (address & ~1);
+    std::uint8_t color_index = cram_color_count + (start_index / 2);
+    m_palette[color_index] = decode_cram_color(m_obj_cram, start_index);
+    m_palette565[color_index] = pack_rgb565(m_palette[color_index]);
+    m_palette_dirty = true;
+  }
+
   /* Helper Methods *******************************************************************************/
 
   bool renderer::is_window_visible () const
@@ -990,12 +1497,205 @@ namespace smboy
       
       // Request a STAT interrupt if it's enabled.
       if (m_status.lyc_stat == 1) {
-        m_emulator->get_processor().request_interrupt(interrupt_type::int_lcd);
+        request_interrupt(interrupt_type::int_lcd);
       }
     } else {
       m_status.line_compare = 0;
     }
 
+    // Let the render thread, if enabled, catch up to the new line.
+    forward_event(render_event_type::ret_advance);
+
+  }
+
+  void renderer::request_interrupt (interrupt_type type)
+  {
+
+    // Only the renderer which the CPU can see requests interrupts.
+    if (m_primary != nullptr) { return; }
+
+    m_emulator->get_processor().request_interrupt(type);
+
+  }
+
+  /* Render Thread Methods ************************************************************************/
+
+  void renderer::set_render_thread_enabled (bool enabled)
+  {
+    m_render_thread_requested = enabled;
+    reschedule();
+  }
+
+  void renderer::start_render_thread ()
+  {
+    if (m_replica != nullptr) { return; }
+
+    // Create the replica as an exact copy of this renderer's current state. It draws into this
+    // renderer's back buffer.
+    m_render_queue = std::make_unique<render_queue>();
+    m_replica = std::make_unique<renderer>();
+    m_replica->copy_state_from(*this);
+    m_replica->m_emulator = m_emulator;
+    m_replica->m_primary = this;
+    m_replica->m_screen = m_screen;
+    m_replica->m_compositor = m_compositor;
+    m_replica->m_expander = m_expander;
+
+    // From here on, this renderer only keeps the timing. The render thread draws the pixels.
+    m_draw_pixels = false;
+    m_render_thread = std::thread { &renderer::run_render_thread, m_replica.get() };
+  }
+
+  void renderer::stop_render_thread ()
+  {
+    if (m_replica == nullptr) { return; }
+
+    // The render thread replays everything forwarded so far before it stops.
+    forward_event(render_event_type::ret_stop);
+    m_render_thread.join();
+
+    // Everything the CPU can see is already up to date here. Take back the replica's pixel pipeline,
+    // so that the scanline in progress, if any, is finished here.
+    copy_pipeline_from(*m_replica);
+
+    m_replica.reset();
+    m_render_queue.reset();
+  }
+
+  void renderer::sync_render_thread ()
+  {
+    if (m_replica == nullptr) { return; }
+
+    // The render thread waits for the next event once it has reported, so its state may be read
+    // or written until then.
+    m_render_queue->sync(get_cycle_count());
+  }
+
+  void renderer::run_render_thread ()
+  {
+    render_queue& queue = *(m_primary->m_render_queue);
+
+    while (true)
+    {
+
+      // Count this replica's own dots up to the next event's tick stamp, then replay it.
+      render_event event = queue.pop();
+      while (m_step_cycle < event.stamp)
+      {
+        m_step_cycle++;
+        if (m_control.master_enable == true) { tick_dot(); }
+      }
+
+      switch (event.type)
+      {
+        case render_event_type::ret_advance: break;
+        case render_event_type::ret_sync: queue.report_sync(); break;
+        case render_event_type::ret_stop: return;
+        default: replay_event(event); break;
+      }
+
+    }
+  }
+
+  void renderer::forward_event (render_event_type type, std::uint32_t address, std::uint8_t value)
+  {
+    // Events are stamped with the processor's tick cycle count.
+    if (m_render_queue != nullptr)
+    {
+      m_render_queue->push({ get_cycle_count(), address, type, value });
+    }
+  }
+
+  void renderer::replay_event (const render_event& event)
+  {
+    switch (event.type)
+    {
+      case render_event_type::ret_begin_frame:
+        m_frame_skipped = (event.value != 0);
+        m_draw_pixels = (event.value == 0);
+        m_frame_format = static_cast<frame_format>(event.address);
+        m_screen = &m_primary->m_frames.get_back_frame();
+        if (m_draw_pixels == true)
+        {
+          start_frame_data();
+        }
+        break;
+
+      // The forwarding renderer has already applied the memory access gating.
+      case render_event_type::ret_vram:   m_vram[event.address] = event.value; break;
+      case render_event_type::ret_oam:    write_oam_byte(event.address, event.value); break;
+
+      case render_event_type::ret_lcdc:   write_reg_lcdc(event.value); break;
+      case render_event_type::ret_scy:    write_reg_scy(event.value); break;
+      case render_event_type::ret_scx:    write_reg_scx(event.value); break;
+      case render_event_type::ret_wy:     write_reg_wy(event.value); break;
+      case render_event_type::ret_wx:     write_reg_wx(event.value); break;
+      case render_event_type::ret_vbk:    write_reg_vbk(event.value); break;
+      case render_event_type::ret_bcps:   write_reg_bcps(event.value); break;
+      case render_event_type::ret_bcpd:   write_reg_bcpd(event.value); break;
+      case render_event_type::ret_obps:   write_reg_obps(event.value); break;
+      case render_event_type::ret_obpd:   write_reg_obpd(event.value); break;
+      case render_event_type::ret_opri:   write_reg_opri(event.value); break;
+      default: break;
+    }
+  }
+
+  void renderer::copy_state_from (const renderer& other)
+  {
+
+    // Memory Storage and Palette Cache
+    std::memcpy(m_vram0, other.m_vram0, sizeof(m_vram0));
+    std::memcpy(m_vram1, other.m_vram1, sizeof(m_vram1));
+    std::memcpy(m_oam, other.m_oam, sizeof(m_oam));
+    std::memcpy(m_bg_cram, other.m_bg_cram, sizeof(m_bg_cram));
+    std::memcpy(m_obj_cram, other.m_obj_cram, sizeof(m_obj_cram));
+    std::memcpy(m_palette, other.m_palette, sizeof(m_palette));
+    std::memcpy(m_palette565, other.m_palette565, sizeof(m_palette565));
+    m_palette_dirty     = other.m_palette_dirty;
+
+    // Hardware Registers
+    m_control           = other.m_control;
+    m_status            = other.m_status;
+    m_scroll_y          = other.m_scroll_y;
+    m_scroll_x          = other.m_scroll_x;
+    m_line              = other.m_line;
+    m_line_compare      = other.m_line_compare;
+    m_window_y          = other.m_window_y;
+    m_window_x          = other.m_window_x;
+    m_vram_bank         = other.m_vram_bank;
+    m_bg_pal_spec       = other.m_bg_pal_spec;
+    m_obj_pal_spec      = other.m_obj_pal_spec;
+    m_priority_mode     = other.m_priority_mode;
+    m_vram              = (sm_getbit(m_vram_bank, 0) == 0) ? m_vram0 : m_vram1;
+
+    // Internal Values
+    m_dma_source        = other.m_dma_source;
+    m_dma_delay         = other.m_dma_delay;
+    m_line_tick         = other.m_line_tick;
+    m_window_line       = other.m_window_line;
+    m_step_cycle        = other.m_step_cycle;
+
+    // Pixel Pipeline and Object Scan
+    m_fetcher           = other.m_fetcher;
+    m_line_object_count = other.m_line_object_count;
+    std::memcpy(m_line_pixels, other.m_line_pixels, sizeof(m_line_pixels));
+    std::memcpy(m_line_object_indices, other.m_line_object_indices, sizeof(m_line_object_indices));
+    rebuild_object_lines();
+
+    // Frame Skipping and Frame Format
+    m_frame_skipped     = other.m_frame_skipped;
+    m_draw_pixels       = other.m_draw_pixels;
+    m_frame_format      = other.m_frame_format;
+
+  }
+
+  void renderer::copy_pipeline_from (const renderer& other)
+  {
+    m_fetcher = other.m_fetcher;
+    m_line_object_count = other.m_line_object_count;
+    std::memcpy(m_line_pixels, other.m_line_pixels, sizeof(m_line_pixels));
+    std::memcpy(m_line_object_indices, other.m_line_object_indices, sizeof(m_line_object_indices));
+    m_draw_pixels = other.m_draw_pixels;
   }
 
 }
@@ -0,0 +1,71 @@
+/** @file smboy/resampler.cpp */
+
+#include <smboy/resampler.hpp>
+
+namespace smboy
+{
+
+  /** Public Methods ******************************************************************************/
+
+  void rate_resampler::reset ()
+  {
+    m_ratio = 1.0;
+    m_position = 1.0;
+    m_input.assign(history_frames * 2, 0.0f);
+    m_output.clear();
+  }
+
+  std::size_t rate_resampler::process (const std::int16_t* samples, std::size_t frame_count,
+    double fill_level)
+  {
+
+    // Produce slightly more frames while the device's buffer is emptier than the target, and
+    // slightly fewer while it's fuller, in proportion to how far off the target it is.
+    double error = std::clamp((m_fill_target - fill_level) / m_fill_target, -1.0, 1.0);
+    m_ratio = 1.0 + error * m_max_deviation;
+    double step = 1.0 / m_ratio;
+
+    // Append the batch's frames to the previous batch's last few frames.
+    m_input.resize(history_frames * 2);
+    m_input.insert(m_input.end(), samples, samples + frame_count * 2);
+    std::size_t total_frames = m_input.size() / 2;
+
+    m_output.clear();
+    m_output.reserve(static_cast<std::size_t>(frame_count * m_ratio + 2) * 2);
+
+    // Interpolate output frames for as long as there are two input frames ahead of the position.
+    while (true)
+    {
+      std::size_t index = static_cast<std::size_t>(m_position);
+      if (index + 2 >= total_frames) { break; }
+
+      float t = static_cast<float>(m_position - index);
+      const float* frame = m_input.data() + (index - 1) * 2;
+      for (std::size_t channel = 0; channel < 2; ++channel)
+      {
+        float y0 = frame[channel], y1 = frame[channel + 2],
+              y2 = frame[channel + 4], y3 = frame[channel + 6];
+
+        float c1 = 0.5f * (y2 - y0);
+        float c2 = y0 - 2.5f * y1 + 2.0f * y2 - 0.5f * y3;
+        float c3 = 0.5f * (y3 - y0) + 1.5f * (y1 - y2);
+        float value = ((c3 * t + c2) * t + c1) * t + y1;
+
+        m_output.push_back(static_cast<std::int16_t>(
+          std::clamp(std::lround(value), -32768l, 32767l)
+        ));
+      }
+
+      m_position += step;
+    }
+
+    // Keep the last few frames for the next batch, and move the position back to match.
+    std::copy(m_input.end() - history_frames * 2, m_input.end(), m_input.begin());
+    m_input.resize(history_frames * 2);
+    m_position -= static_cast<double>(total_frames - history_frames);
+
+    return m_output.size() / 2;
+
+  }
+
+}
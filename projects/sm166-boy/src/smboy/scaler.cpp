@@ -0,0 +1,700 @@
+/** @file smboy/scaler.cpp */
+
+#include <smboy/scaler.hpp>
+
+#if defined(__x86_64__) || defined(__i386__)
+  #define SMBOY_X86_SCALERS
+  #include <immintrin.h>
+#endif
+
+namespace smboy
+{
+
+  /** Private Functions - Host Support ************************************************************/
+
+  // The vector instruction sets available to the scalers: 0 for none, 1 for SSE2, 2 for AVX2.
+  static int get_vector_level ()
+  {
+#if defined(SMBOY_X86_SCALERS)
+    static const int level = [] ()
+    {
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("avx2")) { return 2; }
+      if (__builtin_cpu_supports("sse2")) { return 1; }
+      return 0;
+    } ();
+
+    return level;
+#else
+    return 0;
+#endif
+  }
+
+  /** Private Functions - Scalar Scalers **********************************************************/
+
+  // Repeats each pixel of a row `factor` times.
+  static void expand_row_scalar (const std::uint32_t* input, std::size_t width,
+    std::uint32_t* output, std::uint32_t factor)
+  {
+    for (std::size_t x = 0; x < width; ++x)
+    {
+      for (std::uint32_t i = 0; i < factor; ++i)
+      {
+        output[(x * factor) + i] = input[x];
+      }
+    }
+  }
+
+  // Halves the brightness of each pixel of a row, leaving it opaque.
+  static void darken_row_scalar (const std::uint32_t* input, std::uint32_t* output,
+    std::size_t width)
+  {
+    for (std::size_t x = 0; x < width; ++x)
+    {
+      output[x] = ((input[x] >> 1) & 0x007F7F7F) | 0xFF000000;
+    }
+  }
+
+  // Copies a frame, surrounded by a one-pixel border of repeated edge pixels, so that the ScaleNx
+  // filters can read every pixel's neighbors without checking for edges.
+  static void pad_frame (const std::uint32_t* input, std::size_t width, std::size_t height,
+    std::vector<std::uint32_t>& padded)
+  {
+    std::size_t stride = width + 2;
+    padded.resize(stride * (height + 2));
+
+    for (std::size_t y = 0; y < height + 2; ++y)
+    {
+      const std::uint32_t* source = input + (std::clamp<std::size_t>(y, 1, height) - 1) * width;
+      std::uint32_t* row = padded.data() + (y * stride);
+
+      row[0] = source[0];
+      std::memcpy(row + 1, source, width * sizeof(std::uint32_t));
+      row[width + 1] = source[width - 1];
+    }
+  }
+
+  // Scale2x, for the pixels from `x` onward of row `y`. In each 3x3 neighborhood, `E` is the pixel
+  // being scaled; `B`, `D`, `F` and `H` are the pixels above, to the left, to the right and below.
+  static void scale2x_scalar (const std::uint32_t* padded, std::size_t width, std::size_t y,
+    std::size_t x, std::uint32_t* output)
+  {
+    std::size_t stride = width + 2;
+    std::uint32_t* row0 = output + (y * 2) * (width * 2);
+    std::uint32_t* row1 = row0 + (width * 2);
+
+    for (; x < width; ++x)
+    {
+      const std::uint32_t* center = padded + ((y + 1) * stride) + (x + 1);
+      std::uint32_t b = center[-stride], d = center[-1], e = center[0], f = center[1],
+                    h = center[stride];
+
+      // Only round off an edge where the neighborhood forms a corner.
+      bool corner = (b != h && d != f);
+      row0[(x * 2)    ] = (corner && d == b) ? d : e;
+      row0[(x * 2) + 1] = (corner && b == f) ? f : e;
+      row1[(x * 2)    ] = (corner && d == h) ? d : e;
+      row1[(x * 2) + 1] = (corner && h == f) ? f : e;
+    }
+  }
+
+  // Scale3x, for the pixels from `x` onward of row `y`. The neighborhood is `A B C / D E F / G H I`.
+  static void scale3x_scalar (const std::uint32_t* padded, std::size_t width, std::size_t y,
+    std::size_t x, std::uint32_t* output)
+  {
+    std::size_t stride = width + 2;
+    std::uint32_t* row0 = output + (y * 3) * (width * 3);
+    std::uint32_t* row1 = row0 + (width * 3);
+    std::uint32_t* row2 = row1 + (width * 3);
+
+    for (; x < width; ++x)
+    {
+      const std::uint32_t* center = padded + ((y + 1) * stride) + (x + 1);
+      std::uint32_t a = center[-stride - 1], b = center[-stride], c = center[-stride + 1],
+                    d = center[-1],          e = center[0],       f = center[1],
+                    g = center[stride - 1],  h = center[stride],  i = center[stride + 1];
+
+      bool corner = (b != h && d != f);
+      std::uint32_t* out0 = row0 + (x * 3);
+      std::uint32_t* out1 = row1 + (x * 3);
+      std::uint32_t* out2 = row2 + (x * 3);
+
+      out0[0] = (corner && d == b) ? d : e;
+      out0[1] = (corner && ((d == b && e != c) || (b == f && e != a))) ? b : e;
+      out0[2] = (corner && b == f) ? f : e;
+      out1[0] = (corner && ((d == b && e != g) || (d == h && e != a))) ? d : e;
+      out1[1] = e;
+      out1[2] = (corner && ((b == f && e != i) || (h == f && e != c))) ? f : e;
+      out2[0] = (corner && d == h) ? d : e;
+      out2[1] = (corner && ((d == h && e != i) || (h == f && e != g))) ? h : e;
+      out2[2] = (corner && h == f) ? f : e;
+    }
+  }
+
+  /** Private Functions - Vector Scalers **********************************************************/
+
+#if defined(SMBOY_X86_SCALERS)
+
+  // The vector scalers work just the same as the scalar scalers above. The ScaleNx filters replace
+  // their per-pixel branches with lane masks, selecting between the center pixel and its neighbors.
+
+  static void expand_row_sse2 (const std::uint32_t* input, std::size_t width,
+    std::uint32_t* output, std::uint32_t factor)
+  {
+    std::size_t x = 0;
+    if (factor == 2)
+    {
+      for (; x + 4 <= width; x += 4)
+      {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + x));
+        __m128i* out = reinterpret_cast<__m128i*>(output + (x * 2));
+        _mm_storeu_si128(out,     _mm_unpacklo_epi32(pixels, pixels));
+        _mm_storeu_si128(out + 1, _mm_unpackhi_epi32(pixels, pixels));
+      }
+    }
+    else if (factor == 4)
+    {
+      for (; x + 4 <= width; x += 4)
+      {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + x));
+        __m128i* out = reinterpret_cast<__m128i*>(output + (x * 4));
+        _mm_storeu_si128(out,     _mm_shuffle_epi32(pixels, 0x00));
+        _mm_storeu_si128(out + 1, _mm_shuffle_epi32(pixels, 0x55));
+        _mm_storeu_si128(out + 2, _mm_shuffle_epi32(pixels, 0xAA));
+        _mm_storeu_si128(out + 3, _mm_shuffle_epi32(pixels, 0xFF));
+      }
+    }
+    else if (factor > 4)
+    {
+
+      // Broadcast each pixel, then store it four at a time.
+      for (; x < width; ++x)
+      {
+        __m128i pixel = _mm_set1_epi32(static_cast<int>(input[x]));
+        std::uint32_t* out = output + (x * factor);
+        std::uint32_t i = 0;
+        for (; i + 4 <= factor; i += 4)
+        {
+          _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), pixel);
+        }
+        for (; i < factor; ++i) { out[i] = input[x]; }
+      }
+
+    }
+
+    expand_row_scalar(input + x, width - x, output + (x * factor), factor);
+  }
+
+  // Interleaves the lanes of three vectors, `a0 b0 c0 a1 b1 c1 ...`, into three vectors' worth of
+  // output. Each output vector gathers its lanes from all three inputs, then blends them together.
+  __attribute__((target("avx2")))
+  static inline void interleave3_avx2 (__m256i a, __m256i b, __m256i c, std::uint32_t* output)
+  {
+    const __m256i index0 = _mm256_setr_epi32(0, 0, 0, 1, 1, 1, 2, 2);
+    const __m256i index1 = _mm256_setr_epi32(2, 3, 3, 3, 4, 4, 4, 5);
+    const __m256i index2 = _mm256_setr_epi32(5, 5, 6, 6, 6, 7, 7, 7);
+
+    __m256i out0 = _mm256_permutevar8x32_epi32(a, index0);
+    out0 = _mm256_blend_epi32(out0, _mm256_permutevar8x32_epi32(b, index0), 0b10010010);
+    out0 = _mm256_blend_epi32(out0, _mm256_permutevar8x32_epi32(c, index0), 0b00100100);
+
+    __m256i out1 = _mm256_permutevar8x32_epi32(a, index1);
+    out1 = _mm256_blend_epi32(out1, _mm256_permutevar8x32_epi32(b, index1), 0b00100100);
+    out1 = _mm256_blend_epi32(out1, _mm256_permutevar8x32_epi32(c, index1), 0b01001001);
+
+    __m256i out2 = _mm256_permutevar8x32_epi32(a, index2);
+    out2 = _mm256_blend_epi32(out2, _mm256_permutevar8x32_epi32(b, index2), 0b01001001);
+    out2 = _mm256_blend_epi32(out2, _mm256_permutevar8x32_epi32(c, index2), 0b10010010);
+
+    __m256i* out = reinterpret_cast<__m256i*>(output);
+    _mm256_storeu_si256(out,     out0);
+    _mm256_storeu_si256(out + 1, out1);
+    _mm256_storeu_si256(out + 2, out2);
+  }
+
+  // SSE2's unpacks and shuffles already keep up with the stores for factors of two and four, so
+  // AVX2 is only used where it can do better: factors of three, which SSE2 can't interleave, and
+  // factors of eight and up, which take whole 256-bit stores.
+  __attribute__((target("avx2")))
+  static void expand_row_avx2 (const std::uint32_t* input, std::size_t width,
+    std::uint32_t* output, std::uint32_t factor)
+  {
+    if (factor != 3 && factor < 8)
+    {
+      expand_row_sse2(input, width, output, factor);
+      return;
+    }
+
+    std::size_t x = 0;
+    if (factor == 3)
+    {
+      for (; x + 8 <= width; x += 8)
+      {
+        __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + x));
+        interleave3_avx2(pixels, pixels, pixels, output + (x * 3));
+      }
+    }
+    else
+    {
+
+      // Broadcast each pixel, then store it eight at a time.
+      for (; x < width; ++x)
+      {
+        __m256i pixel = _mm256_set1_epi32(static_cast<int>(input[x]));
+        std::uint32_t* out = output + (x * factor);
+        std::uint32_t i = 0;
+        for (; i + 8 <= factor; i += 8)
+        {
+          _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), pixel);
+        }
+        for (; i < factor; ++i) { out[i] = input[x]; }
+      }
+
+    }
+
+    expand_row_scalar(input + x, width - x, output + (x * factor), factor);
+  }
+
+  static void darken_row_sse2 (const std::uint32_t* input, std::uint32_t* output,
+    std::size_t width)
+  {
+    const __m128i color_mask = _mm_set1_epi32(0x007F7F7F);
+    const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000));
+
+    std::size_t x = 0;
+    for (; x + 4 <= width; x += 4)
+    {
+      __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + x));
+      pixels = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(pixels, 1), color_mask), alpha);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(output + x), pixels);
+    }
+
+    darken_row_scalar(input + x, output + x, width - x);
+  }
+
+  __attribute__((target("avx2")))
+  static void darken_row_avx2 (const std::uint32_t* input, std::uint32_t* output,
+    std::size_t width)
+  {
+    const __m256i color_mask = _mm256_set1_epi32(0x007F7F7F);
+    const __m256i alpha = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+
+    std::size_t x = 0;
+    for (; x + 8 <= width; x += 8)
+    {
+      __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + x));
+      pixels = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(pixels, 1), color_mask), alpha);
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + x), pixels);
+    }
+
+    darken_row_scalar(input + x, output + x, width - x);
+  }
+
+  // Selects `b` in the lanes where `mask` is set, and `a` elsewhere.
+  static inline __m128i select_sse2 (__m128i mask, __m128i a, __m128i b)
+  {
+    return _mm_or_si128(_mm_and_si128(mask, b), _mm_andnot_si128(mask, a));
+  }
+
+  static void scale2x_sse2 (const std::uint32_t* padded, std::size_t width, std::size_t height,
+    std::uint32_t* output)
+  {
+    std::size_t stride = width + 2;
+    const __m128i ones = _mm_set1_epi32(-1);
+
+    for (std::size_t y = 0; y < height; ++y)
+    {
+      std::uint32_t* row0 = output + (y * 2) * (width * 2);
+      std::uint32_t* row1 = row0 + (width * 2);
+
+      std::size_t x = 0;
+      for (; x + 4 <= width; x += 4)
+      {
+        const std::uint32_t* center = padded + ((y + 1) * stride) + (x + 1);
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(center - stride));
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(center - 1));
+        __m128i e = _mm_loadu_si128(reinterpret_cast<const __m128i*>(center));
+        __m128i f = _mm_loadu_si128(reinterpret_cast<const __m128i*>(center + 1));
+        __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(center + stride));
+
+        __m128i corner = _mm_andnot_si128(
+          _mm_or_si128(_mm_cmpeq_epi32(b, h), _mm_cmpeq_epi32(d, f)),
+          ones
+        );
+        __m128i e0 = select_sse2(_mm_and_si128(corner, _mm_cmpeq_epi32(d, b)), e, d);
+        __m128i e1 = select_sse2(_mm_and_si128(corner, _mm_cmpeq_epi32(b, f)), e, f);
+        __m128i e2 = select_sse2(_mm_and_si128(corner, _mm_cmpeq_epi32(d, h)), e, d);
+        __m128i e3 = select_sse2(_mm_and_si128(corner, _mm_cmpeq_epi32(h, f)), e, f);
+
+        // Interleave the left and right output pixels of each row.
+        __m128i* out0 = reinterpret_cast<__m128i*>(row0 + (x * 2));
+        __m128i* out1 = reinterpret_cast<__m128i*>(row1 + (x * 2));
+        _mm_storeu_si128(out0,     _mm_unpacklo_epi32(e0, e1));
+        _mm_storeu_si128(out0 + 1, _mm_unpackhi_epi32(e0, e1));
+        _mm_storeu_si128(out1,     _mm_unpacklo_epi32(e2, e3));
+        _mm_storeu_si128(out1 + 1, _mm_unpackhi_epi32(e2, e3));
+      }
+
+      scale2x_scalar(padded, width, y, x, output);
+    }
+  }
+
+  __attribute__((target("avx2")))
+  static void scale2x_avx2 (const std::uint32_t* padded, std::size_t width, std::size_t height,
+    std::uint32_t* output)
+  {
+    std::size_t stride = width + 2;
+    const __m256i ones = _mm256_set1_epi32(-1);
+
+    for (std::size_t y = 0; y < height; ++y)
+    {
+      std::uint32_t* row0 = output + (y * 2) * (width * 2);
+      std::uint32_t* row1 = row0 + (width * 2);
+
+      std::size_t x = 0;
+      for (; x + 8 <= width; x += 8)
+      {
+        const std::uint32_t* center = padded + ((y + 1) * stride) + (x + 1);
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(center - stride));
+        __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(center - 1));
+        __m256i e = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(center));
+        __m256i f = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(center + 1));
+        __m256i h = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(center + stride));
+
+        __m256i corner = _mm256_andnot_si256(
+          _mm256_or_si256(_mm256_cmpeq_epi32(b, h), _mm256_cmpeq_epi32(d, f)),
+          ones
+        );
+        __m256i e0 = _mm256_blendv_epi8(e, d,
+          _mm256_and_si256(corner, _mm256_cmpeq_epi32(d, b)));
+        __m256i e1 = _mm256_blendv_epi8(e, f,
+          _mm256_and_si256(corner, _mm256_cmpeq_epi32(b, f)));
+        __m256i e2 = _mm256_blendv_epi8(e, d,
+          _mm256_and_si256(corner, _mm256_cmpeq_epi32(d, h)));
+        __m256i e3 = _mm256_blendv_epi8(e, f,
+          _mm256_and_si256(corner, _mm256_cmpeq_epi32(h, f)));
+
+        // The AVX2 unpacks work within each 128-bit half, so put the halves back in order after.
+        __m256i lo0 = _mm256_unpacklo_epi32(e0, e1), hi0 = _mm256_unpackhi_epi32(e0, e1);
+        __m256i lo1 = _mm256_unpacklo_epi32(e2, e3), hi1 = _mm256_unpackhi_epi32(e2, e3);
+        __m256i* out0 = reinterpret_cast<__m256i*>(row0 + (x * 2));
+        __m256i* out1 = reinterpret_cast<__m256i*>(row1 + (x * 2));
+        _mm256_storeu_si256(out0,     _mm256_permute2x128_si256(lo0, hi0, 0x20));
+        _mm256_storeu_si256(out0 + 1, _mm256_permute2x128_si256(lo0, hi0, 0x31));
+        _mm256_storeu_si256(out1,     _mm256_permute2x128_si256(lo1, hi1, 0x20));
+        _mm256_storeu_si256(out1 + 1, _mm256_permute2x128_si256(lo1, hi1, 0x31));
+      }
+
+      scale2x_scalar(padded, width, y, x, output);
+    }
+  }
+
+  static void scale3x_sse2 (const std::uint32_t* padded, std::size_t width, std::size_t height,
+    std::uint32_t* output)
+  {
+    std::size_t stride = width + 2;
+    const __m128i ones = _mm_set1_epi32(-1);
+    alignas(16) std::uint32_t results[9][4];
+
+    for (std::size_t y = 0; y < height; ++y)
+    {
+      std::uint32_t* row0 = output + (y * 3) * (width * 3);
+      std::uint32_t* row1 = row0 + (width * 3);
+      std::uint32_t* row2 = row1 + (width * 3);
+
+      std::size_t x = 0;
+      for (; x + 4 <= width; x += 4)
+      {
+        const std::uint32_t* center = padded + ((y + 1) * stride) + (x + 1);
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(center - stride - 1));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(center - stride));
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(center - stride + 1));
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(center - 1));
+        __m128i e = _mm_loadu_si128(reinterpret_cast<const __m128i*>(center));
+        __m128i f = _mm_loadu_si128(reinterpret_cast<const __m128i*>(center + 1));
+        __m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i*>(center + stride - 1));
+        __m128i h = _mm_loadu_si128(reinterpret_cast<const __m128i*>(center + stride));
+        __m128i i = _mm_loadu_si128(reinterpret_cast<const __m128i*>(center + stride + 1));
+
+        __m128i corner = _mm_andnot_si128(
+          _mm_or_si128(_mm_cmpeq_epi32(b, h), _mm_cmpeq_epi32(d, f)),
+          ones
+        );
+        __m128i db = _mm_and_si128(corner, _mm_cmpeq_epi32(d, b));
+        __m128i bf = _mm_and_si128(corner, _mm_cmpeq_epi32(b, f));
+        __m128i dh = _mm_and_si128(corner, _mm_cmpeq_epi32(d, h));
+        __m128i hf = _mm_and_si128(corner, _mm_cmpeq_epi32(h, f));
+        __m128i ea = _mm_cmpeq_epi32(e, a), ec = _mm_cmpeq_epi32(e, c),
+                eg = _mm_cmpeq_epi32(e, g), ei = _mm_cmpeq_epi32(e, i);
+
+        __m128i* out = reinterpret_cast<__m128i*>(results);
+        _mm_store_si128(out + 0, select_sse2(db, e, d));
+        _mm_store_si128(out + 1, select_sse2(
+          _mm_or_si128(_mm_andnot_si128(ec, db), _mm_andnot_si128(ea, bf)), e, b));
+        _mm_store_si128(out + 2, select_sse2(bf, e, f));
+        _mm_store_si128(out + 3, select_sse2(
+          _mm_or_si128(_mm_andnot_si128(eg, db), _mm_andnot_si128(ea, dh)), e, d));
+        _mm_store_si128(out + 4, e);
+        _mm_store_si128(out + 5, select_sse2(
+          _mm_or_si128(_mm_andnot_si128(ei, bf), _mm_andnot_si128(ec, hf)), e, f));
+        _mm_store_si128(out + 6, select_sse2(dh, e, d));
+        _mm_store_si128(out + 7, select_sse2(
+          _mm_or_si128(_mm_andnot_si128(ei, dh), _mm_andnot_si128(eg, hf)), e, h));
+        _mm_store_si128(out + 8, select_sse2(hf, e, f));
+
+        // SSE2 has no three-way interleave, so lay the output pixels out one at a time.
+        for (std::size_t lane = 0; lane < 4; ++lane)
+        {
+          std::size_t column = (x + lane) * 3;
+          for (std::size_t k = 0; k < 3; ++k)
+          {
+            row0[column + k] = results[k    ][lane];
+            row1[column + k] = results[k + 3][lane];
+            row2[column + k] = results[k + 6][lane];
+          }
+        }
+      }
+
+      scale3x_scalar(padded, width, y, x, output);
+    }
+  }
+
+  __attribute__((target("avx2")))
+  static void scale3x_avx2 (const std::uint32_t* padded, std::size_t width, std::size_t height,
+    std::uint32_t* output)
+  {
+    std::size_t stride = width + 2;
+    const __m256i ones = _mm256_set1_epi32(-1);
+
+    for (std::size_t y = 0; y < height; ++y)
+    {
+      std::uint32_t* row0 = output + (y * 3) * (width * 3);
+      std::uint32_t* row1 = row0 + (width * 3);
+      std::uint32_t* row2 = row1 + (width * 3);
+
+      std::size_t x = 0;
+      for (; x + 8 <= width; x += 8)
+      {
+        const std::uint32_t* center = padded + ((y + 1) * stride) + (x + 1);
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(center - stride - 1));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(center - stride));
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(center - stride + 1));
+        __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(center - 1));
+        __m256i e = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(center));
+        __m256i f = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(center + 1));
+        __m256i g = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(center + stride - 1));
+        __m256i h = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(center + stride));
+        __m256i i = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(center + stride + 1));
+
+        __m256i corner = _mm256_andnot_si256(
+          _mm256_or_si256(_mm256_cmpeq_epi32(b, h), _mm256_cmpeq_epi32(d, f)),
+          ones
+        );
+        __m256i db = _mm256_and_si256(corner, _mm256_cmpeq_epi32(d, b));
+        __m256i bf = _mm256_and_si256(corner, _mm256_cmpeq_epi32(b, f));
+        __m256i dh = _mm256_and_si256(corner, _mm256_cmpeq_epi32(d, h));
+        __m256i hf = _mm256_and_si256(corner, _mm256_cmpeq_epi32(h, f));
+        __m256i ea = _mm256_cmpeq_epi32(e, a), ec = _mm256_cmpeq_epi32(e, c),
+                eg = _mm256_cmpeq_epi32(e, g), ei = _mm256_cmpeq_epi32(e, i);
+
+        __m256i e0 = _mm256_blendv_epi8(e, d, db);
+        __m256i e1 = _mm256_blendv_epi8(e, b,
+          _mm256_or_si256(_mm256_andnot_si256(ec, db), _mm256_andnot_si256(ea, bf)));
+        __m256i e2 = _mm256_blendv_epi8(e, f, bf);
+        __m256i e3 = _mm256_blendv_epi8(e, d,
+          _mm256_or_si256(_mm256_andnot_si256(eg, db), _mm256_andnot_si256(ea, dh)));
+        __m256i e5 = _mm256_blendv_epi8(e, f,
+          _mm256_or_si256(_mm256_andnot_si256(ei, bf), _mm256_andnot_si256(ec, hf)));
+        __m256i e6 = _mm256_blendv_epi8(e, d, dh);
+        __m256i e7 = _mm256_blendv_epi8(e, h,
+          _mm256_or_si256(_mm256_andnot_si256(ei, dh), _mm256_andnot_si256(eg, hf)));
+        __m256i e8 = _mm256_blendv_epi8(e, f, hf);
+
+        // Unlike SSE2, AVX2 can gather lanes across a vector, so the three output pixels of each
+        // row can be interleaved without going through memory.
+        interleave3_avx2(e0, e1, e2, row0 + (x * 3));
+        interleave3_avx2(e3, e, e5, row1 + (x * 3));
+        interleave3_avx2(e6, e7, e8, row2 + (x * 3));
+      }
+
+      scale3x_scalar(padded, width, y, x, output);
+    }
+  }
+
+#endif
+
+  /** Private Functions - Scaler Dispatch *********************************************************/
+
+  static void scale_nearest (const std::uint32_t* input, std::uint32_t* output,
+    std::uint32_t factor, bool darken_last_row)
+  {
+    std::size_t width = screen_width * factor;
+    for (std::size_t y = 0; y < screen_height; ++y)
+    {
+      const std::uint32_t* source = input + (y * screen_width);
+      std::uint32_t* row = output + (y * factor) * width;
+
+      // Expand the row horizontally, then repeat it vertically.
+      #if defined(SMBOY_X86_SCALERS)
+        if (get_vector_level() >= 2)      { expand_row_avx2(source, screen_width, row, factor); }
+        else if (get_vector_level() >= 1) { expand_row_sse2(source, screen_width, row, factor); }
+        else                              { expand_row_scalar(source, screen_width, row, factor); }
+      #else
+        expand_row_scalar(source, screen_width, row, factor);
+      #endif
+
+      std::uint32_t copies = (darken_last_row == true) ? (factor - 1) : factor;
+      for (std::uint32_t i = 1; i < copies; ++i)
+      {
+        std::memcpy(row + (i * width), row, width * sizeof(std::uint32_t));
+      }
+
+      if (darken_last_row == true)
+      {
+        std::uint32_t* last = row + (factor - 1) * width;
+        #if defined(SMBOY_X86_SCALERS)
+          if (get_vector_level() >= 2)      { darken_row_avx2(row, last, width); }
+          else if (get_vector_level() >= 1) { darken_row_sse2(row, last, width); }
+          else                              { darken_row_scalar(row, last, width); }
+        #else
+          darken_row_scalar(row, last, width);
+        #endif
+      }
+    }
+  }
+
+  static void scale2x (const std::uint32_t* padded, std::size_t width, std::size_t height,
+    std::uint32_t* output)
+  {
+#if defined(SMBOY_X86_SCALERS)
+    if (get_vector_level() >= 2) { scale2x_avx2(padded, width, height, output); return; }
+    if (get_vector_level() >= 1) { scale2x_sse2(padded, width, height, output); return; }
+#endif
+
+    for (std::size_t y = 0; y < height; ++y)
+    {
+      scale2x_scalar(padded, width, y, 0, output);
+    }
+  }
+
+  static void scale3x (const std::uint32_t* padded, std::size_t width, std::size_t height,
+    std::uint32_t* output)
+  {
+#if defined(SMBOY_X86_SCALERS)
+    if (get_vector_level() >= 2) { scale3x_avx2(padded, width, height, output); return; }
+    if (get_vector_level() >= 1) { scale3x_sse2(padded, width, height, output); return; }
+#endif
+
+    for (std::size_t y = 0; y < height; ++y)
+    {
+      scale3x_scalar(padded, width, y, 0, output);
+    }
+  }
+
+  /** Constructor *********************************************************************************/
+
+  frame_scaler::frame_scaler ()
+  {
+    set_filter(scale_filter::sf_nearest, 1);
+  }
+
+  /** Public Methods ******************************************************************************/
+
+  bool frame_scaler::set_filter (scale_filter filter, std::uint32_t factor)
+  {
+    switch (filter)
+    {
+      case scale_filter::sf_scale2x: factor = 2; break;
+      case scale_filter::sf_scale3x: factor = 3; break;
+      case scale_filter::sf_scale4x: factor = 4; break;
+      default: break;
+    }
+
+    if (factor < 1 || factor > 8 || (filter == scale_filter::sf_crt && factor < 2)) {
+      std::cerr <<  "[frame_scaler] "
+                <<  "Invalid scale factor " << factor << " for the "
+                <<  get_filter_name(filter) << " filter." << std::endl;
+      return false;
+    }
+
+    m_filter = filter;
+    m_factor = factor;
+    m_output.assign(get_output_width() * get_output_height(), 0);
+
+    // Note which implementation the filter will use on this host. Every filter has a version for
+    // each level.
+    static constexpr const char* level_names[] = { "scalar", "sse2", "avx2" };
+    m_implementation = level_names[get_vector_level()];
+
+    reset_timing();
+    return true;
+  }
+
+  const std::uint32_t* frame_scaler::scale (const std::uint32_t* pixels)
+  {
+    auto start = std::chrono::steady_clock::now();
+
+    switch (m_filter)
+    {
+      case scale_filter::sf_scale2x:
+        pad_frame(pixels, screen_width, screen_height, m_padded);
+        scale2x(m_padded.data(), screen_width, screen_height, m_output.data());
+        break;
+
+      case scale_filter::sf_scale3x:
+        pad_frame(pixels, screen_width, screen_height, m_padded);
+        scale3x(m_padded.data(), screen_width, screen_height, m_output.data());
+        break;
+
+      case scale_filter::sf_scale4x:
+        m_intermediate.resize(screen_buffer_size * 4);
+        pad_frame(pixels, screen_width, screen_height, m_padded);
+        scale2x(m_padded.data(), screen_width, screen_height, m_intermediate.data());
+        pad_frame(m_intermediate.data(), screen_width * 2, screen_height * 2, m_padded);
+        scale2x(m_padded.data(), screen_width * 2, screen_height * 2, m_output.data());
+        break;
+
+      case scale_filter::sf_crt:
+        scale_nearest(pixels, m_output.data(), m_factor, true);
+        break;
+
+      default:
+        scale_nearest(pixels, m_output.data(), m_factor, false);
+        break;
+    }
+
+    m_last_time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - start
+    ).count();
+    m_total_time += m_last_time;
+    m_scaled_count++;
+
+    return m_output.data();
+  }
+
+  void frame_scaler::reset_timing ()
+  {
+    m_scaled_count = 0;
+    m_total_time = 0;
+    m_last_time = 0;
+  }
+
+  std::uint64_t frame_scaler::get_average_time () const
+  {
+    return (m_scaled_count > 0) ? (m_total_time / m_scaled_count) : 0;
+  }
+
+  const char* frame_scaler::get_filter_name (scale_filter filter)
+  {
+    switch (filter)
+    {
+      case scale_filter::sf_nearest:  return "nearest";
+      case scale_filter::sf_scale2x:  return "scale2x";
+      case scale_filter::sf_scale3x:  return "scale3x";
+      case scale_filter::sf_scale4x:  return "scale4x";
+      case scale_filter::sf_crt:      return "crt";
+      default:                        return "unknown";
+    }
+  }
+
+}
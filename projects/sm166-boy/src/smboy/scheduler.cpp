@@ -0,0 +1,95 @@
+/** @file smboy/scheduler.cpp */
+
+#include <smboy/scheduler.hpp>
+
+namespace smboy
+{
+
+  /** Private Constants ***************************************************************************/
+
+  // The cycle of anything which is not going to happen.
+  static constexpr std::uint64_t never = std::numeric_limits<std::uint64_t>::max();
+
+  /** Cycle Awaiter *******************************************************************************/
+
+  void cycle_awaiter::await_suspend (std::coroutine_handle<>) const noexcept
+  {
+    owner->reschedule(slot, cycle);
+  }
+
+  /** Public Methods ******************************************************************************/
+
+  void scheduler::initialize ()
+  {
+    for (slot_state& state : m_slots)
+    {
+      state.task = device_task {};
+      state.cycle = never;
+      state.held = false;
+    }
+
+    m_next_cycle = never;
+    m_cycle = 0;
+  }
+
+  void scheduler::start (device_slot slot, device_task task)
+  {
+    slot_state& state = m_slots[slot];
+    state.task = std::move(task);
+    state.cycle = never;
+
+    // The coroutine schedules itself on reaching its first wait.
+    if (state.task.is_valid() == true)
+    {
+      state.task.resume();
+    }
+  }
+
+  void scheduler::reschedule (device_slot slot, std::uint64_t cycle)
+  {
+    slot_state& state = m_slots[slot];
+    if (state.task.is_valid() == false) { return; }
+
+    state.cycle = cycle;
+    update_next_cycle();
+  }
+
+  void scheduler::set_held (device_slot slot, bool held)
+  {
+    m_slots[slot].held = held;
+    update_next_cycle();
+  }
+
+  /** Private Methods *****************************************************************************/
+
+  void scheduler::run (std::uint64_t cycle_count)
+  {
+    m_cycle = cycle_count;
+
+    // Resume each coroutine which is due, in slot order. Each one waits again before returning
+    // here, which reschedules it.
+    for (slot_state& state : m_slots)
+    {
+      if (state.held == false && state.cycle <= cycle_count)
+      {
+        state.cycle = never;
+        state.task.resume();
+      }
+    }
+
+    update_next_cycle();
+  }
+
+  void scheduler::update_next_cycle ()
+  {
+    m_next_cycle = never;
+    for (const slot_state& state : m_slots)
+    {
+      if (state.held == false)
+      {
+        m_next_cycle = std::min(m_next_cycle, state.cycle);
+      }
+    }
+  }
+
+}
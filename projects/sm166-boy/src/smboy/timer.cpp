@@ -6,63 +6,224 @@
 namespace smboy
 {
 
+  /** Private Constants ***************************************************************************/
+
+  // The cycle of anything which is not going to happen.
+  static constexpr std::uint64_t never = std::numeric_limits<std::uint64_t>::max();
+
+  // The audio context's frame sequencer is clocked whenever bit 11 of the divider falls from set to
+  // clear - once every 4096 tick cycles.
+  static constexpr std::uint64_t div_apu_period = 4096;
+
+  /** Public Methods ******************************************************************************/
+
   void timer::initialize (emulator* _emulator)
   {
     m_emulator = _emulator;
-    m_divider = 0x0000;
     m_counter = 0x00;
     m_modulo = 0x00;
     m_control.state = 0xF8;
+
+    // The processor's tick cycle count starts from zero, alongside the divider.
+    m_divider_reset_cycle = 0;
+    m_counter_cycle = 0;
+    m_next_div_apu_cycle = div_apu_period;
+    schedule_events();
   }
 
-  void timer::tick ()
+  device_task timer::run (scheduler& sched)
   {
-    
-    // Don't bother ticking if the timer has no parent emulator.
-    if (m_emulator == nullptr) { return; }
-    
-    // Get a handle to the emulator's processor. Don't bother ticking if the stop flag is set.
-    sm::processor& cpu = m_emulator->get_processor();
-    if (cpu.check_flag(sm::processor_flag_type::stop) == true)
+    while (true)
     {
-      return;
+      co_await sched.wait_until(device_slot::ds_timer, m_next_event_cycle);
+
+      // Of the clocks, the audio context's frame sequencer is the only one driven from here.
+      std::uint64_t cycle_count = sched.get_cycle();
+      if (handle_events(cycle_count) == true)
+      {
+        m_emulator->get_audio().tick_frame_sequencer(cycle_count);
+      }
     }
-    
-    // Increment the timer's counter. Keep a copy of the old divider before doing so.
-    std::uint16_t old_divider = (m_divider++);
-    
-    // Check to see if the audio context needs to be updated.
-    m_div_apu = (sm_getbit(old_divider, 11) != 0) && (sm_getbit(m_divider, 11) == 0);
-    
-    // Don't bother updating the timer's counter if it's currently disabled.
-    if (m_control.enabled == 0) { return; }
-    
-    // The timer's clock speed setting dictates which bit of the divider we check to determine
-    // whether or not we update the timer's counter.
-    std::uint8_t check_bit = 0;
+  }
+
+  std::uint8_t timer::read_reg_div () const
+  {
+    return (get_full_divider() >> 8) & 0xFF;
+  }
+
+  std::uint8_t timer::read_reg_tima ()
+  {
+    sync_counter(get_cycle_count());
+    return m_counter;
+  }
+
+  void timer::write_reg_div ()
+  {
+
+    // The counter only counts on the divider's falling edges, and resetting the divider is not one,
+    // so it just needs bringing up to date before the edges move.
+    std::uint64_t cycle_count = get_cycle_count();
+    sync_counter(cycle_count);
+
+    m_divider_reset_cycle = cycle_count;
+    m_next_div_apu_cycle = cycle_count + div_apu_period;
+    schedule_events();
+
+  }
+
+  void timer::write_reg_tima (std::uint8_t value)
+  {
+    sync_counter(get_cycle_count());
+    m_counter = value;
+    schedule_events();
+  }
+
+  void timer::write_reg_tma (std::uint8_t value)
+  {
+    sync_counter(get_cycle_count());
+    m_modulo = value;
+    schedule_events();
+  }
+
+  void timer::write_reg_tac (std::uint8_t value)
+  {
+
+    // Count up to now under the old setting. Changing the setting does not count as an edge.
+    sync_counter(get_cycle_count());
+    m_control.state = value;
+    schedule_events();
+
+  }
+
+  std::uint16_t timer::get_full_divider () const
+  {
+    return static_cast<std::uint16_t>((get_cycle_count() - m_divider_reset_cycle) & 0xFFFF);
+  }
+
+  void timer::save_state (timer& snapshot) const
+  {
+    snapshot.load_state(*this);
+  }
+
+  void timer::load_state (const timer& snapshot)
+  {
+    m_counter = snapshot.m_counter;
+    m_modulo = snapshot.m_modulo;
+    m_control = snapshot.m_control;
+    m_divider_reset_cycle = snapshot.m_divider_reset_cycle;
+    m_counter_cycle = snapshot.m_counter_cycle;
+    m_next_overflow_cycle = snapshot.m_next_overflow_cycle;
+    m_next_div_apu_cycle = snapshot.m_next_div_apu_cycle;
+    m_next_event_cycle = snapshot.m_next_event_cycle;
+    if (m_emulator != nullptr)
+    {
+      m_emulator->get_scheduler().reschedule(device_slot::ds_timer, m_next_event_cycle);
+    }
+  }
+
+  /** Private Methods *****************************************************************************/
+
+  bool timer::handle_events (std::uint64_t cycle_count)
+  {
+    bool div_apu = false;
+    if (cycle_count >= m_next_div_apu_cycle)
+    {
+      div_apu = true;
+      m_next_div_apu_cycle += div_apu_period;
+    }
+
+    // Bringing the counter up to date sees it overflow, and requests the interrupt.
+    if (cycle_count >= m_next_overflow_cycle)
+    {
+      sync_counter(cycle_count);
+    }
+
+    schedule_events();
+    return div_apu;
+  }
+
+  std::uint64_t timer::get_cycle_count () const
+  {
+    if (m_emulator == nullptr) { return 0; }
+    return m_emulator->get_processor().get_tick_cycles();
+  }
+
+  std::uint64_t timer::get_counter_period () const
+  {
+
+    // The timer's clock speed setting dictates which bit of the divider is checked for falling edges
+    // - bits 9, 3, 5 and 7 respectively. A bit falls once every two to the power of one more than
+    // its index cycles.
     switch (m_control.clock_speed)
     {
-      case timer_clock_speed::tcs_slowest:  check_bit = 9; break;
-      case timer_clock_speed::tcs_fastest:  check_bit = 3; break;
-      case timer_clock_speed::tcs_fast:     check_bit = 5; break;
-      case timer_clock_speed::tcs_slow:     check_bit = 7; break;
-      default:                              check_bit = 9; break;
+      case timer_clock_speed::tcs_slowest:  return 1024;
+      case timer_clock_speed::tcs_fastest:  return 16;
+      case timer_clock_speed::tcs_fast:     return 64;
+      case timer_clock_speed::tcs_slow:     return 256;
+      default:                              return 1024;
     }
-    
-    // The timer's counter needs to be updated if the target bit in the divider was set in the
-    // previous tick, but clear in the current tick.
-    bool timer_update = (sm_getbit(old_divider, check_bit) != 0) &&
-      (sm_getbit(m_divider, check_bit) == 0);
-    if (timer_update == true && ++m_counter == 0xFF)
+
+  }
+
+  void timer::sync_counter (std::uint64_t cycle_count)
+  {
+    if (cycle_count <= m_counter_cycle) { return; }
+
+    std::uint64_t from_cycle = m_counter_cycle;
+    m_counter_cycle = cycle_count;
+
+    // Don't bother updating the timer's counter if it's currently disabled.
+    if (m_control.enabled == 0) { return; }
+
+    // Count the falling edges of the checked divider bit since the counter was last brought up to
+    // date.
+    std::uint64_t period = get_counter_period();
+    std::uint64_t edges = (cycle_count - m_divider_reset_cycle) / period -
+      (from_cycle - m_divider_reset_cycle) / period;
+
+    // The counter overflows when an increment brings it to 0xFF. It is then reset to the modulo
+    // value, and a CPU interrupt is requested.
+    while (edges > 0)
     {
-      
-      // If incrementing the counter causes it to overflow, then reset it to the modulo value and
-      // request a CPU interrupt.
+      std::uint64_t to_overflow = static_cast<std::uint8_t>(0xFF - m_counter);
+      if (to_overflow == 0) { to_overflow = 0x100; }
+
+      if (edges < to_overflow)
+      {
+        m_counter = static_cast<std::uint8_t>(m_counter + edges);
+        break;
+      }
+
+      edges -= to_overflow;
       m_counter = m_modulo;
-      cpu.request_interrupt(interrupt_type::int_timer);
-      
+      m_emulator->get_processor().request_interrupt(interrupt_type::int_timer);
+    }
+  }
+
+  void timer::schedule_events ()
+  {
+    m_next_overflow_cycle = never;
+    if (m_control.enabled != 0 && m_emulator != nullptr)
+    {
+
+      // The counter overflows on the falling edge which brings it to 0xFF. Find the first edge after
+      // the counter was last brought up to date, then count on from there.
+      std::uint64_t period = get_counter_period();
+      std::uint64_t to_overflow = static_cast<std::uint8_t>(0xFF - m_counter);
+      if (to_overflow == 0) { to_overflow = 0x100; }
+
+      std::uint64_t first_edge = m_divider_reset_cycle +
+        ((m_counter_cycle - m_divider_reset_cycle) / period + 1) * period;
+      m_next_overflow_cycle = first_edge + (to_overflow - 1) * period;
+
+    }
+
+    // Move the coroutine's wait, as a register write may have moved the next event.
+    m_next_event_cycle = std::min(m_next_overflow_cycle, m_next_div_apu_cycle);
+    if (m_emulator != nullptr)
+    {
+      m_emulator->get_scheduler().reschedule(device_slot::ds_timer, m_next_event_cycle);
     }
-    
   }
 
 }
@@ -112,6 +112,23 @@ namespace sm
      */
     bool step (memory& mem);
 
+    /**
+     * @brief Copies the SM166 CPU's registers, interrupt state and tick cycle count into another
+     *        processor, so that they can be restored later with @a `load_state`. The cycle function
+     *        is not copied.
+     *
+     * @param snapshot  The processor to copy the state into.
+     */
+    void save_state (processor& snapshot) const;
+
+    /**
+     * @brief Restores the SM166 CPU's registers, interrupt state and tick cycle count from a
+     *        processor they were earlier copied into with @a `save_state`.
+     *
+     * @param snapshot  The processor to copy the state from.
+     */
+    void load_state (const processor& snapshot);
+
   public:
 
     /**
@@ -181,6 +198,36 @@ namespace sm
       return m_stack_pointer;
     }
 
+    /**
+     * @brief Retrieves the number of clock cycles which have elapsed since the SM166 CPU was
+     *        initialized or reset.
+     * 
+     * @return  The number of elapsed tick cycles. 
+     */
+    inline std::uint64_t get_tick_cycles () const
+    {
+      return m_tick_cycles;
+    }
+
+    /**
+     * @brief Retrieves the number of times the interrupt with the given ID has been requested, or
+     *        serviced, since the SM166 CPU was initialized. These counts are not part of the CPU's
+     *        saved state, so they keep counting across restored states.
+     *
+     * @param id  The ID of the interrupt (0 - 7).
+     *
+     * @return  The number of requests, or services, of that interrupt.
+     */
+    inline std::uint64_t get_requested_interrupt_count (std::uint8_t id) const
+    {
+      return m_requested_interrupt_counts[id & 0b111];
+    }
+
+    inline std::uint64_t get_serviced_interrupt_count (std::uint8_t id) const
+    {
+      return m_serviced_interrupt_counts[id & 0b111];
+    }
+
     /**
      * @brief Retrieves the interrupt request register (`IR`), which indicates which CPU interrupts
      *        are currently requested to be handled.
@@ -554,6 +601,12 @@ namespace sm
      */
     std::uint64_t m_tick_cycles = 0;
 
+    /**
+     * @brief Count how many times each interrupt has been requested, and serviced.
+     */
+    std::uint64_t m_requested_interrupt_counts[8] = { 0 };
+    std::uint64_t m_serviced_interrupt_counts[8] = { 0 };
+
     /**
      * @brief This function is called every time clock cycle elapses (which happens, among other
      *        events, when the SM166 CPU reads and writes data while executing instructions), and
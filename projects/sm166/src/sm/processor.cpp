@@ -15,6 +15,9 @@ namespace sm
     m_program_counter = 0x200;
     m_stack_pointer = 0xFFFF;
     m_tick_cycles = 0;
+
+    std::memset(m_requested_interrupt_counts, 0, sizeof(m_requested_interrupt_counts));
+    std::memset(m_serviced_interrupt_counts, 0, sizeof(m_serviced_interrupt_counts));
   }
 
   void processor::cycle (std::uint32_t cycle_count)
@@ -31,6 +34,22 @@ namespace sm
   void processor::request_interrupt (std::uint8_t id)
   {
     sm_setbit(m_interrupts_requested, (id & 0b111), true);
+    m_requested_interrupt_counts[id & 0b111]++;
+  }
+
+  void processor::save_state (processor& snapshot) const
+  {
+    snapshot.load_state(*this);
+  }
+
+  void processor::load_state (const processor& snapshot)
+  {
+    std::memcpy(m_registers, snapshot.m_registers, sizeof(m_registers));
+    m_program_counter = snapshot.m_program_counter;
+    m_stack_pointer = snapshot.m_stack_pointer;
+    m_interrupts_enabled = snapshot.m_interrupts_enabled;
+    m_interrupts_requested = snapshot.m_interrupts_requested;
+    m_tick_cycles = snapshot.m_tick_cycles;
   }
 
   bool processor::step (memory& mem)
@@ -1447,6 +1466,7 @@ namespace sm
       sm_setbit(m_interrupts_requested, id, false);
       set_flag(processor_flag_type::halt, false);
       set_flag(processor_flag_type::interrupt_disable, true);
+      m_serviced_interrupt_counts[id]++;
 
       return true;
     }
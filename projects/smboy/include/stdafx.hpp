@@ -8,5 +8,12 @@
 #include <SFML/Window.hpp>
 #include <SFML/System.hpp>
 #include <smboy/emulator.hpp>
+#include <smboy/audio_ring.hpp>
+#include <smboy/audio_sink.hpp>
+#include <smboy/batch_runner.hpp>
+#include <smboy/benchmark.hpp>
+#include <smboy/pacer.hpp>
+#include <smboy/resampler.hpp>
+#include <smboy/scaler.hpp>
 
 #endif
@@ -10,13 +10,6 @@ namespace smboy
 
   bool arguments::parse (int argc, char** argv)
   {
-    if (argc > 20) {
-      std::cerr <<  "[arguments::parse] "
-                <<  "Too many arguments (" << argc - 1 << ") passed in."
-                <<  std::endl;
-      return false;
-    }
-    
     // Iterate over the command-line arguments, starting at index 1.
     for (int index = 1; index < argc; ++index) {
 
@@ -8,66 +8,551 @@ class AudioStream : public sf::SoundStream
 public:
   static constexpr std::uint32_t SAMPLE_RATE = 44100;
 
+  // The ring holds about a third of a second of audio. The device is fed in chunks of about 12 ms.
+  static constexpr std::size_t RING_FRAMES = 16384;
+  static constexpr std::size_t CHUNK_FRAMES = 512;
+
 public:
-  AudioStream ()
+  AudioStream () :
+    m_ring { RING_FRAMES }
   {
     initialize(2, SAMPLE_RATE);
   }
 
 public:
-  void pushSample (float left, float right)
+  void pushFrames (const std::int16_t* samples, std::size_t frameCount)
+  {
+    m_ring.push(samples, frameCount);
+  }
+
+  const smboy::audio_ring& getRing () const
+  {
+    return m_ring;
+  }
+
+protected:
+  virtual bool onGetData (sf::SoundStream::Chunk& data) override
   {
-    if (left == 0 && right == 0)
+
+    // Never wait for the emulation thread. If the ring runs dry, pad the chunk out with silence,
+    // and let the ring count the underrun.
+    std::size_t frames = m_ring.pop(m_chunk, CHUNK_FRAMES);
+    std::fill(m_chunk + frames * 2, m_chunk + CHUNK_FRAMES * 2, 0);
+
+    data.samples = m_chunk;
+    data.sampleCount = CHUNK_FRAMES * 2;
+
+    return true;
+  }
+
+  virtual void onSeek (sf::Time) override
+  {
+
+  }
+
+private:
+  smboy::audio_ring m_ring;
+  std::int16_t m_chunk[CHUNK_FRAMES * 2];
+
+};
+
+bool parse_pacing (bool headless, smboy::pacing_mode& mode, double& speed)
+{
+
+  // Headless runs are unthrottled by default; windowed runs are paced in realtime.
+  mode = (headless == true) ? smboy::pacing_mode::pm_unthrottled : smboy::pacing_mode::pm_realtime;
+  speed = 1.0;
+
+  auto pacing = smboy::arguments::get("pacing");
+  if (pacing == "unthrottled")          { mode = smboy::pacing_mode::pm_unthrottled; }
+  else if (pacing == "realtime")        { mode = smboy::pacing_mode::pm_realtime; }
+  else if (pacing == "audio")           { mode = smboy::pacing_mode::pm_audio; }
+  else if (pacing.empty() == false)
+  {
+    std::cerr << "[smboy] Unknown pacing mode '" << pacing << "'. "
+              << "Expected 'realtime', 'unthrottled' or 'audio'." << std::endl;
+    return false;
+  }
+
+  // A speed multiplier, such as `--speed 2`, implies realtime pacing at that multiple. A speed of
+  // zero means unthrottled.
+  auto speed_string = smboy::arguments::get("speed");
+  if (speed_string.empty() == false)
+  {
+    try
     {
-      return;
+      speed = std::stod(speed_string);
+    }
+    catch (const std::exception&)
+    {
+      std::cerr << "[smboy] Invalid speed multiplier '" << speed_string << "'." << std::endl;
+      return false;
     }
 
-    if (m_sampleCount + 2 < SAMPLE_RATE)
+    if (speed <= 0.0)
     {
-      if (left  < -1.0f) { left  = -1.0f; } else if (left  > 1.0f) { left  = 1.0f; }
-      if (right < -1.0f) { right = -1.0f; } else if (right > 1.0f) { right = 1.0f; }
+      mode = smboy::pacing_mode::pm_unthrottled;
+      speed = 1.0;
+    }
+    else if (pacing.empty() == true)
+    {
+      mode = smboy::pacing_mode::pm_realtime;
+    }
+  }
+
+  return true;
+
+}
+
+bool parse_frame_skip (std::uint32_t& skip, bool& automatic)
+{
+
+  // `--frame-skip N` skips N frames after each drawn frame; `--frame-skip all` draws no frames at
+  // all; `--frame-skip auto` skips frames only while the emulator is behind schedule.
+  skip = 0;
+  automatic = false;
+
+  auto frame_skip = smboy::arguments::get("frame-skip");
+  if (frame_skip.empty() == true) { return true; }
+  else if (frame_skip == "auto")  { automatic = true; return true; }
+  else if (frame_skip == "all")   { skip = smboy::frame_skip_all; return true; }
 
-      m_samples[m_sampleCount++] = (std::uint16_t) (left  * 32767);
-      m_samples[m_sampleCount++] = (std::uint16_t) (right * 32767);
+  try
+  {
+    skip = static_cast<std::uint32_t>(std::stoul(frame_skip));
+  }
+  catch (const std::exception&)
+  {
+    std::cerr << "[smboy] Invalid frame skip '" << frame_skip << "'. "
+              << "Expected a number, 'auto' or 'all'." << std::endl;
+    return false;
+  }
+
+  return true;
+
+}
+
+bool parse_run_ahead (std::uint32_t& frames)
+{
+
+  // `--run-ahead N` shows the frame N frames ahead of the emulation, run speculatively with the
+  // current input, then rolled back. This hides N frames of the program's own input latency.
+  frames = 0;
+
+  auto run_ahead = smboy::arguments::get("run-ahead");
+  if (run_ahead.empty() == true) { return true; }
+
+  try
+  {
+    frames = static_cast<std::uint32_t>(std::stoul(run_ahead));
+  }
+  catch (const std::exception&)
+  {
+    std::cerr << "[smboy] Invalid run-ahead frame count '" << run_ahead << "'." << std::endl;
+    return false;
+  }
+
+  return true;
+
+}
+
+bool parse_frame_format (smboy::frame_format& format)
+{
+
+  // `--frame-format rgba|rgb565|indexed` picks the pixel format in which frames are drawn. The
+  // compact formats are converted into RGBA only when they are shown or captured.
+  format = smboy::frame_format::ff_rgba8888;
+
+  auto format_string = smboy::arguments::get("frame-format");
+  if (format_string.empty() == true || format_string == "rgba") { return true; }
+  else if (format_string == "rgb565")   { format = smboy::frame_format::ff_rgb565; }
+  else if (format_string == "indexed")  { format = smboy::frame_format::ff_indexed8; }
+  else
+  {
+    std::cerr << "[smboy] Unknown frame format '" << format_string << "'. "
+              << "Expected 'rgba', 'rgb565' or 'indexed'." << std::endl;
+    return false;
+  }
+
+  return true;
+
+}
+
+bool parse_scaler (smboy::frame_scaler& scaler, bool& enabled)
+{
+
+  // `--scaler nearest|scale2x|scale3x|scale4x|crt` scales frames up on the CPU before they are
+  // uploaded, instead of leaving the scaling to the graphics hardware. `--scale N` sets the scale
+  // factor of the nearest and CRT filters; it defaults to the window's scale of 4.
+  enabled = false;
+
+  auto filter_string = smboy::arguments::get("scaler");
+  if (filter_string.empty() == true) { return true; }
+
+  smboy::scale_filter filter;
+  if (filter_string == "nearest")       { filter = smboy::scale_filter::sf_nearest; }
+  else if (filter_string == "scale2x")  { filter = smboy::scale_filter::sf_scale2x; }
+  else if (filter_string == "scale3x")  { filter = smboy::scale_filter::sf_scale3x; }
+  else if (filter_string == "scale4x")  { filter = smboy::scale_filter::sf_scale4x; }
+  else if (filter_string == "crt")      { filter = smboy::scale_filter::sf_crt; }
+  else
+  {
+    std::cerr << "[smboy] Unknown scaler '" << filter_string << "'. "
+              << "Expected 'nearest', 'scale2x', 'scale3x', 'scale4x' or 'crt'." << std::endl;
+    return false;
+  }
+
+  std::uint32_t factor = 4;
+  auto factor_string = smboy::arguments::get("scale");
+  if (factor_string.empty() == false)
+  {
+    try
+    {
+      factor = static_cast<std::uint32_t>(std::stoul(factor_string));
+    }
+    catch (const std::exception&)
+    {
+      std::cerr << "[smboy] Invalid scale factor '" << factor_string << "'." << std::endl;
+      return false;
     }
   }
 
-protected:
-  virtual bool onGetData (sf::SoundStream::Chunk& data) override
+  enabled = scaler.set_filter(filter, factor);
+  return enabled;
+
+}
+
+bool parse_capture (smboy::frame_sink& sink)
+{
+
+  // `--capture PATH` streams drawn frames to disk. The format is given by `--capture-format`, or
+  // else guessed from the path: `.y4m` for a YUV4MPEG2 video, `.rgba` or `.raw` for raw pixels,
+  // and anything else for a directory of PNG files. `--capture-hashes PATH` writes the CRC-32 of
+  // each captured frame, with or without images. `--capture-every N` captures every Nth frame.
+  // Frames are dropped if the disk can't keep up, unless hashes are being written, or
+  // `--capture-lossless` is given, in which case the emulation waits for the disk instead.
+  auto path = smboy::arguments::get("capture");
+  auto hash_path = smboy::arguments::get("capture-hashes");
+  if (path.empty() == true && hash_path.empty() == true) { return true; }
+
+  auto format_string = smboy::arguments::get("capture-format");
+  if (format_string.empty() == true)
   {
-    std::lock_guard<std::mutex> lock { m_mutex };
-    std::this_thread::sleep_for(std::chrono::milliseconds(16));
-    if (m_sampleCount == 0)
+    auto extension = fs::path { path }.extension();
+    if (path.empty() == true)         { format_string = "none"; }
+    else if (extension == ".y4m")     { format_string = "y4m"; }
+    else if (extension == ".rgba" ||
+             extension == ".raw")     { format_string = "raw"; }
+    else                              { format_string = "png"; }
+  }
+
+  smboy::frame_capture_format format;
+  if (format_string == "none")        { format = smboy::frame_capture_format::fcf_none; }
+  else if (format_string == "raw")    { format = smboy::frame_capture_format::fcf_raw; }
+  else if (format_string == "y4m")    { format = smboy::frame_capture_format::fcf_y4m; }
+  else if (format_string == "png")    { format = smboy::frame_capture_format::fcf_png; }
+  else
+  {
+    std::cerr << "[smboy] Unknown capture format '" << format_string << "'. "
+              << "Expected 'raw', 'y4m', 'png' or 'none'." << std::endl;
+    return false;
+  }
+
+  std::uint32_t interval = 1;
+  auto interval_string = smboy::arguments::get("capture-every");
+  if (interval_string.empty() == false)
+  {
+    try
+    {
+      interval = static_cast<std::uint32_t>(std::stoul(interval_string));
+    }
+    catch (const std::exception&)
     {
+      std::cerr << "[smboy] Invalid capture interval '" << interval_string << "'." << std::endl;
       return false;
     }
+  }
 
-    data.samples = m_samples;
-    data.sampleCount = m_sampleCount;
-    m_sampleCount = 0;
+  bool lossless = (hash_path.empty() == false || smboy::arguments::has("capture-lossless"));
+  return sink.open(path, format, interval, hash_path, lossless);
 
-    return true;
+}
+
+bool parse_audio_capture (smboy::audio_sink& sink, std::uint32_t sample_rate)
+{
+
+  // `--audio-capture PATH` streams the audio output to disk, as it would be heard. The format is
+  // given by `--audio-capture-format`, or else guessed from the path: `.wav` for a WAV file, and
+  // anything else for raw, interleaved, 16-bit stereo PCM.
+  auto path = smboy::arguments::get("audio-capture");
+  if (path.empty() == true) { return true; }
+
+  auto format_string = smboy::arguments::get("audio-capture-format");
+  if (format_string.empty() == true)
+  {
+    format_string = (fs::path { path }.extension() == ".wav") ? "wav" : "raw";
   }
 
-  virtual void onSeek (sf::Time) override
+  smboy::audio_capture_format format;
+  if (format_string == "wav")         { format = smboy::audio_capture_format::acf_wav; }
+  else if (format_string == "raw")    { format = smboy::audio_capture_format::acf_raw; }
+  else
   {
+    std::cerr << "[smboy] Unknown audio capture format '" << format_string << "'. "
+              << "Expected 'wav' or 'raw'." << std::endl;
+    return false;
+  }
+
+  return sink.open(path, format, sample_rate);
+
+}
 
+bool parse_realtime_clock (smboy::realtime& clock)
+{
+
+  // `--rtc-epoch SECONDS` starts the realtime clock at a fixed time, in seconds since the Unix
+  // epoch, for reproducible runs. `--rtc-host-sync` makes the clock follow the host's clock,
+  // instead of the emulated cycle count.
+  auto epoch_string = smboy::arguments::get("rtc-epoch");
+  if (epoch_string.empty() == false)
+  {
+    try
+    {
+      clock.set_epoch(std::stoll(epoch_string));
+    }
+    catch (const std::exception&)
+    {
+      std::cerr << "[smboy] Invalid realtime clock epoch '" << epoch_string << "'." << std::endl;
+      return false;
+    }
   }
 
-private:
-  std::mutex m_mutex;
-  std::size_t m_sampleCount = 0;
-  std::int16_t m_samples[SAMPLE_RATE];
+  clock.set_host_sync(smboy::arguments::has("rtc-host-sync"));
+  return true;
 
-};
+}
 
-void run_emulation_thread (smboy::emulator& emu)
+bool parse_input (smboy::input_queue& input, bool& replaying)
 {
+
+  // `--input-log PATH` logs every joypad input, stamped with the cycle on which it took effect.
+  // `--input-replay PATH` replays such a log exactly, ignoring the keyboard.
+  auto log_path = smboy::arguments::get("input-log");
+  if (log_path.empty() == false && input.open_log(log_path) == false)
+  {
+    return false;
+  }
+
+  auto replay_path = smboy::arguments::get("input-replay");
+  replaying = (replay_path.empty() == false);
+  if (replaying == true && input.load_replay(replay_path) == false)
+  {
+    return false;
+  }
+
+  return true;
+
+}
+
+bool parse_benchmark (bool& enabled, smboy::benchmark_options& options, std::string& output)
+{
+
+  // `--benchmark N` runs headless for N frames, 600 by default, or for N host seconds if given as
+  // `Ns`, then writes its measurements out as JSON. `--benchmark-warmup N` runs N unmeasured frames
+  // first, `--benchmark-repeat N` measures N runs back to back, `--benchmark-core N` pins the
+  // emulation to core N, and `--benchmark-output PATH` writes the JSON to a file instead of the
+  // standard output.
+  enabled = smboy::arguments::has("benchmark");
+  if (enabled == false) { return true; }
+
+  auto length_string = smboy::arguments::get("benchmark");
+  auto warmup_string = smboy::arguments::get("benchmark-warmup");
+  auto repeat_string = smboy::arguments::get("benchmark-repeat");
+  auto core_string = smboy::arguments::get("benchmark-core");
+  output = smboy::arguments::get("benchmark-output");
+
+  try
+  {
+    if (length_string != "true")
+    {
+      if (length_string.ends_with('s') == true)
+      {
+        options.seconds = std::stod(length_string.substr(0, length_string.size() - 1));
+      }
+      else
+      {
+        options.frames = std::stoull(length_string);
+      }
+    }
+
+    if (warmup_string.empty() == false) { options.warmup_frames = std::stoull(warmup_string); }
+    if (repeat_string.empty() == false) { options.repeat = std::stoul(repeat_string); }
+    if (core_string.empty() == false)   { options.core = std::stoi(core_string); }
+  }
+  catch (const std::exception&)
+  {
+    std::cerr << "[smboy] Invalid benchmark options. Expected '--benchmark N' or "
+              << "'--benchmark Ns', and numbers for the other '--benchmark-*' options." << std::endl;
+    return false;
+  }
+
+  if ((options.frames == 0 && options.seconds <= 0.0) || options.repeat == 0)
+  {
+    std::cerr << "[smboy] A benchmark needs at least one run of at least one frame." << std::endl;
+    return false;
+  }
+
+  return true;
+
+}
+
+int run_batch ()
+{
+
+  // `--batch LIST` runs each of the program files listed in the text file LIST, one per line, in
+  // an emulator instance of its own. A program file may be followed by a tab and an input log to
+  // replay. The jobs run across `--batch-threads N` worker threads (one per host core by default).
+  // Each job stops after `--batch-frames N` frames, 600 by default, or after `--batch-cycles N`
+  // tick cycles; a limit of zero means no limit. `--batch-hashes DIR` writes the
+  // CRC-32 of each job's frames into DIR. The results are written out as JSON, to the standard
+  // output or to `--batch-output PATH`.
+  auto list_path = smboy::arguments::get("batch");
+  std::ifstream list { list_path };
+  if (list.is_open() == false)
+  {
+    std::cerr << "[smboy] Could not open batch list '" << list_path << "'." << std::endl;
+    return 1;
+  }
+
+  smboy::batch_job prototype;
+  prototype.max_frames = 600;
+  std::uint32_t thread_count = 0;
+  try
+  {
+    auto frames_string = smboy::arguments::get("batch-frames");
+    auto cycles_string = smboy::arguments::get("batch-cycles");
+    auto threads_string = smboy::arguments::get("batch-threads");
+    auto epoch_string = smboy::arguments::get("rtc-epoch");
+    if (frames_string.empty() == false)   { prototype.max_frames = std::stoull(frames_string); }
+    if (cycles_string.empty() == false)   { prototype.max_cycles = std::stoull(cycles_string); }
+    if (threads_string.empty() == false)  { thread_count = std::stoul(threads_string); }
+    if (epoch_string.empty() == false)    { prototype.rtc_epoch = std::stoll(epoch_string); }
+  }
+  catch (const std::exception&)
+  {
+    std::cerr << "[smboy] Invalid batch options. Expected numbers for the '--batch-*' options."
+              << std::endl;
+    return 1;
+  }
+
+  // Blank lines, and lines starting with '#', are skipped.
+  std::vector<smboy::batch_job> jobs;
+  auto hash_directory = smboy::arguments::get("batch-hashes");
+  std::string line;
+  while (std::getline(list, line))
+  {
+    if (line.empty() == true || line[0] == '#') { continue; }
+
+    smboy::batch_job job = prototype;
+    std::size_t tab = line.find('\t');
+    job.program_file = line.substr(0, tab);
+    if (tab != std::string::npos)
+    {
+      job.input_replay = line.substr(tab + 1);
+    }
+
+    if (hash_directory.empty() == false)
+    {
+      job.frame_hash_path = fs::path { hash_directory } /
+        (std::to_string(jobs.size()) + "-" + job.program_file.stem().string() + ".txt");
+    }
+
+    jobs.push_back(job);
+  }
+
+  smboy::batch_runner runner;
+  auto results = runner.run(jobs, thread_count);
+
+  auto output_path = smboy::arguments::get("batch-output");
+  if (output_path.empty() == true)
+  {
+    smboy::batch_runner::write_json(std::cout, jobs, results);
+  }
+  else
+  {
+    std::ofstream file { output_path, std::ios::out | std::ios::trunc };
+    if (file.is_open() == false)
+    {
+      std::cerr << "[smboy] Could not open batch output file '" << output_path << "'." << std::endl;
+      return 1;
+    }
+
+    smboy::batch_runner::write_json(file, jobs, results);
+  }
+
+  // Fail if any job did.
+  for (const auto& result : results)
+  {
+    if (result.status == smboy::batch_status::bs_failed) { return 1; }
+  }
+
+  return 0;
+
+}
+
+void run_emulation_thread (smboy::emulator& emu, std::uint32_t run_ahead)
+{
+  if (run_ahead == 0)
+  {
+    while (emu.is_running() == true)
+    {
+      if (emu.step() == false) { 
+        emu.stop();
+        break; 
+      }
+    }
+
+    return;
+  }
+
+  // With run-ahead, each frame is run twice over. First, the frame which is kept is run with the
+  // latest input, but not drawn. Then, from a snapshot, the frames ahead of it are run
+  // speculatively with that same input, the last of them being drawn, before rolling back to the
+  // snapshot.
+  //
+  // Speculative frames are never captured, so while frames are being captured, the frames which
+  // are kept are drawn as well, for the frame sink.
+  auto& renderer = emu.get_renderer();
   while (emu.is_running() == true)
   {
-    if (emu.step() == false) { 
+    renderer.set_skip_next_frame(renderer.get_frame_sink() == nullptr);
+    if (emu.run_frame() == false)
+    {
+      emu.stop();
+      break;
+    }
+
+    // If the vertical blank function asked to skip the next frame, because the emulation is behind
+    // schedule, don't bother running ahead this time.
+    if (renderer.is_next_frame_skipped() == true) { continue; }
+
+    emu.save_snapshot();
+    emu.set_speculative(true);
+
+    bool result = true;
+    for (std::uint32_t i = 0; i < run_ahead && result == true; ++i)
+    {
+      renderer.set_skip_next_frame(i + 1 < run_ahead);
+      result = emu.run_frame();
+    }
+
+    emu.set_speculative(false);
+    emu.load_snapshot();
+
+    if (result == false)
+    {
       emu.stop();
-      break; 
+      break;
     }
   }
 }
@@ -79,6 +564,12 @@ int main (int argc, char** argv)
     return 1;
   }
 
+  // Batches run many programs, each in an emulator instance of their own, without a window.
+  if (smboy::arguments::has("batch") == true)
+  {
+    return run_batch();
+  }
+
   auto program_file = smboy::arguments::get("program-file", 'p');
   if (program_file.empty() == true)
   {
@@ -86,8 +577,9 @@ int main (int argc, char** argv)
     return 1;
   }
   
-  // Initialize the emulator.
-  auto& emulator = smboy::emulator::get_instance();
+  // Create and initialize the emulator. Instances are large, so keep it on the heap.
+  auto emulator_instance = std::make_unique<smboy::emulator>();
+  auto& emulator = *emulator_instance;
   emulator.initialize();
   
   // Load the program file into the emulator.
@@ -96,50 +588,254 @@ int main (int argc, char** argv)
     return 1;
   }
 
-  // Create the audio stream.
-  AudioStream stream;
+  // Set up the realtime clock.
+  if (parse_realtime_clock(emulator.get_realtime()) == false)
+  {
+    return 1;
+  }
+
+  // Set up the input log and replay, if asked to.
+  bool replaying;
+  if (parse_input(emulator.get_input(), replaying) == false)
+  {
+    return 1;
+  }
+
+  // Determine whether to run a benchmark. Benchmarks always run headless.
+  bool benchmarking;
+  smboy::benchmark_options benchmark_options;
+  std::string benchmark_output;
+  if (parse_benchmark(benchmarking, benchmark_options, benchmark_output) == false)
+  {
+    return 1;
+  }
+
+  // Determine how the emulation should be paced.
+  bool headless = smboy::arguments::has("headless", 'h') || benchmarking;
+  smboy::pacing_mode pacing_mode;
+  double pacing_speed;
+  if (parse_pacing(headless, pacing_mode, pacing_speed) == false)
+  {
+    return 1;
+  }
+
+  // Determine whether, and how, frames should be skipped.
+  std::uint32_t frame_skip;
+  bool auto_frame_skip;
+  if (parse_frame_skip(frame_skip, auto_frame_skip) == false)
+  {
+    return 1;
+  }
+
+  // Determine how many frames to run ahead, if any.
+  std::uint32_t run_ahead;
+  if (parse_run_ahead(run_ahead) == false)
+  {
+    return 1;
+  }
+
+  // Determine the pixel format in which frames should be drawn.
+  smboy::frame_format frame_format;
+  if (parse_frame_format(frame_format) == false)
+  {
+    return 1;
+  }
+
+  // Determine whether frames should be scaled up on the CPU, and how.
+  smboy::frame_scaler scaler;
+  bool use_scaler;
+  if (parse_scaler(scaler, use_scaler) == false)
+  {
+    return 1;
+  }
+
+  // Open the frame capture sink, if asked to.
+  smboy::frame_sink frame_sink;
+  if (parse_capture(frame_sink) == false)
+  {
+    return 1;
+  }
+
+  // Open the audio capture sink, if asked to.
+  smboy::audio_sink audio_sink;
+  if (parse_audio_capture(audio_sink, AudioStream::SAMPLE_RATE) == false)
+  {
+    return 1;
+  }
+
+  // Create the audio stream, unless running headless, or asked not to with `--no-audio`.
+  std::unique_ptr<AudioStream> stream = nullptr;
+  if (headless == false && smboy::arguments::has("no-audio") == false)
+  {
+    stream = std::make_unique<AudioStream>();
+  }
+
+  // Resample the audio output ever so slightly faster or slower, so that the audio stream's ring
+  // settles at its target fill level instead of drifting.
+  static constexpr double audio_fill_target = 0.15;
+  smboy::rate_resampler resampler;
+  resampler.set_fill_target(audio_fill_target);
+
+  // Create the frame pacer. In audio pacing mode, it follows the audio stream's fill level, which
+  // makes the audio device the master clock.
+  smboy::pacer pacer;
+  if (stream != nullptr)
+  {
+    pacer.set_audio_fill_function([&] () { return stream->getRing().get_fill_level(); });
+    pacer.set_audio_fill_target(audio_fill_target);
+  }
     
-  // Get handles to the emulator's renderer and joypad context.
+  // Get handles to the emulator's renderer, input queue and audio context.
   auto& program = emulator.get_program();
   auto& renderer = emulator.get_renderer();
-  auto& joypad = emulator.get_joypad();
+  auto& input = emulator.get_input();
   auto& audio = emulator.get_audio();
 
+  // The UI thread never touches the joypad itself. Key presses are queued for the emulation thread
+  // instead, unless the input is being replayed.
+  auto push_button = [&] (smboy::joypad_button button, bool pressed)
+  {
+    if (replaying == false)
+    {
+      input.push(smboy::input_type::it_button, static_cast<std::uint8_t>(button), pressed);
+    }
+  };
+
+  auto push_dpad = [&] (smboy::joypad_dpad dpad, bool pressed)
+  {
+    if (replaying == false)
+    {
+      input.push(smboy::input_type::it_dpad, static_cast<std::uint8_t>(dpad), pressed);
+    }
+  };
+
+  // In automatic frame skip mode, never skip more than this many frames in a row, so that the
+  // display keeps updating even when the host can't keep up at all.
+  static constexpr std::uint32_t max_auto_skipped_frames = 4;
+  std::uint32_t auto_skipped_frames = 0;
+  renderer.set_frame_skip(frame_skip);
+  renderer.set_frame_format(frame_format);
+
+  // Draw pixels on a render thread of their own, if asked to.
+  renderer.set_render_thread_enabled(smboy::arguments::has("render-thread"));
+
+  // Stream drawn frames to the capture sink, if it's open.
+  if (frame_sink.is_open() == true)
+  {
+    renderer.set_frame_sink(&frame_sink);
+  }
+
   // Keep a count of how many times we hit vblank.
   std::uint32_t vblank_count = 0;
-  renderer.set_vblank_function([&] (smboy::emulator&)
+
+  // The UI thread can't read the performance counters while the emulation thread is counting into
+  // them, so a copy of them is handed over at vblank instead, for the window title.
+  std::mutex title_counters_mutex;
+  smboy::perf_counters title_counters;
+  auto title_counters_time = std::chrono::steady_clock::now();
+  smboy::benchmark benchmark;
+  renderer.set_vblank_function([&] (smboy::emulator& emu)
   {
+    pacer.on_frame(emu.get_processor().get_tick_cycles());
+    if (benchmarking == true)
+    {
+      benchmark.on_frame();
+    }
+
+    // Skip the next frame if we're behind schedule.
+    if (auto_frame_skip == true)
+    {
+      bool skip = pacer.is_behind() && auto_skipped_frames < max_auto_skipped_frames;
+      auto_skipped_frames = (skip == true) ? (auto_skipped_frames + 1) : 0;
+      emu.get_renderer().set_skip_next_frame(skip);
+    }
+
     vblank_count++;
     if (vblank_count % 500 == 0)
     {
       program.save_sram_file();
     }
+
+    if (headless == false && vblank_count % 30 == 0)
+    {
+      std::lock_guard<std::mutex> lock { title_counters_mutex };
+      title_counters = emu.read_counters();
+      title_counters_time = std::chrono::steady_clock::now();
+    }
   });
   
 
-  audio.set_mix_clock(44100.0f);
-  audio.set_mix_function([&] (const smboy::audio_sample& sample)
+  // Take the audio output as band-limited samples, a video frame's worth at a time, if anything
+  // is going to use it. The capture sink gets the samples before they're resampled, so that
+  // captures don't depend on the host's audio device.
+  if (stream != nullptr || audio_sink.is_open() == true)
   {
-    stream.pushSample(sample.left_output, sample.right_output);
-  });
+    audio.set_output_rate(AudioStream::SAMPLE_RATE);
+    audio.set_output_function([&] (const std::int16_t* samples, std::size_t frame_count)
+    {
+      audio_sink.submit(samples, frame_count);
+      if (stream != nullptr)
+      {
+        std::size_t resampled_count = resampler.process(samples, frame_count,
+          stream->getRing().get_fill_level());
+        stream->pushFrames(resampler.get_output(), resampled_count);
+      }
+    });
+  }
+
+  pacer.initialize(pacing_mode, pacing_speed);
+
+  // Dump the performance counters at exit, if asked to with `--stats`.
+  bool dump_stats = smboy::arguments::has("stats");
+  auto start_time = std::chrono::steady_clock::now();
 
-  if (smboy::arguments::has("headless", 'h') == false)
+  int exit_code = 0;
+  if (headless == false)
   {
   
     // Start the emulation thread.
-    std::thread emulation_thread { run_emulation_thread, std::ref(emulator) };
+    std::thread emulation_thread { run_emulation_thread, std::ref(emulator), run_ahead };
 
     // Create the application window and target texture.
     sf::RenderWindow window { { 160 * 4, 144 * 4 }, emulator.get_program().get_title() };
     window.setFramerateLimit(60);
 
-    // Create a texture to contain the contents of the screen buffer.
+    // Held keys only need queueing once.
+    window.setKeyRepeatEnabled(false);
+
+    // Create a texture to contain the contents of the screen buffer. If the frames are scaled up
+    // on the CPU, the texture holds the scaled frames, and is only stretched to fit the window.
     sf::Texture target;
-    target.create(smboy::screen_width, smboy::screen_height);
-    target.setSmooth(true);
+    if (use_scaler == true)
+    {
+      target.create(scaler.get_output_width(), scaler.get_output_height());
+      target.setSmooth(false);
+    }
+    else
+    {
+      target.create(smboy::screen_width, smboy::screen_height);
+      target.setSmooth(true);
+    }
+
+    float sprite_scale_x = static_cast<float>(smboy::screen_width * 4) / target.getSize().x;
+    float sprite_scale_y = static_cast<float>(smboy::screen_height * 4) / target.getSize().y;
+
+    // Keep track of the sequence number of the frame currently shown in the texture. Frames drawn
+    // in a compact format are converted into RGBA here before being uploaded.
+    std::uint64_t displayed_frame = 0;
+    std::vector<std::uint32_t> display_pixels(smboy::screen_buffer_size);
+
+    // Show the pacer's statistics in the window title, updated about once per second.
+    std::uint64_t titled_frame = 0;
+    auto title_time = std::chrono::steady_clock::now();
+
+    // Along with the instruction rate, and how much of the time the processor spent halted, taken
+    // from the performance counters handed over since the last title update.
+    smboy::perf_counters titled_counters;
+    auto titled_counters_time = title_time;
 
     // Start the audio stream.
-    stream.play();
+    if (stream != nullptr) { stream->play(); }
 
     // Loop as long as the window is open and the emulator is running.
     while (window.isOpen() && emulator.is_running())
@@ -157,18 +853,18 @@ int main (int argc, char** argv)
         {
           switch (ev.key.code)
           {
-            case sf::Keyboard::W: joypad.set_dpad(smboy::joypad_dpad::up, true); break;
-            case sf::Keyboard::S: joypad.set_dpad(smboy::joypad_dpad::down, true); break;
-            case sf::Keyboard::A: joypad.set_dpad(smboy::joypad_dpad::left, true); break;
-            case sf::Keyboard::D: joypad.set_dpad(smboy::joypad_dpad::right, true); break;
-            case sf::Keyboard::J: joypad.set_button(smboy::joypad_button::a, true); break;
-            case sf::Keyboard::K: joypad.set_button(smboy::joypad_button::b, true); break;
-            case sf::Keyboard::I: joypad.set_button(smboy::joypad_button::x, true); break;
-            case sf::Keyboard::N: joypad.set_button(smboy::joypad_button::y, true); break;
-            case sf::Keyboard::R: joypad.set_button(smboy::joypad_button::l, true); break;
-            case sf::Keyboard::U: joypad.set_button(smboy::joypad_button::r, true); break;
-            case sf::Keyboard::H: joypad.set_button(smboy::joypad_button::select, true); break;
-            case sf::Keyboard::G: joypad.set_button(smboy::joypad_button::start, true); break;
+            case sf::Keyboard::W: push_dpad(smboy::joypad_dpad::up, true); break;
+            case sf::Keyboard::S: push_dpad(smboy::joypad_dpad::down, true); break;
+            case sf::Keyboard::A: push_dpad(smboy::joypad_dpad::left, true); break;
+            case sf::Keyboard::D: push_dpad(smboy::joypad_dpad::right, true); break;
+            case sf::Keyboard::J: push_button(smboy::joypad_button::a, true); break;
+            case sf::Keyboard::K: push_button(smboy::joypad_button::b, true); break;
+            case sf::Keyboard::I: push_button(smboy::joypad_button::x, true); break;
+            case sf::Keyboard::N: push_button(smboy::joypad_button::y, true); break;
+            case sf::Keyboard::R: push_button(smboy::joypad_button::l, true); break;
+            case sf::Keyboard::U: push_button(smboy::joypad_button::r, true); break;
+            case sf::Keyboard::H: push_button(smboy::joypad_button::select, true); break;
+            case sf::Keyboard::G: push_button(smboy::joypad_button::start, true); break;
             case sf::Keyboard::Escape:        
               emulator.stop();
               window.close();
@@ -181,36 +877,141 @@ int main (int argc, char** argv)
         {
           switch (ev.key.code)
           {
-            case sf::Keyboard::W: joypad.set_dpad(smboy::joypad_dpad::up, false); break;
-            case sf::Keyboard::S: joypad.set_dpad(smboy::joypad_dpad::down, false); break;
-            case sf::Keyboard::A: joypad.set_dpad(smboy::joypad_dpad::left, false); break;
-            case sf::Keyboard::D: joypad.set_dpad(smboy::joypad_dpad::right, false); break;
-            case sf::Keyboard::J: joypad.set_button(smboy::joypad_button::a, false); break;
-            case sf::Keyboard::K: joypad.set_button(smboy::joypad_button::b, false); break;
-            case sf::Keyboard::I: joypad.set_button(smboy::joypad_button::x, false); break;
-            case sf::Keyboard::N: joypad.set_button(smboy::joypad_button::y, false); break;
-            case sf::Keyboard::R: joypad.set_button(smboy::joypad_button::l, false); break;
-            case sf::Keyboard::U: joypad.set_button(smboy::joypad_button::r, false); break;
-            case sf::Keyboard::H: joypad.set_button(smboy::joypad_button::select, false); break;
-            case sf::Keyboard::G: joypad.set_button(smboy::joypad_button::start, false); break;
+            case sf::Keyboard::W: push_dpad(smboy::joypad_dpad::up, false); break;
+            case sf::Keyboard::S: push_dpad(smboy::joypad_dpad::down, false); break;
+            case sf::Keyboard::A: push_dpad(smboy::joypad_dpad::left, false); break;
+            case sf::Keyboard::D: push_dpad(smboy::joypad_dpad::right, false); break;
+            case sf::Keyboard::J: push_button(smboy::joypad_button::a, false); break;
+            case sf::Keyboard::K: push_button(smboy::joypad_button::b, false); break;
+            case sf::Keyboard::I: push_button(smboy::joypad_button::x, false); break;
+            case sf::Keyboard::N: push_button(smboy::joypad_button::y, false); break;
+            case sf::Keyboard::R: push_button(smboy::joypad_button::l, false); break;
+            case sf::Keyboard::U: push_button(smboy::joypad_button::r, false); break;
+            case sf::Keyboard::H: push_button(smboy::joypad_button::select, false); break;
+            case sf::Keyboard::G: push_button(smboy::joypad_button::start, false); break;
             default: break;
           }
         }
       }
 
-      target.update(renderer.get_screen_bytes());
+      // Only upload the screen texture when the renderer has published a new frame since the
+      // last upload.
+      auto& frames = renderer.get_frame_buffer();
+      if (frames.acquire() == true && frames.get_front_sequence() != displayed_frame)
+      {
+        const smboy::frame_data& frame = frames.get_front_frame();
+        const std::uint32_t* pixels = reinterpret_cast<const std::uint32_t*>(frame.pixels);
+        if (frame.format != smboy::frame_format::ff_rgba8888)
+        {
+          smboy::convert_frame_to_rgba(frame, display_pixels.data());
+          pixels = display_pixels.data();
+        }
+
+        if (use_scaler == true)
+        {
+          pixels = scaler.scale(pixels);
+        }
+
+        target.update(reinterpret_cast<const std::uint8_t*>(pixels));
+
+        displayed_frame = frames.get_front_sequence();
+      }
+
+      auto now = std::chrono::steady_clock::now();
+      if (now - title_time >= std::chrono::seconds(1))
+      {
+        smboy::pacer_stats stats = pacer.get_stats();
+        if (stats.frames != titled_frame)
+        {
+          char title[256];
+          int length = std::snprintf(title, sizeof(title), "%s - %.1f FPS, %.2f MHz (%.0f%%)",
+            program.get_title().c_str(), stats.fps, stats.emulated_mhz, stats.speed * 100.0);
+
+          smboy::perf_counters counters;
+          std::chrono::steady_clock::time_point counters_time;
+          {
+            std::lock_guard<std::mutex> lock { title_counters_mutex };
+            counters = title_counters;
+            counters_time = title_counters_time;
+          }
+
+          double counters_seconds =
+            std::chrono::duration<double>(counters_time - titled_counters_time).count();
+          if (counters_seconds > 0.0 && length > 0 &&
+            static_cast<std::size_t>(length) < sizeof(title))
+          {
+            smboy::perf_counters delta = counters - titled_counters;
+            double halted = (delta.cycles > 0) ?
+              static_cast<double>(delta.halted_cycles) / delta.cycles : 0.0;
+            length += std::snprintf(title + length, sizeof(title) - length,
+              " - %.2f MIPS, %.0f%% halted", delta.instructions / counters_seconds / 1000000.0,
+              halted * 100.0);
+            titled_counters = counters;
+            titled_counters_time = counters_time;
+          }
+
+          // Also show how long the CPU scaler has been taking per frame.
+          if (use_scaler == true && length > 0 && static_cast<std::size_t>(length) < sizeof(title))
+          {
+            std::snprintf(title + length, sizeof(title) - length, " - %s/%s %.3f ms",
+              smboy::frame_scaler::get_filter_name(scaler.get_filter()),
+              scaler.get_implementation_name(), scaler.get_average_time() / 1000000.0);
+            scaler.reset_timing();
+          }
+
+          window.setTitle(title);
+          titled_frame = stats.frames;
+        }
+
+        title_time = now;
+      }
+
       sf::Sprite sprite { target };
-      sprite.setScale(4, 4);
+      sprite.setScale(sprite_scale_x, sprite_scale_y);
 
       window.clear();
       window.draw(sprite);
       window.display();
     }
     
-    stream.stop();
+    if (stream != nullptr) { stream->stop(); }
     emulation_thread.join();
+
+    // Report whether the audio output kept up.
+    if (stream != nullptr)
+    {
+      std::cout << "[smboy] Audio: " << stream->getRing().get_underrun_count() << " underruns, "
+                << stream->getRing().get_overrun_count() << " overruns." << std::endl;
+    }
     
   }
+  else if (benchmarking == true)
+  {
+    if (benchmark.run(emulator, benchmark_options) == false)
+    {
+      std::cerr << "[smboy] The emulator stopped before the benchmark was done." << std::endl;
+      exit_code = 1;
+    }
+
+    if (benchmark_output.empty() == true)
+    {
+      benchmark.write_json(std::cout);
+    }
+    else
+    {
+      std::ofstream file { benchmark_output, std::ios::out | std::ios::trunc };
+      if (file.is_open() == false)
+      {
+        std::cerr << "[smboy] Could not open benchmark output file '" << benchmark_output << "'."
+                  << std::endl;
+        exit_code = 1;
+      }
+      else
+      {
+        benchmark.write_json(file);
+      }
+    }
+  }
   else
   {
     std::uint64_t cycle_count = 0;
@@ -224,5 +1025,24 @@ int main (int argc, char** argv)
     } 
   }
 
-  return 0;
+  // Dump the performance counters, with their rates over the whole run. Keep them out of the
+  // benchmark's JSON if it's going to standard output.
+  if (dump_stats == true)
+  {
+    double seconds =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    std::ostream& out = (benchmarking == true && benchmark_output.empty() == true) ?
+      std::cerr : std::cout;
+    smboy::write_perf_counters(out, emulator.read_counters(), seconds);
+  }
+
+  // Write out any frames still waiting in the capture sink.
+  renderer.set_frame_sink(nullptr);
+  frame_sink.close();
+
+  // Likewise, write out any audio still waiting in the audio capture sink.
+  audio.set_output_function(nullptr);
+  audio_sink.close();
+
+  return exit_code;
 }